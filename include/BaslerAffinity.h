@@ -0,0 +1,94 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERAFFINITY_H
+#define BASLERAFFINITY_H
+
+#include <string>
+#include <vector>
+
+#include <pylon/PylonIncludes.h>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Basler
+{
+/*******************************************************************
+ * \class Affinity
+ * \brief cpu affinity and numa helpers
+ *
+ * Cpu lists use the Linux syntax ("0-3,8"). The numa node of a
+ * camera is the one of the network interface it is connected to.
+ * Memory is moved to a node with the mbind system call, without
+ * libnuma. On other systems numa nodes are unknown (-1).
+ *******************************************************************/
+class BASLER_EXPORT Affinity
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "Affinity", "Basler");
+
+ public:
+    typedef std::vector<int> CpuList;
+
+    static void parseCpuList(const std::string& cpus,CpuList& cpu_list);
+    static std::string formatCpuList(const CpuList& cpu_list);
+
+    // calling thread
+    static void setThreadCpus(const CpuList& cpu_list);
+    static void getThreadCpus(CpuList& cpu_list);
+    static long getThreadId();
+
+    static int getInterfaceNumaNode(const std::string& interface_ip);
+    static void getNumaNodeCpus(int node,CpuList& cpu_list);
+    static void bindMemory(void* ptr,size_t size,int node);
+};
+
+/*******************************************************************
+ * \class NumaBufferFactory
+ * \brief Pylon stream buffers allocated on a numa node
+ *******************************************************************/
+class NumaBufferFactory : public Pylon::IBufferFactory
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "NumaBufferFactory", "Basler");
+
+ public:
+    NumaBufferFactory() : m_node(-1) {}
+
+    void setNumaNode(int node) {m_node = node;}
+
+    virtual void AllocateBuffer(size_t buffer_size,void** created_buffer,
+				intptr_t& buffer_context);
+    virtual void FreeBuffer(void* created_buffer,intptr_t buffer_context);
+    virtual void DestroyBufferFactory() {}
+
+ private:
+    int	m_node;
+};
+} // namespace Basler
+} // namespace lima
+
+#endif
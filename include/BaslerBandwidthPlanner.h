@@ -0,0 +1,99 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERBANDWIDTHPLANNER_H
+#define BASLERBANDWIDTHPLANNER_H
+
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+
+namespace lima
+{
+namespace Basler
+{
+class Camera;
+/*******************************************************************
+ * \class BandwidthPlanner
+ * \brief share a GigE link between several cameras
+ *
+ * Computes the inter-packet delay (GevSCPD) and frame transmission
+ * delay (GevSCFTD) of each camera on a link. If the frames of all the
+ * cameras fit back to back in the shortest frame period, each camera
+ * sends its frame as a burst at link speed, staggered with the frame
+ * transmission delay. Otherwise each camera is slowed down with the
+ * inter-packet delay to its share of the link, proportional to its
+ * demand, and the first packets are staggered by one packet slot.
+ *
+ * plan() has no hardware access, apply() reads the camera loads,
+ * runs plan() and sets the delays.
+ *******************************************************************/
+class BASLER_EXPORT BandwidthPlanner
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "BandwidthPlanner", "Basler");
+
+ public:
+    struct CameraLoad
+    {
+      CameraLoad();
+      long long	payload_size;		/* PayloadSize, bytes */
+      int	packet_size;		/* GevSCPSPacketSize, bytes */
+      double	frame_rate;		/* target frame rate, Hz */
+      double	max_throughput;		/* GevSCDMT, bytes/s, 0 if unknown */
+      double	tick_frequency;		/* GevTimestampTickFrequency, Hz */
+    };
+
+    struct CameraPlan
+    {
+      CameraPlan();
+      int	inter_packet_delay;	/* GevSCPD, ticks */
+      int	frame_transmission_delay; /* GevSCFTD, ticks */
+      double	bandwidth;		/* allocated, bytes/s */
+      double	frame_rate;		/* predicted, Hz */
+      double	headroom;		/* unused fraction of the bandwidth, < 0 if overloaded */
+    };
+
+    // link_capacity in bytes/s (125e6 for 1 GbE), reserve: fraction of
+    // the link kept free
+    static void plan(double link_capacity,
+		     const std::vector<CameraLoad>& loads,
+		     std::vector<CameraPlan>& plans,
+		     double& link_headroom,
+		     double reserve = 0.1);
+
+    static void apply(const std::vector<Camera*>& cameras,
+		      double link_capacity,
+		      std::vector<CameraPlan>& plans,
+		      double& link_headroom,
+		      double reserve = 0.1);
+
+    // bytes on the wire for one frame, GVSP leader and trailer included
+    static double getFrameWireSize(const CameraLoad& load);
+};
+} // namespace Basler
+} // namespace lima
+
+#endif
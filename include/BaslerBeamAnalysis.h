@@ -0,0 +1,165 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERBEAMANALYSIS_H
+#define BASLERBEAMANALYSIS_H
+
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+#include "lima/ThreadUtils.h"
+#include "BaslerResultRing.h"
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class BeamAnalysis
+     * \brief beam centroid, widths and projections of each frame
+     *
+     * A pixel weighs its value above the background when this exceeds
+     * the threshold, else nothing. The grab thread sums the weights,
+     * their first and second moments and the row and column projections
+     * with SSE2; large frames are split in bands of rows between the
+     * grab thread and helper threads. The FWHM are measured on the
+     * projections. The results are published in a ResultRing.
+     * Mono and raw bayer 8 to 16 bit frames only.
+     *******************************************************************/
+    class BASLER_EXPORT BeamAnalysis
+    {
+      DEB_CLASS_NAMESPC(DebModCamera,"BeamAnalysis","Basler");
+    public:
+      struct Result
+      {
+	Result();
+	long long	index;		/* in the acquisition, from 0 */
+	int		frame_nb;
+	double		timestamp;	/* s, camera time */
+	bool		valid;		/* false if nothing above threshold */
+	double		intensity;	/* sum of the weights */
+	int		nb_pixels;	/* above threshold */
+	double		centroid_x;	/* pixels, in the frame */
+	double		centroid_y;
+	double		sigma_x;	/* second moments */
+	double		sigma_y;
+	double		sigma_xy;	/* covariance */
+	double		fwhm_x;		/* on the projections */
+	double		fwhm_y;
+	std::vector<float> projection_x; /* column sums over the roi */
+	std::vector<float> projection_y; /* row sums over the roi */
+      };
+
+      BeamAnalysis();
+      ~BeamAnalysis();
+
+      void setBackground(double level);
+      double getBackground() const {return m_background;}
+      // above the background
+      void setThreshold(double threshold);
+      double getThreshold() const {return m_threshold;}
+      // in the frame, an empty roi is the full frame
+      void setRoi(const Roi& roi);
+      void getRoi(Roi& roi) const;
+      // threads sharing a large frame, the grab thread included
+      void setNbThreads(int nb_threads);
+      int getNbThreads() const {return m_nb_threads;}
+      void setRingSize(int nb_results);
+      int getRingSize() const {return m_ring_size;}
+
+      static bool isImageTypeSupported(ImageType type);
+      // new acquisition, the grab thread is idle; the settings
+      // above are used from the next prepare
+      void prepare(ImageType type,const Size& frame_size);
+      // no analysis until the next prepare, the results are kept
+      void deactivate() {m_active = false;}
+      bool isActive() const {return m_active;}
+      // grab thread
+      void process(const void* data,int width,int height,size_t image_size,
+		   int frame_nb,double timestamp);
+
+      void getResults(long long since,std::vector<Result>& results,
+		      long long& next) const;
+      // false if none yet
+      bool getLastResult(Result& result) const;
+      long long getNbResults() const {return m_ring.getNbResults();}
+
+      // full width at half maximum, linear interpolation around the peak
+      static double fwhm(const std::vector<float>& profile);
+    private:
+      class _Worker;
+      friend class _Worker;
+      struct _Moments
+      {
+	void clear();
+	void add(const _Moments& other);
+	double		s;
+	double		sx;
+	double		sxx;
+	double		sy;
+	double		syy;
+	double		sxy;
+	long long	nb_pixels;
+	std::vector<float> projection_x;
+      };
+
+      void _startWorkers(int nb_workers);
+      void _stopWorkers();
+      // job: the last one done
+      void _workerLoop(int band,unsigned long long job);
+      void _processBand(int band,_Moments& moments);
+
+      //- configuration lock, never taken by the grab thread
+      mutable Mutex		m_lock;
+      double			m_background;
+      double			m_threshold;
+      Roi			m_roi;
+      int			m_nb_threads;
+      int			m_ring_size;
+      //- set by prepare, used by the grab thread
+      bool			m_active;
+      ImageType			m_type;
+      Size			m_frame_size;
+      int			m_x0,m_y0,m_width,m_height;
+      float			m_active_background;
+      float			m_active_threshold;
+      int			m_nb_bands;
+      std::vector<_Moments>	m_moments;	/* one per band */
+      ResultRing<Result>	m_ring;
+      //- current frame, shared with the workers
+      Cond			m_cond;
+      const void*		m_data;
+      Result*			m_result;
+      unsigned long long	m_job;
+      int			m_nb_pending;
+      bool			m_quit;
+      std::vector<_Worker*>	m_workers;
+    };
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERBEAMANALYSIS_H
@@ -0,0 +1,67 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERBLOCKID_H
+#define BASLERBLOCKID_H
+
+#include <stdint.h>
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class BlockId
+     * \brief arithmetic on the block ids of the grab results
+     *
+     * GigE Vision 1 block ids have 16 bits and wrap from 65535 to 1,
+     * 0 meaning no block id. GigE Vision 2 and USB ones have 64 bits
+     * and wrap as unsigned integers.
+     *******************************************************************/
+    struct BlockId
+    {
+      // signed distance from one block id to another
+      static int64_t distance(uint64_t from,uint64_t to,int nb_bits)
+      {
+	if(nb_bits == 64)
+	  return int64_t(to - from);
+	int64_t distance = (int64_t(to) - int64_t(from)) % 65535;
+	if(distance > 32767)
+	  distance -= 65535;
+	else if(distance < -32767)
+	  distance += 65535;
+	return distance;
+      }
+      // nb block ids after block_id
+      static uint64_t next(uint64_t block_id,long long nb,int nb_bits)
+      {
+	if(nb_bits == 64)
+	  return block_id + nb;
+	return (block_id - 1 + nb) % 65535 + 1;
+      }
+    };
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERBLOCKID_H
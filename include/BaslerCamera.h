@@ -27,6 +27,9 @@
 
 #include <stdlib.h>
 #include <limits>
+#include <memory>
+#include <vector>
+#include <atomic>
 
 #if defined (__GNUC__) && (__GNUC__ == 3) && defined (__ELF__)
 #   define GENAPI_DECL __attribute__((visibility("default")))
@@ -39,6 +42,13 @@
 
 #include "lima/HwMaxImageSizeCallback.h"
 #include "lima/HwBufferMgr.h"
+#include "BaslerHdrMerge.h"
+#include "BaslerBandwidthPlanner.h"
+#include "BaslerAffinity.h"
+#include "BaslerPreview.h"
+#include "BaslerControlChannel.h"
+#include "BaslerFrameStats.h"
+#include "BaslerBeamAnalysis.h"
 
 
 using namespace Pylon;
@@ -58,6 +68,7 @@ namespace Basler
  * \brief object controlling the basler camera via Pylon driver
  *******************************************************************/
 class VideoCtrlObj;
+class CameraArray;
 class BASLER_EXPORT Camera
 {
     DEB_CLASS_NAMESPC(DebModCamera, "Camera", "Basler");
@@ -87,6 +98,30 @@ class BASLER_EXPORT Camera
         LevelLow=TriggerActivation_LevelLow
     };
 
+    enum SequencerAdvance {
+      AdvanceByFrameCount, AdvanceByLine1,
+    };
+
+    enum VideoGrabStrategy {
+      VideoOneByOne, VideoLatestImageOnly, VideoLatestImages, VideoUpcomingImage,
+    };
+
+    enum MissedFrameMode {
+      MissedIgnore, MissedBlank, MissedMark,
+    };
+
+    enum OverrunPolicy {
+      OverrunStop, OverrunDropNewest, OverrunDecimate, OverrunThrottle,
+    };
+
+    enum ThreadRole {
+      ReceiveThread, GrabThread, ProcessingThread,
+    };
+
+    enum AutoExposureLoopMode {
+      AutoExposureLoopOff, AutoExposureLoopExpTime, AutoExposureLoopExpTimeGain,
+    };
+
     enum TestImageSelector {
       TestImage_Off=TestImageSelector_Off,
       TestImage_1=TestImageSelector_Testimage1,
@@ -98,7 +133,72 @@ class BASLER_EXPORT Camera
       TestImage_7=TestImageSelector_Testimage7,
     };
     
-    Camera(const std::string& camera_id,int packet_size = -1,int received_priority = 0);
+    // Pylon stream grabber statistics since the acquisition start or
+    // the reset, counters are -1 if not available for the camera
+    struct StreamStatistics
+    {
+      StreamStatistics();
+      long long	total_buffers;
+      long long	failed_buffers;
+      long long	buffer_underruns;	/* GigE */
+      long long	total_packets;		/* GigE */
+      long long	lost_packets;		/* GigE, failed packets */
+      long long	resend_requests;	/* GigE */
+      long long	resent_packets;		/* GigE */
+      long long	missed_frames;		/* USB */
+      long long	usb_resyncs;		/* USB, transfer errors */
+      long long	last_failed_buffer_status; /* not reset */
+      double	elapsed;		/* s */
+      // per second
+      double	buffer_rate;
+      double	failed_buffer_rate;
+      double	lost_packet_rate;
+      double	resend_request_rate;
+      double	resent_packet_rate;
+    };
+
+    // slow changing values sampled in the background
+    struct Telemetry
+    {
+      Telemetry();
+      Timestamp	timestamp;		/* of the sampling */
+      double	age;			/* s, when read */
+      double	temperature;		/* 0 if not available */
+      double	frame_rate;		/* ResultingFrameRate, Hz */
+      int	current_throughput;	/* GigE GevSCDCT, bytes/s */
+      int	max_throughput;		/* GigE GevSCDMT, bytes/s */
+      int	bandwidth_assigned;	/* GigE GevSCBWA, bytes/s */
+    };
+
+    // acquisition state published by the grab thread
+    struct AcqState
+    {
+      AcqState();
+      bool	acq_started;
+      Status	status;
+      int	image_number;		/* camera frames received */
+      int	nb_frames;		/* lima frames acquired */
+      double	last_frame_time;	/* host time of the last frame, 0 if none */
+      double	last_frame_age;		/* s, when read, -1 if no frame */
+      int	error_code;		/* last failed grab, -1 on exception, 0 if none */
+    };
+
+    // software auto exposure loop, since the last prepareAcq
+    struct AutoExposureLoopState
+    {
+      AutoExposureLoopState();
+      bool	running;		/* frame stats in this acquisition */
+      bool	converged;		/* last level within the tolerance */
+      double	level;			/* of the percentile, fraction of full scale, -1 if none */
+      double	exp_time;		/* s, last set */
+      double	gain;			/* last set, 0 to 1 */
+      long long	frame_index;		/* frame stats index of the last level, -1 if none */
+      long long	nb_adjustments;
+    };
+
+    // packet_size: 0 keeps the camera setting, PacketSizeAuto negotiates it
+    enum { PacketSizeAuto = -1 };
+    Camera(const std::string& camera_id,int packet_size = 0,int received_priority = 0);
     ~Camera();
 
     void prepareAcq();
@@ -120,6 +220,19 @@ class BASLER_EXPORT Camera
     void setTrigMode(TrigMode  mode);
     void getTrigMode(TrigMode& mode);
 
+    // ExtTrigSingle needs a burst trigger (AcquisitionStart or FrameBurstStart)
+    bool isExtTrigSingleAvailable() const;
+
+    // -- IntTrig variant, frames triggered by the camera periodic signal
+    // generator (PeriodicSignal1), burst_count frames every period
+    bool isTimerTriggerAvailable() const;
+    void setTimerTriggerMode(bool active);
+    void getTimerTriggerMode(bool& active) const;
+    void setTimerTriggerPeriod(double period);
+    void getTimerTriggerPeriod(double& period) const;
+    void setTimerTriggerBurstCount(int nb_frames);
+    void getTimerTriggerBurstCount(int& nb_frames) const;
+
     void setTrigActivation(TrigActivation activation);
     void getTrigActivation(TrigActivation& activation) const;
 
@@ -144,16 +257,22 @@ class BASLER_EXPORT Camera
     void setBin(const Bin&);
     void getBin(Bin&);
 
+    // Exposure/Ready/Fault from the acquisition state without lock, the
+    // WaitForTrigger refinement of the trigger modes asks the camera
+    // (control channel) or the event driven trigger state (locked)
     void getStatus(Camera::Status& status);
 
     // -- Transport Layer
     void setPacketSize(int isize);
     void getPacketSize(int& isize);    
+    void negotiatePacketSize(int& packet_size,bool use_cache = true);
     void setInterPacketDelay(int ipd);
     void getInterPacketDelay(int& ipd);
     void getMaxThroughput(int& ipd);    
     void getCurrentThroughput(int& ipd);
     void getBandwidthAssigned(int& ipd);
+    // GigE link load at the current frame rate, see BandwidthPlanner
+    void getBandwidthLoad(BandwidthPlanner::CameraLoad& load) const;
 
     void setSocketBufferSize(int sbs);
         
@@ -202,31 +321,385 @@ class BASLER_EXPORT Camera
     // -- Pylon buffers statistics
     void getStatisticsTotalBufferCount(long& count);    
     void getStatisticsFailedBufferCount(long& count);
+    // all the statistics read at once
+    void getStreamStatistics(StreamStatistics& stats) const;
+    void resetStreamStatistics();
 
     // -- Pylon test image selectors
     void setTestImageSelector(TestImageSelector sel);
     void getTestImageSelector(TestImageSelector& sel) const;
+
+    // -- event driven software trigger (IntTrigMult)
+    // camera FrameStartWait/ExposureEnd events replace the blocking
+    // WaitForFrameTriggerReady() round trip done for each trigger.
+    bool isSoftTriggerEventAvailable() const;
+    void setSoftTriggerEventMode(bool active);
+    void getSoftTriggerEventMode(bool& active) const;
+    // number of triggers which can be queued while the camera is busy,
+    // they are sent as soon as the camera is ready again
+    void setSoftTriggerQueueSize(int nb_triggers);
+    void getSoftTriggerQueueSize(int& nb_triggers) const;
+    void isReadyForSoftTrigger(bool& ready);
+    // host time between software trigger and exposure start (in seconds),
+    // kept for the last nb_frames (at most 65536) triggers; -1 for the
+    // frames without ExposureEnd event
+    void getSoftTriggerLatency(int frame_nb, double& latency);
+    void getSoftTriggerLatencies(std::vector<double>& latencies);
+
+    // -- sequencer, camera switches between parameter sets at each frame
+    bool isSequencerAvailable() const;
+    void clearSequenceSets();
+    void addSequenceSet(double exp_time,double gain,
+			int offset_x,int offset_y,ImageType type);
+    void getSequenceSet(int set_index,double& exp_time,double& gain,
+			int& offset_x,int& offset_y,ImageType& type) const;
+    void getNbSequenceSets(int& nb_sets) const;
+    void setSequencerAdvance(SequencerAdvance advance);
+    void getSequencerAdvance(SequencerAdvance& advance) const;
+    // AdvanceByFrameCount: number of frames taken with each set
+    void setSequenceSetExecutions(int nb_frames);
+    void getSequenceSetExecutions(int& nb_frames) const;
+    // upload the sets in the camera and enable the sequencer
+    void setSequencerMode(bool active);
+    void getSequencerMode(bool& active) const;
+    // set used for a frame, -1 if unknown
+    void getFrameSequenceSetIndex(int frame_nb,int& set_index) const;
+    void getFrameSequenceSetIndexes(std::vector<int>& set_indexes) const;
+
+    // -- HDR, one Bpp32/Bpp32F frame merged from each group of bracketed exposures
+    void setHdrMode(bool active);
+    void getHdrMode(bool& active) const;
+    // empty: exposure times of the sequence sets
+    void setHdrExposureTimes(const std::vector<double>& exp_times);
+    void getHdrExposureTimes(std::vector<double>& exp_times) const;
+    // 0: full scale of the camera pixel format
+    void setHdrSaturationLevel(double level);
+    void getHdrSaturationLevel(double& level) const;
+
+    // -- shared resources, see ResourcePool
+    // grab with the process grab thread pool instead of a thread per camera
+    void setSharedGrabLoop(bool active);
+    void getSharedGrabLoop(bool& active) const;
+    // max frame buffer memory of this camera (bytes), 0: no quota
+    void setBufferQuota(long long nb_bytes);
+    void getBufferQuota(long long& nb_bytes) const;
+    // since the last acquisition start
+    void getThroughput(double& frame_rate,double& data_rate) const;
+    // cpu time spent by the grab thread on this camera frames
+    void getGrabCpuUsage(double& cpu_time,double& cpu_load) const;
+    // requested Pylon stream buffers, reduced to fit the memory budget
+    void setStreamBufferCount(int nb_buffers);
+    void getStreamBufferCount(int& nb_buffers) const;
+    // frame and stream buffers memory of this camera (bytes)
+    void getMemoryUsage(long long& used,long long& peak) const;
+
+    // -- cpu affinity and numa placement, see Affinity
+    // cpus: Linux cpu list ("0-3,8"), "numa" for the cpus of the camera
+    // numa node, "" no constraint. The receive thread inherits the cpus
+    // when grabbing starts, the grab thread sets them at the first frame,
+    // processing cpus are set on the calling thread so that lima threads
+    // created afterwards inherit them, until restoreThreadCpus().
+    void setThreadCpus(ThreadRole role,const std::string& cpus);
+    void getThreadCpus(ThreadRole role,std::string& cpus) const;
+    // gives back its cpus to the thread which set the processing cpus
+    void restoreThreadCpus();
+    // numa node of the camera network interface, -1 if unknown
+    void setNumaNode(int node);
+    void getNumaNode(int& node) const;
+    // frame and stream buffers moved to the camera numa node
+    void setNumaLocalBuffers(bool active);
+    void getNumaLocalBuffers(bool& active) const;
+    void getAffinityReport(std::string& report) const;
+
+    // -- video path grab strategies (color or forced video mode)
+    // live: VideoOneByOne, VideoLatestImageOnly or VideoLatestImages
+    void setVideoLiveStrategy(VideoGrabStrategy strategy);
+    void getVideoLiveStrategy(VideoGrabStrategy& strategy) const;
+    // queue depth of VideoLatestImages
+    void setVideoLatestImagesDepth(int depth);
+    void getVideoLatestImagesDepth(int& depth) const;
+    // single frame: VideoOneByOne or VideoUpcomingImage (GigE only)
+    void setVideoSnapshotStrategy(VideoGrabStrategy strategy);
+    void getVideoSnapshotStrategy(VideoGrabStrategy& strategy) const;
+    // frames dropped by the strategy since the acquisition start
+    void getNbSkippedFrames(long long& nb_frames) const;
+
+    // -- video lending: the grab result is lent to a video thread which
+    // delivers it to lima, instead of lima copying it on the grab thread
+    void setVideoLendMode(bool active);
+    void getVideoLendMode(bool& active) const;
+    // frames lent at the same time, a frame is dropped if none is free
+    void setVideoLendPoolSize(int nb_handles);
+    void getVideoLendPoolSize(int& nb_handles) const;
+    // since the acquisition start
+    void getNbVideoLendDrops(long long& nb_frames) const;
+
+    // -- missed frames (block id gaps): MissedIgnore skips them,
+    // MissedBlank blanks them on the grab thread, MissedMark blanks them
+    // on a filler thread which also delivers the frames grabbed meanwhile;
+    // blank frames are set in the missed frame bitmap
+    void setMissedFrameMode(MissedFrameMode mode);
+    void getMissedFrameMode(MissedFrameMode& mode) const;
+    // ring of the buffers for continuous acquisition
+    void isFrameMissed(int frame_nb,bool& missed) const;
+    void getMissedFrames(std::vector<int>& frame_nbs) const;
+    // since the acquisition start, bin i of the gap histogram
+    // counts the gaps of [2^i,2^(i+1)) frames
+    void getNbMissedFrames(long long& nb_frames) const;
+    void getMissedFrameGaps(std::vector<long long>& histogram) const;
+    // missed frames never received, late and duplicated frames are dropped
+    void getNbLostFrames(long long& nb_frames) const;
+    void getNbDuplicatedFrames(long long& nb_frames) const;
+    void getNbLateFrames(long long& nb_frames) const;
+    // 16 for GigE Vision 1 block ids, else 64
+    void getBlockIdBits(int& nb_bits) const;
+
+    // -- overrun policy, when lima can't take a frame (buffers full):
+    // OverrunStop stops the acquisition, OverrunDropNewest drops the
+    // frames, OverrunDecimate keeps every nth frame and OverrunThrottle
+    // lowers the camera frame rate until the acquisition stop.
+    // Frames are dropped only during continuous acquisitions.
+    void setOverrunPolicy(OverrunPolicy policy);
+    void getOverrunPolicy(OverrunPolicy& policy) const;
+    void setOverrunDecimation(int nth);
+    void getOverrunDecimation(int& nth) const;
+    // frames without overrun before the policy stops applying
+    void setOverrunRecoveryFrames(int nb_frames);
+    void getOverrunRecoveryFrames(int& nb_frames) const;
+    // since the acquisition start
+    void getOverrunActive(bool& active) const;
+    void getNbOverruns(long long& nb_overruns) const;
+    void getNbOverrunDrops(long long& nb_frames) const;
+
+    // -- telemetry: temperature, frame rate and GigE throughputs read in
+    // one batch by a background thread every period (s), 0 to read them
+    // live. The getters return the cached values, the sampling slows down
+    // while grabbing above grab_rate_limit (Hz, 0 for no limit).
+    void setTelemetryPeriod(double period);
+    void getTelemetryPeriod(double& period) const;
+    void setTelemetryGrabRateLimit(double frame_rate);
+    void getTelemetryGrabRateLimit(double& frame_rate) const;
+    // throws if not sampled yet
+    void getTelemetry(Telemetry& telemetry) const;
+
+    // -- frame statistics: computed on the grab thread for each frame
+    // (acquisition and video, not HDR) and kept in a ring, the settings
+    // are used at the next prepareAcq
+    void setFrameStatsMode(bool active);
+    void getFrameStatsMode(bool& active) const;
+    void setFrameStatsNbBins(int nb_bins);
+    void getFrameStatsNbBins(int& nb_bins) const;
+    // <= 0: full scale of the pixel type
+    void setFrameStatsSaturationLevel(int level);
+    void getFrameStatsSaturationLevel(int& level) const;
+    // in the frame, an empty roi is the full frame
+    void setFrameStatsRoi(const Roi& roi);
+    void getFrameStatsRoi(Roi& roi) const;
+    void setFrameStatsRingSize(int nb_results);
+    void getFrameStatsRingSize(int& nb_results) const;
+    // results from index since still in the ring, pass next to get
+    // the following ones
+    void getFrameStats(long long since,std::vector<FrameStats::Result>& results,
+		       long long& next) const;
+    // throws if none yet
+    void getLastFrameStats(FrameStats::Result& result) const;
+    void getNbFrameStats(long long& nb_results) const;
+
+    // -- beam analysis: centroid, widths and projections of each frame
+    // (acquisition and video, not HDR) above a background and threshold,
+    // kept in a ring, the settings are used at the next prepareAcq
+    void setBeamAnalysisMode(bool active);
+    void getBeamAnalysisMode(bool& active) const;
+    void setBeamBackground(double level);
+    void getBeamBackground(double& level) const;
+    void setBeamThreshold(double threshold);
+    void getBeamThreshold(double& threshold) const;
+    // in the frame, an empty roi is the full frame
+    void setBeamRoi(const Roi& roi);
+    void getBeamRoi(Roi& roi) const;
+    // threads sharing frames of 1M pixels or more, the grab thread included
+    void setBeamNbThreads(int nb_threads);
+    void getBeamNbThreads(int& nb_threads) const;
+    void setBeamRingSize(int nb_results);
+    void getBeamRingSize(int& nb_results) const;
+    void getBeamResults(long long since,std::vector<BeamAnalysis::Result>& results,
+			long long& next) const;
+    // throws if none yet
+    void getLastBeamResult(BeamAnalysis::Result& result) const;
+    void getNbBeamResults(long long& nb_results) const;
+
+    // -- software auto exposure: a control thread brings the level of a
+    // percentile of the frame stats histogram (on the frame stats roi) to
+    // a target fraction of full scale, changing the exposure time then the
+    // gain by at most max_step per adjustment. The grab thread only wakes
+    // it up. The frame stats are computed while the mode is on, the
+    // settings are used at the next prepareAcq.
+    void setAutoExposureLoopMode(AutoExposureLoopMode mode);
+    void getAutoExposureLoopMode(AutoExposureLoopMode& mode) const;
+    // (0,1]
+    void setAutoExposureLoopTarget(double level);
+    void getAutoExposureLoopTarget(double& level) const;
+    // (0,1], 0.5 is the median
+    void setAutoExposureLoopPercentile(double percentile);
+    void getAutoExposureLoopPercentile(double& percentile) const;
+    // relative level error left uncorrected
+    void setAutoExposureLoopTolerance(double tolerance);
+    void getAutoExposureLoopTolerance(double& tolerance) const;
+    // largest exposure factor of one adjustment, > 1
+    void setAutoExposureLoopMaxStep(double factor);
+    void getAutoExposureLoopMaxStep(double& factor) const;
+    // s, 0 for the camera maximum
+    void setAutoExposureLoopMaxExpTime(double exp_time);
+    void getAutoExposureLoopMaxExpTime(double& exp_time) const;
+    // frames ignored after an adjustment, still exposed with the previous one
+    void setAutoExposureLoopSettleFrames(int nb_frames);
+    void getAutoExposureLoopSettleFrames(int& nb_frames) const;
+    void getAutoExposureLoopState(AutoExposureLoopState& state) const;
+
+    // -- acquisition state: lock free, never waits for the grab thread
+    void getAcqState(AcqState& state) const;
+
+    // -- control channel: the GenApi accesses made concurrently (trigger,
+    // status, exposure, gain and monitoring) are serialized by priority
+    void getControlChannelStatistics(ControlChannel::Statistics& stats) const;
+    void resetControlChannelStatistics();
+
+    // -- preview tap: decimated and binned frames during the acquisition
+    // (acquisition buffer path, in video mode all frames go to video)
+    void setPreviewMode(bool active);
+    void getPreviewMode(bool& active) const;
+    // every nth frame
+    void setPreviewDecimation(int nth);
+    void getPreviewDecimation(int& nth) const;
+    // max preview frame rate (Hz), 0: no limit
+    void setPreviewMaxRate(double max_rate);
+    void getPreviewMaxRate(double& max_rate) const;
+    // box filter size
+    void setPreviewBinning(int factor);
+    void getPreviewBinning(int& factor) const;
+    void getPreviewImage(std::vector<char>& data,int& frame_nb,
+			 int& width,int& height,ImageType& type) const;
+    void getNbPreviewFrames(int& nb_frames) const;
+
+    // -- user grab loop: a camera thread around RetrieveResult instead of
+    // the Pylon grab loop thread (not used with the shared grab loop)
+    void setUserGrabLoop(bool active);
+    void getUserGrabLoop(bool& active) const;
+    // SCHED_FIFO priority of the user grab loop thread, 0: normal scheduling
+    void setGrabLoopPriority(int priority);
+    void getGrabLoopPriority(int& priority) const;
+    // since the last acquisition start, latencies in seconds from the
+    // camera timestamp of the results to the grab loop wakeup
+    void getGrabLoopStatistics(double& wakeups_per_frame,
+			       double& mean_latency,double& max_latency) const;
     
  private:
     class _EventHandler;
     friend class _EventHandler;
+    class _GrabLoop;
+    friend class _GrabLoop;
+    class _VideoLender;
+    friend class _VideoLender;
+    class _BlankFiller;
+    friend class _BlankFiller;
+    class _TelemetrySampler;
+    friend class _TelemetrySampler;
+    class _AutoExposureLoop;
+    friend class _AutoExposureLoop;
+    friend class CameraArray;
+    friend class ResourcePool;
+    // frame buffers limited by the camera quota and the ResourcePool
+    class _BufferCtrlObj : public SoftBufferCtrlObj
+    {
+    public:
+      _BufferCtrlObj(Camera& cam) : m_cam(cam) {}
+      virtual void setNbBuffers(int nb_buffers);
+      virtual void getMaxNbBuffers(int& max_nb_buffers);
+    private:
+      Camera& m_cam;
+    };
+    Camera(Camera_t* camera,const std::string& camera_id,
+	   int packet_size,int receive_priority);
+    static IPylonDevice* _createDevice(std::string& camera_id);
+    void _init(int packet_size);
     void _stopAcq(bool);
     void _setStatus(Camera::Status status,bool force);
     void _startAcq();
+    void _setTrigMode(TrigMode mode);
     void _readTrigMode();
+    const char* _getTimerTriggerSource() const;
+    void _setTimerTriggerSource();
+    void _setTimerTriggerPeriod();
+    const char* _getBurstTriggerSelector() const;
+    void _getBurstFrameCountMax(int& max_frame_count) const;
     void _forceVideoMode(bool force);
+    void _enableSoftTriggerEvents(bool active);
+    void _sendSoftTrigger();
+    void _executeSoftTrigger();
+    void _recordSoftTrigger();
+    void _softTriggerReadyEvent();
+    void _exposureEndEvent();
+    void _latchCameraClock();
+    void _uploadSequenceSets();
+    void _enableSequencer(bool active);
+    void _setFrameSequenceSetIndex(int frame_nb,int set_index);
+    void _getCameraImageType(ImageType& type);
+    void _setCameraImageType(ImageType type);
+    void _prepareHdrMerge();
+    bool _retrieveResult();
+    void _accountFrame(size_t nb_bytes,double cpu_time);
+    void _reserveStreamBuffers();
+    EGrabStrategy _getGrabStrategy() const;
+    void _applyGrabThreadCpus();
+    void _updateBufferFactory();
+    void _accountMissedFrames(long long nb_frames);
+    void _accountMisorderedFrame(bool late);
+    void _markMissedFrame(int frame_nb,bool missed);
+    void _readStreamStatistics(StreamStatistics& stats) const;
+    void _readFrameRate(double& frame_rate) const;
+    void _sampleTelemetry(Telemetry& telemetry) const;
+    std::shared_ptr<const Telemetry> _getCachedTelemetry() const;
+    bool _throttleFrameRate();
+    void _restoreFrameRate();
+    double _getGainSpan() const;
+    void _prepareAutoExposureLoop();
+    void _writeExpTime(double exp_time,TrigMode mode);
+    void _setLoopExpTime(double exp_time);
+    void _writeGain(double gain);
+    void _setLoopGain(double gain);
+    void _publishFrame(int error_code);
+    int _getLastFrameNb() const;
+    long long _getLastBlockNb() const;
+    void _resetAcqState();
+
+    // written by one thread at a time (the grab thread while grabbing),
+    // image_number and last_frame_time under the sequence counter;
+    // on its own cache lines so pollers don't share the
+    // lines of the members used by the grab path
+    enum { CACHE_LINE_SIZE = 64 };
+    struct alignas(CACHE_LINE_SIZE) _AcqStateBlock
+    {
+      _AcqStateBlock();
+      alignas(CACHE_LINE_SIZE)
+      std::atomic<unsigned>	sequence;	/* odd while written */
+      std::atomic<int>		image_number;
+      std::atomic<double>	last_frame_time;
+      std::atomic<int>		status;
+      std::atomic<int>		error_code;
+      std::atomic<bool>		acq_started;
+    };
 
     //- lima stuff
-    SoftBufferCtrlObj		m_buffer_ctrl_obj;
+    _BufferCtrlObj		m_buffer_ctrl_obj;
     int                         m_nb_frames;    
-    Camera::Status              m_status;
-    bool			m_acq_started;
-    int                         m_image_number;
+    _AcqStateBlock		m_acq_state;
+    int                         m_image_number; /* grab thread counter */
+    int                         m_nb_grab_results; /* grab thread counter */
     double                      m_exp_time;
     double                      m_latency_time;
     int                         m_socketBufferSize;
     bool                        m_is_usb;
-    bool			m_blank_image_for_missed; /* blank image for missed frames */
+    MissedFrameMode		m_missed_frame_mode;
     //- basler stuff 
     std::string                 m_camera_id;
     std::string                 m_detector_model;
@@ -237,6 +710,9 @@ class BASLER_EXPORT Camera
     PylonAutoInitTerm             auto_init_term_;
     DeviceInfoList_t              devices_;
     Camera_t*                     Camera_;
+    bool			  m_own_camera;
+    CameraArray*		  m_camera_array;
+    int				  m_array_index;
     size_t                        ImageSize_;
     _EventHandler*                m_event_handler;
     Cond                          m_cond;
@@ -247,6 +723,130 @@ class BASLER_EXPORT Camera
     TrigMode			  m_trigger_mode;
     unsigned long long            m_tick_start;
     int                           m_tick_frequency;
+    //- event driven software trigger
+    bool			  m_soft_trigger_event_available;
+    bool			  m_soft_trigger_event_mode;
+    int				  m_soft_trigger_queue_size;
+    Cond			  m_soft_trigger_cond;
+    int				  m_soft_trigger_ready_count; // FrameStartWait events
+    int				  m_soft_trigger_sent;
+    int				  m_soft_trigger_pending;
+    bool			  m_soft_trigger_stopped;
+    struct _SoftTrigger
+    {
+      Timestamp	sent;
+      double	latency;		/* -1 until the ExposureEnd event */
+    };
+    std::vector<_SoftTrigger>	  m_soft_triggers; /* ring by trigger number */
+    double			  m_tick_host_offset; /* s, host time of tick 0 */
+    Timestamp			  m_tick_latch_time; /* unset if not mapped */
+    std::atomic<double>		  m_camera_exp_time; /* s, last written to the camera */
+    //- timer trigger (IntTrig variant)
+    bool			  m_timer_trigger_mode;
+    double			  m_timer_trigger_period;
+    int				  m_timer_trigger_burst_count;
+    //- sequencer
+    struct SequenceSet
+    {
+      double	exp_time;
+      double	gain;
+      int	offset_x;
+      int	offset_y;
+      ImageType	image_type;
+    };
+    std::vector<SequenceSet>	  m_sequence_sets;
+    bool			  m_sequencer_mode;
+    SequencerAdvance		  m_sequencer_advance;
+    int				  m_sequence_set_executions;
+    bool			  m_sequence_chunk_available;
+    std::vector<int>		  m_frame_sequence_set_indexes;
+    //- HDR merge
+    bool			  m_hdr_mode;
+    ImageType			  m_hdr_output_type;
+    std::vector<double>		  m_hdr_exp_times;
+    double			  m_hdr_saturation_level;
+    int				  m_hdr_group_size; /* camera frames per lima frame */
+    HdrMerge			  m_hdr_merge;
+    //- shared resources and accounting
+    bool			  m_shared_grab_loop;
+    long long			  m_buffer_quota;
+    mutable Mutex		  m_accounting_mutex;
+    Timestamp			  m_accounting_start;
+    Timestamp			  m_accounting_last;
+    long long			  m_accounting_nb_frames;
+    long long			  m_accounting_nb_bytes;
+    double			  m_accounting_cpu_time;
+    int				  m_stream_buffer_count;
+    StreamStatistics		  m_stream_statistics_base;
+    Timestamp			  m_stream_statistics_start;
+    //- cpu affinity and numa
+    Affinity::CpuList		  m_thread_cpus[3]; /* per ThreadRole */
+    int				  m_numa_node;
+    bool			  m_numa_local_buffers;
+    NumaBufferFactory		  m_numa_buffer_factory;
+    Affinity::CpuList		  m_grab_thread_cpus; /* applied by the grab thread */
+    bool			  m_grab_thread_cpus_pending;
+    long			  m_grab_thread_id;
+    Affinity::CpuList		  m_caller_thread_cpus; /* before the processing cpus */
+    //- video grab strategies
+    VideoGrabStrategy		  m_video_live_strategy;
+    int				  m_video_latest_images_depth;
+    VideoGrabStrategy		  m_video_snapshot_strategy;
+    long long			  m_nb_skipped_frames;
+    //- preview tap
+    bool			  m_preview_mode;
+    PreviewTap			  m_preview;
+    //- frame statistics
+    bool			  m_frame_stats_mode;
+    FrameStats			  m_frame_stats;
+    //- beam analysis
+    bool			  m_beam_analysis_mode;
+    BeamAnalysis		  m_beam_analysis;
+    //- software auto exposure
+    AutoExposureLoopMode	  m_auto_exposure_loop_mode;
+    double			  m_auto_exposure_loop_target;
+    double			  m_auto_exposure_loop_percentile;
+    double			  m_auto_exposure_loop_tolerance;
+    double			  m_auto_exposure_loop_max_step;
+    double			  m_auto_exposure_loop_max_exp_time;
+    int				  m_auto_exposure_loop_settle_frames;
+    _AutoExposureLoop*		  m_auto_exposure_loop; /* created by prepareAcq */
+    //- video lending
+    bool			  m_video_lend_mode;
+    int				  m_video_lend_pool_size;
+    _VideoLender*		  m_video_lender;
+    long long			  m_nb_video_lend_drops;
+    //- overrun policy
+    OverrunPolicy		  m_overrun_policy;
+    int				  m_overrun_decimation;
+    int				  m_overrun_recovery_frames;
+    std::atomic<bool>		  m_overrun_active; /* checked unlocked per frame */
+    bool			  m_overrun_throttled;
+    int				  m_overrun_frames;
+    long long			  m_nb_overruns;
+    long long			  m_nb_overrun_drops;
+    double			  m_throttle_saved_rate; /* < 0 if not throttled */
+    bool			  m_throttle_saved_enable;
+    //- missed frames
+    _BlankFiller*		  m_blank_filler;
+    std::vector<unsigned long long> m_missed_frame_bitmap;
+    int				  m_missed_frame_bitmap_size;
+    long long			  m_nb_missed_frames;
+    std::vector<long long>	  m_missed_frame_gaps;
+    int				  m_block_id_bits;
+    long long			  m_nb_duplicated_frames;
+    long long			  m_nb_late_frames;
+    //- telemetry sampler
+    std::atomic<double>		  m_telemetry_period; /* read by the sampler */
+    std::atomic<double>		  m_telemetry_grab_rate_limit; /* read by the sampler */
+    _TelemetrySampler*		  m_telemetry_sampler;
+    std::shared_ptr<const Telemetry> m_telemetry; /* atomically swapped */
+    //- GenApi control channel
+    mutable ControlChannel	  m_control;
+    //- user grab loop
+    bool			  m_user_grab_loop;
+    int				  m_grab_loop_priority;
+    _GrabLoop*			  m_grab_loop;
 };
 } // namespace Basler
 } // namespace lima
@@ -0,0 +1,118 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERCAMERAARRAY_H
+#define BASLERCAMERAARRAY_H
+
+#include <string>
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/ThreadUtils.h"
+#include "BaslerCamera.h"
+#include "BaslerFrameSetAligner.h"
+
+namespace lima
+{
+namespace Basler
+{
+/*******************************************************************
+ * \class CameraArray
+ * \brief several cameras grabbed as one aligned stream
+ *
+ * The cameras are attached to a CBaslerUniversalInstantCameraArray
+ * and grabbed by a single thread. Each camera still has its own LIMA
+ * Camera, with its own buffers, to be wrapped in an Interface.
+ * Grabbing starts when all the cameras have been started and frames
+ * are aligned into frame sets by frame counter or hardware timestamp.
+ *******************************************************************/
+class BASLER_EXPORT CameraArray
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "CameraArray", "Basler");
+
+ public:
+    enum AlignMode {
+      AlignByFrameCounter, AlignByTimestamp,
+    };
+
+    CameraArray(const std::vector<std::string>& camera_ids,
+		int packet_size = 0,int receive_priority = 0);
+    ~CameraArray();
+
+    int getNbCameras() const;
+    Camera& getCamera(int camera_index);
+
+    // -- shared trigger configuration, applied to all the cameras
+    void setTrigMode(TrigMode mode);
+    void setExpTime(double exp_time);
+    void setLatTime(double lat_time);
+    void setNbFrames(int nb_frames);
+
+    // -- frame set alignment
+    void setAlignMode(AlignMode mode);
+    void getAlignMode(AlignMode& mode) const;
+    // max timestamp difference (s) between the frames of a set
+    void setAlignTolerance(double tolerance);
+    void getAlignTolerance(double& tolerance) const;
+    // closed sets kept for getFrameSet, from the next acquisition
+    void setFrameSetHistory(int nb_sets);
+    void getFrameSetHistory(int& nb_sets) const;
+
+    void getNbFrameSets(int& nb_sets) const;
+    // camera frame numbers of a set, -1 for a dropped frame
+    void getFrameSet(int set_nb,std::vector<int>& frame_nbs,double& skew) const;
+    void getNbIncompleteFrameSets(int& nb_sets) const;
+    void getNbSkewedFrameSets(int& nb_sets) const;
+    void getMaxSkew(double& skew) const;
+    void getDroppedFrames(std::vector<int>& nb_dropped) const;
+
+ private:
+    class _GrabThread;
+    friend class _GrabThread;
+    friend class Camera;
+
+    void _startCamera(int camera_index);
+    void _stopCamera(int camera_index);
+    void _grabLoop();
+    void _alignFrame(int camera_index,int frame_nb,double timestamp,long long block_nb);
+
+    //- Pylon stuff
+    PylonAutoInitTerm			m_auto_init_term;
+    CBaslerUniversalInstantCameraArray	m_array;
+    std::vector<Camera*>		m_cameras;
+    _GrabThread*			m_grab_thread;
+
+    //- acquisition
+    mutable Mutex			m_mutex;
+    std::vector<bool>			m_started;
+    std::vector<int>			m_nb_grabbed;
+
+    //- alignment
+    FrameSetAligner			m_aligner;
+};
+} // namespace Basler
+} // namespace lima
+
+#endif
@@ -0,0 +1,138 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERCONTROLCHANNEL_H
+#define BASLERCONTROLCHANNEL_H
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+#include "lima/Timestamp.h"
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class ControlChannel
+     * \brief serialized GenApi access of a camera
+     *
+     * Requests run one at a time on the channel thread, the most urgent
+     * first: Critical (software trigger), Normal (client reads and
+     * writes) then Background (telemetry, statistics). A read with the
+     * key of a pending read shares its result, a write replaces the
+     * pending write of the same key: a write function must only set
+     * nodes from the values it captured by copy, the replaced one never
+     * runs and its caller gets the result of the one that ran. Requests
+     * with other effects go through command(). The caller waits for its
+     * request, the exception thrown by the request is rethrown to each
+     * caller.
+     * Requests made from the channel thread itself run at once.
+     *******************************************************************/
+    class BASLER_EXPORT ControlChannel
+    {
+      DEB_CLASS_NAMESPC(DebModCamera,"ControlChannel","Basler");
+    public:
+      enum Priority {Critical, Normal, Background};
+
+      struct Statistics
+      {
+	Statistics();
+	int		queue_depth;
+	int		max_queue_depth;
+	long long	nb_requests;
+	long long	nb_merged;	/* shared reads and replaced writes */
+	double		mean_wait;	/* s, queued to started */
+	double		max_wait;
+	double		critical_max_wait;
+      };
+
+      ControlChannel();
+      ~ControlChannel();
+
+      template<class T>
+      T read(Priority priority,const std::string& key,std::function<T()> function);
+      // node only writes, merged
+      void write(Priority priority,const std::string& key,std::function<void()> function);
+      // never merged
+      void command(Priority priority,std::function<void()> function);
+
+      void getStatistics(Statistics& stats) const;
+      void resetStatistics();
+    private:
+      class _Thread;
+      friend class _Thread;
+      enum _Kind {_Read, _Write, _Command};
+      struct _Request
+      {
+	_Kind			kind;
+	Priority		priority;
+	std::string		key;
+	std::function<void()>	function;
+	std::shared_ptr<void>	result;
+	std::exception_ptr	error;
+	Timestamp		queued;
+	bool			done;
+      };
+      typedef std::shared_ptr<_Request> _RequestPtr;
+
+      _RequestPtr _newRequest(_Kind kind,Priority priority,const std::string& key,
+			      const std::function<void()>& function);
+      // request is the merged one on return
+      void _execute(_RequestPtr& request);
+      void _run();
+
+      mutable Cond			m_cond;
+      std::deque<_RequestPtr>		m_queues[3]; /* per Priority */
+      std::map<std::string,_RequestPtr>	m_pending; /* not started reads and writes */
+      bool				m_quit;
+      long				m_thread_id;
+      Statistics			m_stats;
+      double				m_wait_sum;
+      long long				m_nb_waits;
+      _Thread*				m_thread;
+    };
+
+    template<class T>
+    T ControlChannel::read(Priority priority,const std::string& key,std::function<T()> function)
+    {
+      std::shared_ptr<T> result = std::make_shared<T>();
+      _RequestPtr request = _newRequest(_Read,priority,key,
+					[result,function]() {*result = function();});
+      request->result = result;
+      _execute(request);
+      return *std::static_pointer_cast<T>(request->result);
+    }
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERCONTROLCHANNEL_H
@@ -0,0 +1,121 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERFRAMESETALIGNER_H
+#define BASLERFRAMESETALIGNER_H
+
+#include <map>
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class FrameSetAligner
+     * \brief group the frames of several cameras into frame sets
+     *
+     * Frames are aligned by camera frame counter (block ids since the
+     * first frame), or by timestamp: a frame joins the first open set
+     * within tolerance without a frame of its camera. A set is closed
+     * when complete, or incomplete once every camera missing in it has
+     * delivered a frame of a later set or when more sets than the
+     * history are open. The closed sets are kept in a ring, only the
+     * last history ones can be queried. No locking, the owner
+     * serializes the calls.
+     *******************************************************************/
+    class BASLER_EXPORT FrameSetAligner
+    {
+      DEB_CLASS_NAMESPC(DebModCamera,"FrameSetAligner","Basler");
+    public:
+      enum AlignMode {
+	AlignByFrameCounter, AlignByTimestamp,
+      };
+
+      enum { DEFAULT_FRAME_SET_HISTORY = 1024 };
+
+      struct FrameSet
+      {
+	int			set_nb;
+	std::vector<int>	frame_nbs; /* -1 for a dropped frame */
+	std::vector<double>	timestamps;
+	int			nb_frames;
+	double			skew;
+	bool			complete;
+      };
+
+      FrameSetAligner();
+
+      void setAlignMode(AlignMode mode) {m_align_mode = mode;}
+      AlignMode getAlignMode() const {return m_align_mode;}
+      // max timestamp difference (s) between the frames of a set
+      void setAlignTolerance(double tolerance) {m_align_tolerance = tolerance;}
+      double getAlignTolerance() const {return m_align_tolerance;}
+      // number of closed sets kept, from the next reset
+      void setFrameSetHistory(int nb_sets) {m_history = nb_sets;}
+      int getFrameSetHistory() const {return m_history;}
+
+      // new acquisition
+      void reset(int nb_cameras);
+      // block_nb: block ids since the first frame of the camera,
+      // frame_nb (the lima frame) is used when -1
+      void addFrame(int camera_index,int frame_nb,double timestamp,
+		    long long block_nb = -1);
+      // end of the acquisition, the pending sets are closed incomplete
+      void flush();
+
+      // sets are numbered in the order they are opened
+      int getNbFrameSets() const {return m_nb_frame_sets;}
+      // false if the set is not closed yet or out of the history
+      bool getFrameSet(int set_nb,FrameSet& frame_set) const;
+      int getNbIncompleteFrameSets() const {return m_nb_incomplete_sets;}
+      int getNbSkewedFrameSets() const {return m_nb_skewed_sets;}
+      double getMaxSkew() const {return m_max_skew;}
+      const std::vector<int>& getDroppedFrames() const {return m_nb_dropped;}
+    private:
+      void _closeFrameSet(int set_nb,FrameSet& frame_set);
+      void _flushFrameSets(bool all);
+
+      AlignMode			m_align_mode;
+      double			m_align_tolerance;
+      int			m_history;
+      int			m_nb_cameras;
+      std::map<int,FrameSet>	m_pending_sets;
+      std::vector<FrameSet>	m_frame_sets; /* ring of the closed sets */
+      int			m_nb_frame_sets;
+      std::vector<int>		m_last_set_nbs;
+      std::vector<int>		m_nb_dropped;
+      int			m_next_set_nb;
+      int			m_nb_incomplete_sets;
+      int			m_nb_skewed_sets;
+      double			m_max_skew;
+    };
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERFRAMESETALIGNER_H
@@ -0,0 +1,125 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERFRAMESTATS_H
+#define BASLERFRAMESTATS_H
+
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+#include "lima/ThreadUtils.h"
+#include "BaslerResultRing.h"
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class FrameStats
+     * \brief intensity statistics of each frame, kept in a ring
+     *
+     * The grab thread computes min, max, sum, mean, standard deviation,
+     * saturated pixels and histogram of the frame (or of a roi) row by
+     * row, the reductions with SSE2, then publishes them in a
+     * ResultRing: the grab thread never locks.
+     * Mono and raw bayer 8 to 16 bit frames only.
+     *******************************************************************/
+    class BASLER_EXPORT FrameStats
+    {
+      DEB_CLASS_NAMESPC(DebModCamera,"FrameStats","Basler");
+    public:
+      struct Result
+      {
+	Result();
+	long long	index;		/* in the acquisition, from 0 */
+	int		frame_nb;
+	double		timestamp;	/* s, camera time */
+	int		nb_pixels;
+	double		min;
+	double		max;
+	double		sum;
+	double		mean;
+	double		std;
+	long long	nb_saturated;
+	std::vector<unsigned int> histogram; /* from 0 to full scale */
+      };
+
+      FrameStats();
+
+      // power of 2, at most the number of pixel values
+      void setNbBins(int nb_bins);
+      int getNbBins() const {return m_nb_bins;}
+      // pixels >= level are saturated, <= 0: full scale
+      void setSaturationLevel(int level);
+      int getSaturationLevel() const {return m_saturation_level;}
+      // in the frame, an empty roi is the full frame
+      void setRoi(const Roi& roi);
+      void getRoi(Roi& roi) const;
+      // results kept
+      void setRingSize(int nb_results);
+      int getRingSize() const {return m_ring_size;}
+
+      static bool isImageTypeSupported(ImageType type);
+      // new acquisition, the grab thread is idle; the settings
+      // above are used from the next prepare
+      void prepare(ImageType type);
+      // no stats until the next prepare, the results are kept
+      void deactivate() {m_active = false;}
+      bool isActive() const {return m_active;}
+      // grab thread, image_size checks the buffer holds a frame of type
+      void process(const void* data,int width,int height,size_t image_size,
+		   int frame_nb,double timestamp);
+
+      // results from index since still in the ring, next is the index
+      // to ask for the following ones
+      void getResults(long long since,std::vector<Result>& results,
+		      long long& next) const;
+      // false if none yet
+      bool getLastResult(Result& result) const;
+      long long getNbResults() const {return m_ring.getNbResults();}
+    private:
+      // the histogram size of result gives the number of bins
+      void _compute(const void* data,int width,int height,Result& result);
+
+      //- reader and configuration lock, never taken by the grab thread
+      mutable Mutex		m_lock;
+      int			m_nb_bins;
+      int			m_saturation_level;
+      Roi			m_roi;
+      int			m_ring_size;
+      //- set by prepare, used by the grab thread
+      bool			m_active;
+      ImageType			m_type;
+      int			m_active_saturation_level;
+      Roi			m_active_roi;
+      ResultRing<Result>	m_ring;
+      std::vector<unsigned int>	m_work;		/* partial histograms */
+    };
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERFRAMESTATS_H
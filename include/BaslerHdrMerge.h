@@ -0,0 +1,87 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERHDRMERGE_H
+#define BASLERHDRMERGE_H
+
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class HdrMerge
+     * \brief merge a group of bracketed exposures in one frame
+     *
+     * Each pixel is the sum of its unsaturated values divided by the sum
+     * of the matching exposure times, scaled to the longest exposure.
+     * Pixels saturated in every exposure get the saturation level scaled
+     * by the shortest exposure.
+     *******************************************************************/
+    class BASLER_EXPORT HdrMerge
+    {
+      DEB_CLASS_NAMESPC(DebModCamera,"HdrMerge","Basler");
+    public:
+      HdrMerge();
+
+      // src_type: camera pixel type, dst_type: Bpp32 or Bpp32F
+      // saturation_level <= 0 means full scale of src_type
+      void prepare(ImageType src_type,ImageType dst_type,int nb_pixels,
+		   const std::vector<double>& exp_times,
+		   double saturation_level);
+      int getNbExposures() const {return int(m_exp_times.size());}
+
+      // new group of exposures
+      void reset();
+      void accumulate(int exposure_index,const void* src);
+      void merge(void* dst) const;
+
+      static bool isOutputType(ImageType type)
+      {return type == Bpp32 || type == Bpp32F;}
+    private:
+      template<class T>
+      void _accumulate(const T* src,float exp_time);
+      template<class T>
+      void _merge(T* dst,float max_value,float round_offset) const;
+
+      ImageType			m_src_type;
+      ImageType			m_dst_type;
+      int			m_nb_pixels;
+      std::vector<float>	m_exp_times;
+      float			m_saturation_level;
+      float			m_ref_exp_time;
+      float			m_saturated_value;
+      std::vector<float>	m_sum_values;
+      std::vector<float>	m_sum_exp_times;
+    };
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERHDRMERGE_H
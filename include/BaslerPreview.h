@@ -0,0 +1,112 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERPREVIEW_H
+#define BASLERPREVIEW_H
+
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+#include "lima/SizeUtils.h"
+#include "lima/ThreadUtils.h"
+#include "lima/Timestamp.h"
+
+#include <pylon/PylonIncludes.h>
+#include <pylon/BaslerUniversalInstantCamera.h>
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class PreviewTap
+     * \brief decimated and binned copy of the acquired frames
+     *
+     * The grab thread only decides if a frame is due and hands over a
+     * reference on its grab result; the preview thread bins it (box
+     * filter) into the latest preview image. A frame arriving while the
+     * previous one is still processed is not previewed, so the full
+     * rate path never waits for the preview.
+     *******************************************************************/
+    class BASLER_EXPORT PreviewTap
+    {
+      DEB_CLASS_NAMESPC(DebModCamera,"PreviewTap","Basler");
+    public:
+      PreviewTap();
+      ~PreviewTap();
+
+      // every nth frame, 1: all
+      void setDecimation(int nth);
+      int getDecimation() const {return m_decimation;}
+      // max preview frame rate (Hz), 0: no limit
+      void setMaxRate(double max_rate);
+      double getMaxRate() const {return m_max_rate;}
+      // box filter size, 1: full resolution
+      void setBinning(int factor);
+      int getBinning() const {return m_binning;}
+
+      // new acquisition, to be called before tap()
+      void reset();
+      // grab thread: bins the frame later if it is due
+      void tap(const Pylon::CBaslerUniversalGrabResultPtr& result,
+	       int frame_nb,ImageType type);
+
+      void getImage(std::vector<char>& data,int& frame_nb,
+		    int& width,int& height,ImageType& type) const;
+      void getNbPreviewFrames(int& nb_frames) const;
+
+      static void binImage(const void* src,void* dst,int width,int height,
+			   ImageType type,int factor);
+    private:
+      class _Thread;
+      friend class _Thread;
+      void _process();
+
+      mutable Cond			m_cond;
+      int				m_decimation;
+      double				m_max_rate;
+      int				m_binning;
+      Timestamp				m_last_tap;
+      //- pending frame, one slot
+      Pylon::CBaslerUniversalGrabResultPtr m_result;
+      int				m_result_frame_nb;
+      ImageType				m_result_type;
+      bool				m_busy;
+      bool				m_quit;
+      //- latest preview
+      std::vector<char>			m_image;
+      std::vector<char>			m_work;
+      int				m_frame_nb;
+      int				m_width;
+      int				m_height;
+      ImageType				m_type;
+      int				m_nb_frames;
+      _Thread*				m_thread;
+    };
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERPREVIEW_H
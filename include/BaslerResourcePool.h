@@ -0,0 +1,106 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERRESOURCEPOOL_H
+#define BASLERRESOURCEPOOL_H
+
+#include <map>
+#include <vector>
+
+#include <basler_export.h>
+
+#include "lima/Debug.h"
+#include "lima/ThreadUtils.h"
+
+namespace lima
+{
+namespace Basler
+{
+class Camera;
+/*******************************************************************
+ * \class ResourcePool
+ * \brief resources shared by all the cameras of a process
+ *
+ * - a grab thread pool, sized to the number of cores, serving the
+ *   cameras in shared grab loop mode (see Camera::setSharedGrabLoop)
+ * - a memory budget for the LIMA frame buffers and the Pylon stream
+ *   buffers of all the cameras, each camera can be given a quota for
+ *   its frame buffers (see Camera::setBufferQuota). Buffer counts are
+ *   reduced to fit before failing.
+ *******************************************************************/
+class BASLER_EXPORT ResourcePool
+{
+    DEB_CLASS_NAMESPC(DebModCamera, "ResourcePool", "Basler");
+
+ public:
+    static ResourcePool& getInstance();
+
+    // default: number of online cores
+    void setNbGrabThreads(int nb_threads);
+    void getNbGrabThreads(int& nb_threads) const;
+    void getNbGrabCameras(int& nb_cameras) const;
+
+    // 0: no limit
+    void setBufferMemoryLimit(long long nb_bytes);
+    void getBufferMemoryLimit(long long& nb_bytes) const;
+    void getBufferMemoryUsed(long long& nb_bytes) const;
+    void getBufferMemoryPeak(long long& nb_bytes) const;
+    void resetBufferMemoryPeak();
+
+ private:
+    class _GrabWorker;
+    friend class _GrabWorker;
+    friend class Camera;
+
+    ResourcePool();
+    ~ResourcePool();
+
+    void _addGrabCamera(Camera* cam);
+    void _removeGrabCamera(Camera* cam);
+    struct _MemoryUsage
+    {
+      _MemoryUsage() : frame_buffers(0),stream_buffers(0),peak(0) {}
+      long long used() const {return frame_buffers + stream_buffers;}
+      long long		frame_buffers;
+      long long		stream_buffers;
+      long long		peak;
+    };
+
+    long long _getUsed() const;
+    long long _getBufferMemoryAvailable(Camera* cam,bool stream_buffers) const;
+    void _setBufferMemory(Camera* cam,long long nb_bytes,bool stream_buffers);
+    void _getCameraMemory(Camera* cam,long long& used,long long& peak) const;
+    void _releaseCamera(Camera* cam);
+
+    mutable Cond			m_cond;
+    int					m_nb_grab_threads;
+    std::vector<_GrabWorker*>		m_workers;
+    long long				m_buffer_memory_limit;
+    long long				m_buffer_memory_peak;
+    std::map<Camera*,_MemoryUsage>	m_buffer_memory;
+};
+} // namespace Basler
+} // namespace lima
+
+#endif
@@ -0,0 +1,139 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifndef BASLERRESULTRING_H
+#define BASLERRESULTRING_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace lima
+{
+  namespace Basler
+  {
+    /*******************************************************************
+     * \class ResultRing
+     * \brief per frame results written by one thread, read lock free
+     *
+     * The writer fills the next slot in place (its buffers are
+     * allocated by reset) and publishes it with its index. A reader
+     * copies a slot and keeps it if its index did not change meanwhile.
+     * reset() must not run with readers, the owner serializes them.
+     *******************************************************************/
+    template<class T>
+    class ResultRing
+    {
+    public:
+      ResultRing() : m_nb_slots(0),m_nb_results(0) {}
+
+      // the writer is idle, init(T&) prepares each slot
+      template<class Init>
+      void reset(int nb_slots,Init init)
+      {
+	if(nb_slots != m_nb_slots)
+	  {
+	    m_slots.reset(new _Slot[nb_slots]);
+	    m_nb_slots = nb_slots;
+	  }
+	for(int i = 0;i < m_nb_slots;++i)
+	  {
+	    m_slots[i].index.store(-1,std::memory_order_relaxed);
+	    init(m_slots[i].result);
+	  }
+	m_nb_results.store(0,std::memory_order_release);
+      }
+      int getNbSlots() const {return m_nb_slots;}
+
+      // writer: the slot of the next result, hidden from the readers
+      // until endWrite()
+      T& beginWrite()
+      {
+	_Slot& slot = _slot(m_nb_results.load(std::memory_order_relaxed));
+	slot.index.store(-1,std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	return slot.result;
+      }
+      void endWrite()
+      {
+	long long index = m_nb_results.load(std::memory_order_relaxed);
+	_slot(index).index.store(index,std::memory_order_release);
+	m_nb_results.store(index + 1,std::memory_order_release);
+      }
+
+      long long getNbResults() const
+      {return m_nb_results.load(std::memory_order_acquire);}
+
+      // false if not in the ring or rewritten while copied
+      bool read(long long index,T& result) const
+      {
+	if(!m_nb_slots)
+	  return false;
+	const _Slot& slot = _slot(index);
+	if(slot.index.load(std::memory_order_acquire) != index)
+	  return false;
+	result = slot.result;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.index.load(std::memory_order_relaxed) == index;
+      }
+      // from index since, next is the index to read from next time
+      void read(long long since,std::vector<T>& results,long long& next) const
+      {
+	results.clear();
+	long long nb_results = getNbResults();
+	long long first = since > nb_results - m_nb_slots ?
+	  since : nb_results - m_nb_slots;
+	if(first < 0)
+	  first = 0;
+	if(first < nb_results)
+	  results.reserve(size_t(nb_results - first));
+	T result;
+	for(long long index = first;index < nb_results;++index)
+	  if(read(index,result))
+	    results.push_back(result);
+	next = nb_results;
+      }
+      bool readLast(T& result) const
+      {
+	long long nb_results = getNbResults();
+	return nb_results && read(nb_results - 1,result);
+      }
+    private:
+      struct _Slot
+      {
+	_Slot() : index(-1) {}
+	std::atomic<long long>	index;	/* -1 while written */
+	T			result;
+      };
+      _Slot& _slot(long long index) {return m_slots[index % m_nb_slots];}
+      const _Slot& _slot(long long index) const {return m_slots[index % m_nb_slots];}
+
+      std::unique_ptr<_Slot[]>	m_slots;
+      int			m_nb_slots;
+      std::atomic<long long>	m_nb_results;
+    };
+  } // namespace Basler
+} // namespace lima
+
+#endif // BASLERRESULTRING_H
@@ -0,0 +1,297 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/syscall.h>
+#endif
+
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include "lima/Exceptions.h"
+#include "BaslerAffinity.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+#if defined(__linux__)
+// from numaif.h
+static const int MPOL_PREFERRED = 1;
+static const unsigned MPOL_MF_MOVE = 1 << 1;
+#endif
+
+//---------------------------
+//- Affinity::parseCpuList()
+//---------------------------
+void Affinity::parseCpuList(const std::string& cpus,CpuList& cpu_list)
+{
+  DEB_STATIC_FUNCT();
+  cpu_list.clear();
+  std::istringstream is(cpus);
+  std::string range;
+  while(std::getline(is,range,','))
+    {
+      range.erase(0,range.find_first_not_of(" \t\n"));
+      range.erase(range.find_last_not_of(" \t\n") + 1);
+      if(range.empty())
+	continue;
+      int first,last;
+      char dash;
+      std::istringstream rs(range);
+      if(!(rs >> first))
+	THROW_HW_ERROR(InvalidValue) << "Invalid cpu list: " << cpus;
+      if(rs >> dash)
+	{
+	  if(dash != '-' || !(rs >> last))
+	    THROW_HW_ERROR(InvalidValue) << "Invalid cpu list: " << cpus;
+	}
+      else
+	last = first;
+      if(first < 0 || last < first)
+	THROW_HW_ERROR(InvalidValue) << "Invalid cpu list: " << cpus;
+      for(int cpu = first;cpu <= last;++cpu)
+	cpu_list.push_back(cpu);
+    }
+}
+
+//---------------------------
+//- Affinity::formatCpuList()
+//---------------------------
+std::string Affinity::formatCpuList(const CpuList& cpu_list)
+{
+  std::ostringstream os;
+  for(size_t i = 0;i < cpu_list.size();)
+    {
+      size_t j = i;
+      while(j + 1 < cpu_list.size() && cpu_list[j + 1] == cpu_list[j] + 1)
+	++j;
+      if(i)
+	os << ",";
+      os << cpu_list[i];
+      if(j > i)
+	os << "-" << cpu_list[j];
+      i = j + 1;
+    }
+  return os.str();
+}
+
+//---------------------------
+//- Affinity::setThreadCpus()
+//---------------------------
+void Affinity::setThreadCpus(const CpuList& cpu_list)
+{
+  DEB_STATIC_FUNCT();
+  DEB_PARAM() << DEB_VAR1(formatCpuList(cpu_list));
+  if(cpu_list.empty())
+    return;
+#ifdef WIN32
+  DWORD_PTR mask = 0;
+  for(CpuList::const_iterator i = cpu_list.begin();i != cpu_list.end();++i)
+    if(*i < int(sizeof(mask) * 8))
+      mask |= DWORD_PTR(1) << *i;
+  if(!SetThreadAffinityMask(GetCurrentThread(),mask))
+    THROW_HW_ERROR(Error) << "Can't set thread affinity to " << formatCpuList(cpu_list);
+#else
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for(CpuList::const_iterator i = cpu_list.begin();i != cpu_list.end();++i)
+    if(*i < CPU_SETSIZE)
+      CPU_SET(*i,&cpu_set);
+  int ret = pthread_setaffinity_np(pthread_self(),sizeof(cpu_set),&cpu_set);
+  if(ret)
+    THROW_HW_ERROR(Error) << "Can't set thread affinity to " << formatCpuList(cpu_list)
+			  << ": " << strerror(ret);
+#endif
+}
+
+//---------------------------
+//- Affinity::getThreadCpus()
+//---------------------------
+void Affinity::getThreadCpus(CpuList& cpu_list)
+{
+  cpu_list.clear();
+#ifdef WIN32
+  // read back by setting the process mask, restored right away
+  DWORD_PTR process_mask,system_mask;
+  if(!GetProcessAffinityMask(GetCurrentProcess(),&process_mask,&system_mask))
+    return;
+  DWORD_PTR mask = SetThreadAffinityMask(GetCurrentThread(),process_mask);
+  if(!mask)
+    return;
+  SetThreadAffinityMask(GetCurrentThread(),mask);
+  for(int cpu = 0;cpu < int(sizeof(mask) * 8);++cpu)
+    if(mask & (DWORD_PTR(1) << cpu))
+      cpu_list.push_back(cpu);
+#else
+  cpu_set_t cpu_set;
+  if(pthread_getaffinity_np(pthread_self(),sizeof(cpu_set),&cpu_set))
+    return;
+  for(int cpu = 0;cpu < CPU_SETSIZE;++cpu)
+    if(CPU_ISSET(cpu,&cpu_set))
+      cpu_list.push_back(cpu);
+#endif
+}
+
+//---------------------------
+//- Affinity::getThreadId()
+//---------------------------
+long Affinity::getThreadId()
+{
+#if defined(WIN32)
+  return long(GetCurrentThreadId());
+#elif defined(__linux__)
+  return long(syscall(SYS_gettid));
+#else
+  return long(getpid());
+#endif
+}
+
+//---------------------------
+//- Affinity::getInterfaceNumaNode()
+//- -1 if unknown
+//---------------------------
+int Affinity::getInterfaceNumaNode(const std::string& interface_ip)
+{
+  DEB_STATIC_FUNCT();
+  DEB_PARAM() << DEB_VAR1(interface_ip);
+  int node = -1;
+#if defined(__linux__)
+  struct in_addr address;
+  if(!inet_aton(interface_ip.c_str(),&address))
+    return node;
+
+  std::string if_name;
+  struct ifaddrs *if_addrs;
+  if(getifaddrs(&if_addrs))
+    return node;
+  for(struct ifaddrs *i = if_addrs;i;i = i->ifa_next)
+    {
+      if(!i->ifa_addr || i->ifa_addr->sa_family != AF_INET)
+	continue;
+      if(((struct sockaddr_in*)i->ifa_addr)->sin_addr.s_addr == address.s_addr)
+	{
+	  if_name = i->ifa_name;
+	  break;
+	}
+    }
+  freeifaddrs(if_addrs);
+
+  if(!if_name.empty())
+    {
+      std::ifstream numa_file(("/sys/class/net/" + if_name + "/device/numa_node").c_str());
+      if(!(numa_file >> node))
+	node = -1;
+    }
+  DEB_TRACE() << DEB_VAR1(if_name);
+#endif
+  DEB_RETURN() << DEB_VAR1(node);
+  return node;
+}
+
+//---------------------------
+//- Affinity::getNumaNodeCpus()
+//---------------------------
+void Affinity::getNumaNodeCpus(int node,CpuList& cpu_list)
+{
+  DEB_STATIC_FUNCT();
+  DEB_PARAM() << DEB_VAR1(node);
+  cpu_list.clear();
+#if defined(__linux__)
+  std::ostringstream path;
+  path << "/sys/devices/system/node/node" << node << "/cpulist";
+  std::ifstream cpu_file(path.str().c_str());
+  std::string cpus;
+  if(node >= 0 && std::getline(cpu_file,cpus))
+    parseCpuList(cpus,cpu_list);
+#endif
+  if(cpu_list.empty())
+    THROW_HW_ERROR(Error) << "Unknown cpus of numa node " << node;
+}
+
+//---------------------------
+//- Affinity::bindMemory()
+//- moves the pages of the range to the node, best effort
+//---------------------------
+void Affinity::bindMemory(void* ptr,size_t size,int node)
+{
+  DEB_STATIC_FUNCT();
+#if defined(__linux__)
+  if(node < 0 || !ptr || !size)
+    return;
+  long page_size = sysconf(_SC_PAGESIZE);
+  unsigned long start = (unsigned long)ptr & ~(page_size - 1);
+  unsigned long len = (unsigned long)ptr + size - start;
+  unsigned long node_mask[4] = {0,0,0,0};
+  int bits = sizeof(unsigned long) * 8;
+  if(node >= int(sizeof(node_mask) * 8))
+    return;
+  node_mask[node / bits] = 1UL << (node % bits);
+  if(syscall(SYS_mbind,start,len,MPOL_PREFERRED,node_mask,
+	     sizeof(node_mask) * 8,MPOL_MF_MOVE))
+    DEB_WARNING() << "Can't bind memory to numa node " << node << ": " << strerror(errno);
+#endif
+}
+
+//---------------------------
+//- NumaBufferFactory::AllocateBuffer()
+//---------------------------
+void NumaBufferFactory::AllocateBuffer(size_t buffer_size,void** created_buffer,
+				       intptr_t& buffer_context)
+{
+  DEB_MEMBER_FUNCT();
+  void* buffer = NULL;
+#ifdef WIN32
+  buffer = _aligned_malloc(buffer_size,4096);
+#else
+  if(posix_memalign(&buffer,4096,buffer_size))
+    buffer = NULL;
+#endif
+  if(!buffer)
+    throw RUNTIME_EXCEPTION("Can't allocate stream buffer");
+  // policy set before the first touch
+  Affinity::bindMemory(buffer,buffer_size,m_node);
+  *created_buffer = buffer;
+  buffer_context = 0;
+}
+
+//---------------------------
+//- NumaBufferFactory::FreeBuffer()
+//---------------------------
+void NumaBufferFactory::FreeBuffer(void* created_buffer,intptr_t)
+{
+#ifdef WIN32
+  _aligned_free(created_buffer);
+#else
+  free(created_buffer);
+#endif
+}
@@ -0,0 +1,175 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <algorithm>
+#include <cmath>
+#include "lima/Exceptions.h"
+#include "BaslerBandwidthPlanner.h"
+#include "BaslerCamera.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+// GevSCPSPacketSize includes the IP, UDP and GVSP headers
+static const int IP_UDP_GVSP_HEADER_SIZE = 36;
+// preamble + inter frame gap + ethernet header + FCS
+static const int ETHERNET_OVERHEAD = 38;
+// GVSP leader or trailer packet
+static const int GVSP_SMALL_PACKET_SIZE = 64;
+
+BandwidthPlanner::CameraLoad::CameraLoad() :
+  payload_size(0),
+  packet_size(1500),
+  frame_rate(0.),
+  max_throughput(0.),
+  tick_frequency(125e6)
+{
+}
+
+BandwidthPlanner::CameraPlan::CameraPlan() :
+  inter_packet_delay(0),
+  frame_transmission_delay(0),
+  bandwidth(0.),
+  frame_rate(0.),
+  headroom(0.)
+{
+}
+
+//---------------------------
+//- BandwidthPlanner::getFrameWireSize()
+//---------------------------
+double BandwidthPlanner::getFrameWireSize(const CameraLoad& load)
+{
+  int packet_payload = load.packet_size - IP_UDP_GVSP_HEADER_SIZE;
+  if(packet_payload <= 0)
+    return 0.;
+  long long nb_packets = (load.payload_size + packet_payload - 1) / packet_payload;
+  return double(nb_packets) * (load.packet_size + ETHERNET_OVERHEAD) +
+    2. * (GVSP_SMALL_PACKET_SIZE + ETHERNET_OVERHEAD);
+}
+
+//---------------------------
+//- BandwidthPlanner::plan()
+//---------------------------
+void BandwidthPlanner::plan(double link_capacity,
+			    const std::vector<CameraLoad>& loads,
+			    std::vector<CameraPlan>& plans,
+			    double& link_headroom,
+			    double reserve)
+{
+  DEB_STATIC_FUNCT();
+  DEB_PARAM() << DEB_VAR3(link_capacity,loads.size(),reserve);
+
+  if(link_capacity <= 0.)
+    THROW_HW_ERROR(InvalidValue) << "Link capacity must be > 0";
+  if(reserve < 0. || reserve >= 1.)
+    THROW_HW_ERROR(InvalidValue) << "Link reserve must be in range [0,1[";
+
+  size_t nb_cameras = loads.size();
+  plans.assign(nb_cameras,CameraPlan());
+
+  // demand of each camera at its target frame rate, capped by the device
+  std::vector<double> wire_sizes(nb_cameras);
+  std::vector<double> frame_rates(nb_cameras);
+  double total_demand = 0.,total_wire_size = 0.,min_period = 0.;
+  for(size_t i = 0;i < nb_cameras;++i)
+    {
+      const CameraLoad& load = loads[i];
+      if(load.packet_size <= IP_UDP_GVSP_HEADER_SIZE)
+	THROW_HW_ERROR(InvalidValue) << "Camera " << i << ": invalid packet size " << load.packet_size;
+      wire_sizes[i] = getFrameWireSize(load);
+      frame_rates[i] = load.frame_rate;
+      if(load.max_throughput > 0. && load.payload_size > 0)
+	frame_rates[i] = std::min(frame_rates[i],load.max_throughput / load.payload_size);
+      total_demand += wire_sizes[i] * frame_rates[i];
+      total_wire_size += wire_sizes[i];
+      if(frame_rates[i] > 0.)
+	{
+	  double period = 1. / frame_rates[i];
+	  min_period = min_period > 0. ? std::min(min_period,period) : period;
+	}
+    }
+
+  double usable = link_capacity * (1. - reserve);
+  link_headroom = 1. - total_demand / link_capacity;
+  double scale = total_demand > usable ? usable / total_demand : 1.;
+  double total_burst_time = total_wire_size / usable;
+  bool staggered = total_demand <= usable && min_period > 0. && total_burst_time <= min_period;
+  DEB_TRACE() << DEB_VAR4(total_demand,usable,total_burst_time,staggered);
+
+  double burst_start = 0.;
+  for(size_t i = 0;i < nb_cameras;++i)
+    {
+      const CameraLoad& load = loads[i];
+      CameraPlan& aPlan = plans[i];
+      double demand = wire_sizes[i] * frame_rates[i];
+      double packet_wire_size = load.packet_size + ETHERNET_OVERHEAD;
+
+      // share of the link: its slot of the burst cycle or its share of the demand
+      if(staggered)
+	aPlan.bandwidth = total_wire_size > 0. ? usable * wire_sizes[i] / total_wire_size : 0.;
+      else
+	aPlan.bandwidth = total_demand > 0. ? usable * demand / total_demand : usable / nb_cameras;
+      aPlan.frame_rate = frame_rates[i] * scale;
+      aPlan.headroom = aPlan.bandwidth > 0. ? 1. - demand / aPlan.bandwidth : 0.;
+
+      // packet period at the sending rate minus the time on the wire,
+      // bursts are sent at the usable link rate
+      double rate = staggered ? usable : aPlan.bandwidth;
+      double delay = rate > 0. ? packet_wire_size / rate - packet_wire_size / link_capacity : 0.;
+      aPlan.inter_packet_delay = int(std::max(delay,0.) * load.tick_frequency + .5);
+
+      double start = staggered ? burst_start : i * packet_wire_size / link_capacity;
+      aPlan.frame_transmission_delay = int(start * load.tick_frequency + .5);
+      burst_start += wire_sizes[i] / usable;
+
+      DEB_TRACE() << "Camera " << i << ": "
+		  << DEB_VAR4(aPlan.inter_packet_delay,aPlan.frame_transmission_delay,
+			      aPlan.frame_rate,aPlan.headroom);
+    }
+}
+
+//---------------------------
+//- BandwidthPlanner::apply()
+//---------------------------
+void BandwidthPlanner::apply(const std::vector<Camera*>& cameras,
+			     double link_capacity,
+			     std::vector<CameraPlan>& plans,
+			     double& link_headroom,
+			     double reserve)
+{
+  DEB_STATIC_FUNCT();
+
+  std::vector<CameraLoad> loads(cameras.size());
+  for(size_t i = 0;i < cameras.size();++i)
+    cameras[i]->getBandwidthLoad(loads[i]);
+
+  plan(link_capacity,loads,plans,link_headroom,reserve);
+
+  for(size_t i = 0;i < cameras.size();++i)
+    {
+      cameras[i]->setInterPacketDelay(plans[i].inter_packet_delay);
+      cameras[i]->setFrameTransmissionDelay(plans[i].frame_transmission_delay);
+    }
+}
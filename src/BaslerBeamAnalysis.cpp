@@ -0,0 +1,581 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "lima/Exceptions.h"
+#include "BaslerBeamAnalysis.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static const int RING_SIZE_DEFAULT = 1000;
+static const int NB_THREADS_MAX = 16;
+// smaller frames are not worth waking the helper threads
+static const long long PARALLEL_MIN_PIXELS = 1 << 20;
+// pixels summed in float with positions relative to the chunk start
+static const int ROW_CHUNK = 256;
+
+//---------------------------
+//- BeamAnalysis::_Worker
+//---------------------------
+class BeamAnalysis::_Worker : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera,"BeamAnalysis","_Worker");
+public:
+  _Worker(BeamAnalysis& ba,int band,unsigned long long job) :
+    m_ba(ba),m_band(band),m_job(job) {}
+  virtual ~_Worker() {join();}
+protected:
+  virtual void threadFunction() {m_ba._workerLoop(m_band,m_job);}
+private:
+  BeamAnalysis&		m_ba;
+  int			m_band;
+  unsigned long long	m_job;
+};
+
+// weight sums of a row, positions from the roi left edge
+struct _RowSums
+{
+  _RowSums() : s(0.),sx(0.),sxx(0.),nb_pixels(0) {}
+  double	s;
+  double	sx;
+  double	sxx;
+  long long	nb_pixels;
+};
+
+template<class T>
+static void _row_scalar(const T* p,int begin,int end,float background,
+			float threshold,float* projection,_RowSums& sums)
+{
+  for(int i = begin;i < end;++i)
+    {
+      float v = float(p[i]) - background;
+      if(v <= threshold)
+	continue;
+      projection[i] += v;
+      sums.s += v;
+      sums.sx += double(v) * i;
+      sums.sxx += double(v) * i * i;
+      ++sums.nb_pixels;
+    }
+}
+
+#ifdef __SSE2__
+static inline __m128 _load4(const uint8_t* p)
+{
+  int32_t v;
+  memcpy(&v,p,sizeof(v));
+  const __m128i zero = _mm_setzero_si128();
+  __m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v),zero);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(x,zero));
+}
+
+static inline __m128 _load4(const uint16_t* p)
+{
+  __m128i x = _mm_loadl_epi64((const __m128i*)p);
+  return _mm_cvtepi32_ps(_mm_unpacklo_epi16(x,_mm_setzero_si128()));
+}
+
+//---------------------------
+// 4 pixels at a time, masked weights; the float sums of a chunk are
+// moved to the row origin in double
+//---------------------------
+template<class T>
+static void _row_weights(const T* p,int n,float background,float threshold,
+			 float* projection,_RowSums& sums)
+{
+  const __m128 vbackground = _mm_set1_ps(background);
+  const __m128 vthreshold = _mm_set1_ps(threshold);
+  const __m128 step = _mm_set1_ps(4.f);
+  int i = 0;
+  while(i + 4 <= n)
+    {
+      int start = i;
+      int end = i + (std::min(n - i,ROW_CHUNK) & ~3);
+      __m128 x = _mm_setr_ps(0.f,1.f,2.f,3.f);
+      __m128 vs = _mm_setzero_ps();
+      __m128 vsx = _mm_setzero_ps();
+      __m128 vsxx = _mm_setzero_ps();
+      __m128i vnb = _mm_setzero_si128();
+      for(;i < end;i += 4)
+	{
+	  __m128 v = _mm_sub_ps(_load4(p + i),vbackground);
+	  __m128 mask = _mm_cmpgt_ps(v,vthreshold);
+	  __m128 w = _mm_and_ps(v,mask);
+	  _mm_storeu_ps(projection + i,_mm_add_ps(_mm_loadu_ps(projection + i),w));
+	  __m128 wx = _mm_mul_ps(w,x);
+	  vs = _mm_add_ps(vs,w);
+	  vsx = _mm_add_ps(vsx,wx);
+	  vsxx = _mm_add_ps(vsxx,_mm_mul_ps(wx,x));
+	  vnb = _mm_sub_epi32(vnb,_mm_castps_si128(mask));
+	  x = _mm_add_ps(x,step);
+	}
+      float s[4],sx[4],sxx[4];
+      int32_t nb[4];
+      _mm_storeu_ps(s,vs);
+      _mm_storeu_ps(sx,vsx);
+      _mm_storeu_ps(sxx,vsxx);
+      _mm_storeu_si128((__m128i*)nb,vnb);
+      double cs = double(s[0]) + s[1] + s[2] + s[3];
+      double csx = double(sx[0]) + sx[1] + sx[2] + sx[3];
+      double csxx = double(sxx[0]) + sxx[1] + sxx[2] + sxx[3];
+      double origin = start;
+      sums.s += cs;
+      sums.sx += csx + origin * cs;
+      sums.sxx += csxx + 2. * origin * csx + origin * origin * cs;
+      sums.nb_pixels += nb[0] + nb[1] + nb[2] + nb[3];
+    }
+  _row_scalar(p,i,n,background,threshold,projection,sums);
+}
+#else
+template<class T>
+static void _row_weights(const T* p,int n,float background,float threshold,
+			 float* projection,_RowSums& sums)
+{
+  _row_scalar(p,0,n,background,threshold,projection,sums);
+}
+#endif
+
+//---------------------------
+//- BeamAnalysis::Result
+//---------------------------
+BeamAnalysis::Result::Result() :
+  index(-1),
+  frame_nb(-1),
+  timestamp(0.),
+  valid(false),
+  intensity(0.),
+  nb_pixels(0),
+  centroid_x(0.),
+  centroid_y(0.),
+  sigma_x(0.),
+  sigma_y(0.),
+  sigma_xy(0.),
+  fwhm_x(0.),
+  fwhm_y(0.)
+{
+}
+
+void BeamAnalysis::_Moments::clear()
+{
+  s = sx = sxx = sy = syy = sxy = 0.;
+  nb_pixels = 0;
+  std::fill(projection_x.begin(),projection_x.end(),0.f);
+}
+
+void BeamAnalysis::_Moments::add(const _Moments& other)
+{
+  s += other.s;
+  sx += other.sx;
+  sxx += other.sxx;
+  sy += other.sy;
+  syy += other.syy;
+  sxy += other.sxy;
+  nb_pixels += other.nb_pixels;
+  for(size_t i = 0;i < projection_x.size();++i)
+    projection_x[i] += other.projection_x[i];
+}
+
+//---------------------------
+//- BeamAnalysis::BeamAnalysis()
+//---------------------------
+BeamAnalysis::BeamAnalysis() :
+  m_background(0.),
+  m_threshold(0.),
+  m_nb_threads(1),
+  m_ring_size(RING_SIZE_DEFAULT),
+  m_active(false),
+  m_type(Bpp8),
+  m_x0(0),m_y0(0),m_width(0),m_height(0),
+  m_active_background(0.f),
+  m_active_threshold(0.f),
+  m_nb_bands(1),
+  m_data(NULL),
+  m_result(NULL),
+  m_job(0),
+  m_nb_pending(0),
+  m_quit(false)
+{
+  DEB_CONSTRUCTOR();
+}
+
+//---------------------------
+//- BeamAnalysis::~BeamAnalysis()
+//---------------------------
+BeamAnalysis::~BeamAnalysis()
+{
+  DEB_DESTRUCTOR();
+  _stopWorkers();
+}
+
+//---------------------------
+//- BeamAnalysis::setBackground()
+//---------------------------
+void BeamAnalysis::setBackground(double level)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(level);
+  AutoMutex aLock(m_lock);
+  m_background = level;
+}
+
+//---------------------------
+//- BeamAnalysis::setThreshold()
+//---------------------------
+void BeamAnalysis::setThreshold(double threshold)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(threshold);
+  if(threshold < 0.)
+    THROW_HW_ERROR(InvalidValue) << "Beam threshold must be >= 0";
+  AutoMutex aLock(m_lock);
+  m_threshold = threshold;
+}
+
+//---------------------------
+//- BeamAnalysis::setRoi()
+//---------------------------
+void BeamAnalysis::setRoi(const Roi& roi)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(roi);
+  AutoMutex aLock(m_lock);
+  m_roi = roi;
+}
+
+//---------------------------
+//- BeamAnalysis::getRoi()
+//---------------------------
+void BeamAnalysis::getRoi(Roi& roi) const
+{
+  AutoMutex aLock(m_lock);
+  roi = m_roi;
+}
+
+//---------------------------
+//- BeamAnalysis::setNbThreads()
+//---------------------------
+void BeamAnalysis::setNbThreads(int nb_threads)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nb_threads);
+  if(nb_threads < 1 || nb_threads > NB_THREADS_MAX)
+    THROW_HW_ERROR(InvalidValue) << "Beam analysis threads must be in range [1,"
+				 << NB_THREADS_MAX << "]";
+  AutoMutex aLock(m_lock);
+  m_nb_threads = nb_threads;
+}
+
+//---------------------------
+//- BeamAnalysis::setRingSize()
+//---------------------------
+void BeamAnalysis::setRingSize(int nb_results)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nb_results);
+  if(nb_results < 1)
+    THROW_HW_ERROR(InvalidValue) << "Beam analysis ring size must be >= 1";
+  AutoMutex aLock(m_lock);
+  m_ring_size = nb_results;
+}
+
+//---------------------------
+//- BeamAnalysis::isImageTypeSupported()
+//---------------------------
+bool BeamAnalysis::isImageTypeSupported(ImageType type)
+{
+  return type == Bpp8 || type == Bpp10 || type == Bpp12 || type == Bpp16;
+}
+
+//---------------------------
+//- BeamAnalysis::prepare()
+//---------------------------
+void BeamAnalysis::prepare(ImageType type,const Size& frame_size)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR2(type,frame_size);
+  AutoMutex aLock(m_lock);
+  m_active = false;
+  if(!isImageTypeSupported(type))
+    {
+      DEB_WARNING() << "No beam analysis for image type " << type;
+      return;
+    }
+
+  int width = frame_size.getWidth(),height = frame_size.getHeight();
+  m_x0 = m_y0 = 0;
+  m_width = width;
+  m_height = height;
+  if(m_roi.isActive() && !m_roi.isEmpty())
+    {
+      Point top_left = m_roi.getTopLeft();
+      Size size = m_roi.getSize();
+      m_x0 = std::min(std::max(top_left.x,0),width);
+      m_y0 = std::min(std::max(top_left.y,0),height);
+      m_width = std::max(std::min(top_left.x + size.getWidth(),width) - m_x0,0);
+      m_height = std::max(std::min(top_left.y + size.getHeight(),height) - m_y0,0);
+    }
+  if(!m_width || !m_height)
+    {
+      DEB_WARNING() << "Beam analysis roi out of the frame";
+      return;
+    }
+
+  m_type = type;
+  m_frame_size = frame_size;
+  m_active_background = float(m_background);
+  m_active_threshold = float(m_threshold);
+
+  long long nb_pixels = (long long)m_width * m_height;
+  int nb_bands = nb_pixels >= PARALLEL_MIN_PIXELS ?
+    std::min(m_nb_threads,m_height) : 1;
+  if(nb_bands != m_nb_bands)
+    {
+      _stopWorkers();
+      m_nb_bands = nb_bands;
+      _startWorkers(nb_bands - 1);
+    }
+  m_moments.resize(m_nb_bands);
+  for(size_t i = 0;i < m_moments.size();++i)
+    m_moments[i].projection_x.assign(m_width,0.f);
+
+  int w = m_width,h = m_height;
+  m_ring.reset(m_ring_size,[w,h](Result& result) {
+      result.projection_x.assign(w,0.f);
+      result.projection_y.assign(h,0.f);
+    });
+  m_active = true;
+  DEB_TRACE() << DEB_VAR5(m_x0,m_y0,m_width,m_height,m_nb_bands);
+}
+
+//---------------------------
+//- BeamAnalysis::_startWorkers()
+//---------------------------
+void BeamAnalysis::_startWorkers(int nb_workers)
+{
+  DEB_MEMBER_FUNCT();
+  // no frame is processed, a new worker waits for the next job
+  for(int band = 1;band <= nb_workers;++band)
+    {
+      _Worker* worker = new _Worker(*this,band,m_job);
+      m_workers.push_back(worker);
+      worker->start();
+    }
+}
+
+//---------------------------
+//- BeamAnalysis::_stopWorkers()
+//---------------------------
+void BeamAnalysis::_stopWorkers()
+{
+  DEB_MEMBER_FUNCT();
+  {
+    AutoMutex aLock(m_cond.mutex());
+    m_quit = true;
+    m_cond.broadcast();
+  }
+  for(size_t i = 0;i < m_workers.size();++i)
+    delete m_workers[i];
+  m_workers.clear();
+  AutoMutex aLock(m_cond.mutex());
+  m_quit = false;
+}
+
+//---------------------------
+//- BeamAnalysis::_workerLoop()
+//---------------------------
+void BeamAnalysis::_workerLoop(int band,unsigned long long job)
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  while(!m_quit)
+    {
+      if(m_job == job)
+	{
+	  m_cond.wait();
+	  continue;
+	}
+      job = m_job;
+      {
+	AutoMutexUnlock aUnlock(aLock);
+	_processBand(band,m_moments[band]);
+      }
+      if(!--m_nb_pending)
+	m_cond.broadcast();
+    }
+}
+
+//---------------------------
+//- BeamAnalysis::_processBand()
+//---------------------------
+void BeamAnalysis::_processBand(int band,_Moments& moments)
+{
+  moments.clear();
+  int nb_rows = (m_height + m_nb_bands - 1) / m_nb_bands;
+  int y_begin = band * nb_rows;
+  int y_end = std::min(m_height,y_begin + nb_rows);
+  size_t frame_width = m_frame_size.getWidth();
+  std::vector<float>& projection_y = m_result->projection_y;
+  for(int y = y_begin;y < y_end;++y)
+    {
+      _RowSums sums;
+      size_t offset = size_t(y + m_y0) * frame_width + m_x0;
+      if(m_type == Bpp8)
+	_row_weights((const uint8_t*)m_data + offset,m_width,m_active_background,
+		     m_active_threshold,moments.projection_x.data(),sums);
+      else
+	_row_weights((const uint16_t*)m_data + offset,m_width,m_active_background,
+		     m_active_threshold,moments.projection_x.data(),sums);
+      projection_y[y] = float(sums.s);
+      moments.s += sums.s;
+      moments.sx += sums.sx;
+      moments.sxx += sums.sxx;
+      moments.sy += y * sums.s;
+      moments.syy += double(y) * y * sums.s;
+      moments.sxy += y * sums.sx;
+      moments.nb_pixels += sums.nb_pixels;
+    }
+}
+
+//---------------------------
+//- BeamAnalysis::process()
+//---------------------------
+void BeamAnalysis::process(const void* data,int width,int height,size_t image_size,
+			   int frame_nb,double timestamp)
+{
+  DEB_MEMBER_FUNCT();
+  if(!m_active)
+    return;
+  if(width != m_frame_size.getWidth() || height != m_frame_size.getHeight() ||
+     size_t(width) * height * FrameDim::getImageTypeDepth(m_type) > image_size)
+    {
+      DEB_TRACE() << "Frame " << frame_nb << " does not match the beam analysis";
+      return;
+    }
+
+  Result& result = m_ring.beginWrite();
+  result.index = m_ring.getNbResults();
+  result.frame_nb = frame_nb;
+  result.timestamp = timestamp;
+  m_data = data;
+  m_result = &result;
+
+  // the grab thread takes the first band
+  if(m_nb_bands > 1)
+    {
+      AutoMutex aLock(m_cond.mutex());
+      ++m_job;
+      m_nb_pending = m_nb_bands - 1;
+      m_cond.broadcast();
+    }
+  _processBand(0,m_moments[0]);
+  if(m_nb_bands > 1)
+    {
+      AutoMutex aLock(m_cond.mutex());
+      while(m_nb_pending)
+	m_cond.wait();
+    }
+
+  _Moments& total = m_moments[0];
+  for(int band = 1;band < m_nb_bands;++band)
+    total.add(m_moments[band]);
+  result.projection_x = total.projection_x;
+  result.intensity = total.s;
+  result.nb_pixels = int(total.nb_pixels);
+  result.valid = total.s > 0.;
+  if(result.valid)
+    {
+      double cx = total.sx / total.s;
+      double cy = total.sy / total.s;
+      result.centroid_x = cx + m_x0;
+      result.centroid_y = cy + m_y0;
+      result.sigma_x = sqrt(std::max(total.sxx / total.s - cx * cx,0.));
+      result.sigma_y = sqrt(std::max(total.syy / total.s - cy * cy,0.));
+      result.sigma_xy = total.sxy / total.s - cx * cy;
+      result.fwhm_x = fwhm(result.projection_x);
+      result.fwhm_y = fwhm(result.projection_y);
+    }
+  else
+    result.centroid_x = result.centroid_y = result.sigma_x = result.sigma_y =
+      result.sigma_xy = result.fwhm_x = result.fwhm_y = 0.;
+  m_ring.endWrite();
+}
+
+//---------------------------
+//- BeamAnalysis::fwhm()
+//- the profile edge is taken when it does not fall to half
+//---------------------------
+double BeamAnalysis::fwhm(const std::vector<float>& profile)
+{
+  if(profile.empty())
+    return 0.;
+  int n = int(profile.size());
+  int peak = int(std::max_element(profile.begin(),profile.end()) - profile.begin());
+  float half = profile[peak] / 2.f;
+  if(half <= 0.f)
+    return 0.;
+
+  int left = peak;
+  while(left > 0 && profile[left - 1] > half)
+    --left;
+  double x_left = left;
+  if(left > 0)
+    x_left = left - 1 + (half - profile[left - 1]) / (profile[left] - profile[left - 1]);
+
+  int right = peak;
+  while(right < n - 1 && profile[right + 1] > half)
+    ++right;
+  double x_right = right;
+  if(right < n - 1)
+    x_right = right + (profile[right] - half) / (profile[right] - profile[right + 1]);
+  return x_right - x_left;
+}
+
+//---------------------------
+//- BeamAnalysis::getResults()
+//---------------------------
+void BeamAnalysis::getResults(long long since,std::vector<Result>& results,
+			      long long& next) const
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(since);
+  AutoMutex aLock(m_lock);
+  m_ring.read(since,results,next);
+  DEB_RETURN() << DEB_VAR2(results.size(),next);
+}
+
+//---------------------------
+//- BeamAnalysis::getLastResult()
+//---------------------------
+bool BeamAnalysis::getLastResult(Result& result) const
+{
+  AutoMutex aLock(m_lock);
+  return m_ring.readLast(result);
+}
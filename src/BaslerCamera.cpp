@@ -30,8 +30,16 @@
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <map>
+#include <deque>
 #include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "BaslerCamera.h"
+#include "BaslerBlockId.h"
+#include "BaslerCameraArray.h"
+#include "BaslerResourcePool.h"
 #include "BaslerVideoCtrlObj.h"
 
 using namespace lima;
@@ -43,6 +51,10 @@ using namespace std;
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include <time.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
 
 #define min(A,B) std::min(A,B)
 #define max(A,B) std::max(A,B)
@@ -55,6 +67,23 @@ const static std::string UNAME_PREFIX = "uname://";
 //---------------------------
 //- utility function
 //---------------------------
+static inline double _get_thread_cpu_time()
+{
+#if defined(WIN32)
+  FILETIME creation,exit,kernel,user;
+  if(!GetThreadTimes(GetCurrentThread(),&creation,&exit,&kernel,&user))
+    return 0.;
+  ULONGLONG ticks = ((ULONGLONG(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) +
+    ((ULONGLONG(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+  return ticks * 1e-7;		// 100 ns ticks
+#else
+  struct timespec ts;
+  if(clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts))
+    return 0.;
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
 static inline const char* _get_ip_addresse(const char *name_ip)
 {
   
@@ -72,6 +101,70 @@ static inline const char* _get_ip_addresse(const char *name_ip)
       return inet_ntoa(*((struct in_addr*)host->h_addr));
     }
 }
+
+// negotiated packet size per camera serial number
+static Mutex _packet_size_cache_mutex;
+static std::map<std::string,int> _packet_size_cache;
+// safe packet size without jumbo frames
+static const int STANDARD_PACKET_SIZE = 1500;
+
+// frame rate lowered by each overrun with the throttle policy
+static const double OVERRUN_THROTTLE_FACTOR = 0.8;
+// telemetry period multiplier while grabbing above the rate limit
+static const double TELEMETRY_GRAB_SLOWDOWN = 10.;
+// auto exposure loop wait when the grab thread wake up is missed (s)
+static const double AUTO_EXPOSURE_POLL_PERIOD = 0.1;
+// GainRaw step of the ace GigE and scout, in dB
+static const double GAIN_RAW_DB = 0.0359;
+// software triggers kept for their latency
+static const int SOFT_TRIGGER_RING_SIZE = 65536;
+// camera clock mapped again to the host time after (s)
+static const double CAMERA_CLOCK_LATCH_PERIOD = 10.;
+// missed frame gaps of [2^i,2^(i+1)) frames
+static const int MISSED_FRAME_GAP_BINS = 16;
+// missing block ids remembered to tell late frames from duplicated ones
+static const long long MISSING_BLOCK_IDS_MAX = 1024;
+// larger block id gaps are a counter jump, not blanked
+static const long long MISSED_FRAMES_MAX = 65535;
+
+// zero fill with streaming stores, the blank frame is not read back
+// by this thread and should not evict the cache
+static void _stream_zero(void* ptr,size_t size)
+{
+#ifdef __SSE2__
+  char* p = (char*)ptr;
+  char* end = p + size;
+  size_t head = min(size_t(-uintptr_t(p) & 15),size);
+  memset(p,0,head);
+  p += head;
+  __m128i zero = _mm_setzero_si128();
+  for(;p + 64 <= end;p += 64)
+    {
+      _mm_stream_si128((__m128i*)p,zero);
+      _mm_stream_si128((__m128i*)(p + 16),zero);
+      _mm_stream_si128((__m128i*)(p + 32),zero);
+      _mm_stream_si128((__m128i*)(p + 48),zero);
+    }
+  for(;p + 16 <= end;p += 16)
+    _mm_stream_si128((__m128i*)p,zero);
+  _mm_sfence();
+  memset(p,0,end - p);
+#else
+  memset(ptr,0,size);
+#endif
+}
+
+static inline bool _is_trigger_available(Camera_t* camera,const char* trigger_name)
+{
+  GenApi::IEnumEntry *anEntry = camera->TriggerSelector.GetEntryByName(trigger_name);
+  return anEntry && GenApi::IsAvailable(anEntry);
+}
+
+static inline bool _is_event_available(Camera_t* camera,const char* event_name)
+{
+  GenApi::IEnumEntry *anEntry = camera->EventSelector.GetEntryByName(event_name);
+  return anEntry && GenApi::IsAvailable(anEntry);
+}
 //---------------------------
 //- EventHandler
 //---------------------------
@@ -80,20 +173,303 @@ class Camera::_EventHandler : public CBaslerUniversalCameraEventHandler,
 {
   DEB_CLASS_NAMESPC(DebModCamera, "Camera", "_EventHandler");
 public:
+  enum CameraEventId {FrameStartWaitEvent, ExposureEndEvent};
+
   _EventHandler(Camera &aCam) :
-    m_cam(aCam), m_buffer_mgr(m_cam.m_buffer_ctrl_obj.getBuffer())
+    m_block_id(0),
+    m_block_id_started(false),
+    m_block_nb(-1),
+    m_last_frame_nb(-1),
+    m_cam(aCam), m_buffer_mgr(m_cam.m_buffer_ctrl_obj.getBuffer()),
+    m_hdr_timestamp(0.)
   {
   };
 
   virtual void 	OnImageGrabbed(CBaslerUniversalInstantCamera &camera,
 			       const CBaslerUniversalGrabResultPtr &grabResult);
+  virtual void	OnImagesSkipped(CBaslerUniversalInstantCamera &camera,
+				size_t countOfSkippedImages);
+  virtual void	OnCameraEvent(CBaslerUniversalInstantCamera &camera,
+			      intptr_t userProvidedId,
+			      GenApi::INode* pNode);
   
-  unsigned short	m_block_id;
+  uint64_t		m_block_id;	/* last in order block id */
+  bool			m_block_id_started;
+  std::deque<uint64_t>	m_missing_block_ids; /* recent, to tell late frames */
+  long long		m_block_nb;	/* of m_block_id since the start, -1 if none */
+  int			m_last_frame_nb; /* given to lima by the last result, -1 if none */
+  std::string		m_frame_start_wait_node;
+  std::string		m_exposure_end_node;
 private:
-  void _check_missing_frame(const CBaslerUniversalGrabResultPtr &ptrGrabResult);
+  bool _check_missing_frame(const CBaslerUniversalGrabResultPtr &ptrGrabResult);
+  int64_t _block_id_distance(uint64_t from,uint64_t to) const;
+  uint64_t _next_block_id(uint64_t block_id,long long nb = 1) const;
+  void _tag_sequence_set(const CBaslerUniversalGrabResultPtr &ptrGrabResult);
+  bool _merge_hdr_frame(const void* srcPt,double timestamp);
+  bool _new_frame_ready(HwFrameInfoType& frame_info);
+  bool _deliver_frame(HwFrameInfoType& frame_info);
+  bool _analysing() const
+  {return m_cam.m_frame_stats.isActive() || m_cam.m_beam_analysis.isActive();}
+  void _analyse_frame(const CBaslerUniversalGrabResultPtr &ptrGrabResult,
+		      int frame_nb,double timestamp);
+  bool _overrun_drop();
   
+  friend class Camera::_BlankFiller;
   Camera&		m_cam;
   StdBufferCbMgr&	m_buffer_mgr;
+  double		m_hdr_timestamp;
+};
+
+//---------------------------
+//- BlankFiller
+//- missed frames blanked off the grab thread, the frames grabbed
+//- meanwhile are queued behind them to keep lima in order
+//---------------------------
+class Camera::_BlankFiller : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera, "Camera", "_BlankFiller");
+public:
+  _BlankFiller(Camera& aCam) :
+    m_cam(aCam),
+    m_nb_queued(0),
+    m_busy(false),
+    m_quit(false),
+    m_thread_id(0)
+  {}
+  virtual ~_BlankFiller()
+  {
+    {
+      AutoMutex aLock(m_cond.mutex());
+      m_quit = true;
+      m_cond.broadcast();
+    }
+    join();
+  }
+
+  void fill(int frame_nb);
+  bool defer(HwFrameInfoType& frame_info);
+  void flush(bool discard);
+protected:
+  virtual void threadFunction();
+private:
+  struct _Frame
+  {
+    HwFrameInfoType	info;
+    bool		blank;
+  };
+  Cond			m_cond;
+  Camera&		m_cam;
+  std::deque<_Frame>	m_pending;
+  // pending + being delivered, checked by the grab thread without the lock
+  std::atomic<int>	m_nb_queued;
+  bool			m_busy;
+  bool			m_quit;
+  long			m_thread_id;
+};
+
+//---------------------------
+//- TelemetrySampler
+//- slow changing values read in one batch every period
+//---------------------------
+class Camera::_TelemetrySampler : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera, "Camera", "_TelemetrySampler");
+public:
+  _TelemetrySampler(Camera& aCam) :
+    m_cam(aCam),
+    m_quit(false)
+  {}
+  virtual ~_TelemetrySampler()
+  {
+    {
+      AutoMutex aLock(m_cond.mutex());
+      m_quit = true;
+      m_cond.broadcast();
+    }
+    join();
+  }
+
+  void wakeup()
+  {
+    AutoMutex aLock(m_cond.mutex());
+    m_cond.broadcast();
+  }
+protected:
+  virtual void threadFunction();
+private:
+  Cond			m_cond;
+  Camera&		m_cam;
+  bool			m_quit;
+};
+
+//---------------------------
+//- AutoExposureLoop
+//- exposure time and gain adjusted from the frame stats histograms,
+//- the grab thread wakes it up without waiting
+//---------------------------
+class Camera::_AutoExposureLoop : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera, "Camera", "_AutoExposureLoop");
+public:
+  _AutoExposureLoop(Camera& aCam) :
+    m_cam(aCam),
+    m_quit(false),
+    m_busy(false),
+    m_generation(0),
+    m_user_gain(0.),
+    m_min_exp_time(0.),
+    m_max_exp_time(0.),
+    m_gain_span(0.),
+    m_exp_time_adjustable(false),
+    m_next_index(0)
+  {}
+  virtual ~_AutoExposureLoop()
+  {
+    {
+      AutoMutex aLock(m_cond.mutex());
+      m_quit = true;
+      m_cond.broadcast();
+    }
+    join();
+  }
+
+  // prepareAcq, the grab thread is idle
+  void reset(bool running,double exp_time,double gain,double min_exp_time,
+	     double max_exp_time,double gain_span,bool exp_time_adjustable);
+  // stopAcq, the exposure time and gain of the user are set back
+  void stop();
+  // grab thread, a missed wake up is caught by the poll period
+  void notify()
+  {
+    AutoMutex aLock(m_cond.mutex(),AutoMutex::TryLocked);
+    if(aLock.locked())
+      m_cond.broadcast();
+  }
+  void getState(AutoExposureLoopState& state) const
+  {
+    AutoMutex aLock(m_cond.mutex());
+    state = m_state;
+  }
+protected:
+  virtual void threadFunction();
+private:
+  bool _step(const FrameStats::Result& result,double& exp_time,double& gain);
+
+  mutable Cond		m_cond;
+  Camera&		m_cam;
+  bool			m_quit;
+  bool			m_busy;		/* writing an adjustment */
+  unsigned long long	m_generation;	/* of the reset */
+  double		m_user_gain;
+  double		m_min_exp_time;
+  double		m_max_exp_time;
+  double		m_gain_span;	/* dB */
+  bool			m_exp_time_adjustable;
+  long long		m_next_index;	/* first frame stats result to use */
+  AutoExposureLoopState	m_state;
+};
+
+//---------------------------
+//- VideoLender
+//- video frames delivered by a thread holding the grab results,
+//- each loan is a handle of a recycled pool, released when lima
+//- returns from callNewImage
+//---------------------------
+class Camera::_VideoLender : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera, "Camera", "_VideoLender");
+public:
+  _VideoLender(Camera& aCam,int pool_size) :
+    m_cam(aCam),
+    m_loans(pool_size),
+    m_quit(false)
+  {
+    for(int i = 0;i < pool_size;++i)
+      m_free.push_back(i);
+  }
+  virtual ~_VideoLender()
+  {
+    {
+      AutoMutex aLock(m_cond.mutex());
+      m_quit = true;
+      m_cond.broadcast();
+    }
+    join();
+  }
+
+  bool lend(const CBaslerUniversalGrabResultPtr& result,VideoMode mode);
+  void flush();
+protected:
+  virtual void threadFunction();
+private:
+  struct _Loan
+  {
+    CBaslerUniversalGrabResultPtr	result;
+    VideoMode				mode;
+  };
+
+  Cond			m_cond;
+  Camera&		m_cam;
+  std::vector<_Loan>	m_loans;
+  std::vector<int>	m_free;
+  std::deque<int>	m_pending;
+  bool			m_quit;
+};
+
+//---------------------------
+//- GrabLoop
+//- user grab loop thread: waits for the grab results, drains all the
+//- ready ones per wakeup, image event handlers run in RetrieveResult
+//---------------------------
+class Camera::_GrabLoop : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera, "Camera", "_GrabLoop");
+public:
+  _GrabLoop(Camera& aCam) :
+    m_wakeup(WaitObjectEx::Create()),
+    m_cam(aCam),
+    m_run(false),
+    m_running(false),
+    m_quit(false),
+    m_thread_id(0)
+  {
+    _resetStatistics();
+  }
+  virtual ~_GrabLoop()
+  {
+    {
+      AutoMutex aLock(m_cond.mutex());
+      m_quit = true;
+      m_wakeup.Signal();
+      m_cond.broadcast();
+    }
+    join();
+  }
+
+  void startGrab();
+  void waitIdle();
+  void getStatistics(double& wakeups_per_frame,
+		     double& mean_latency,double& max_latency) const;
+protected:
+  virtual void threadFunction();
+private:
+  void _grab();
+  void _setPriority(int priority);
+  void _resetStatistics();
+
+  WaitObjectEx		m_wakeup;
+  mutable Cond		m_cond;
+  Camera&		m_cam;
+  bool			m_run;
+  bool			m_running;
+  bool			m_quit;
+  long			m_thread_id;
+  //- statistics
+  long long		m_nb_wakeups;
+  long long		m_nb_frames;
+  long long		m_nb_latencies;
+  double		m_latency_sum;
+  double		m_latency_max;
 };
 
 
@@ -101,117 +477,341 @@ private:
 //- Ctor
 //---------------------------
 Camera::Camera(const std::string& camera_id,int packet_size,int receive_priority)
-        : m_nb_frames(1),
-          m_status(Ready),
+  : Camera(NULL,camera_id,packet_size,receive_priority)
+{
+}
+
+//---------------------------
+//- Ctor, camera owned by a CameraArray if given
+//---------------------------
+Camera::Camera(Camera_t* camera,const std::string& camera_id,
+	       int packet_size,int receive_priority)
+        : m_buffer_ctrl_obj(*this),
+          m_nb_frames(1),
 	  m_image_number(0),
+	  m_nb_grab_results(0),
           m_exp_time(1.),
           m_latency_time(0.),
           m_socketBufferSize(0),
           m_is_usb(false),
-	  m_blank_image_for_missed(false),
-          Camera_(NULL),
+	  m_missed_frame_mode(MissedIgnore),
+          Camera_(camera),
+	  m_own_camera(!camera),
+	  m_camera_array(NULL),
+	  m_array_index(-1),
 	  m_event_handler(NULL),
           m_receive_priority(receive_priority),
 	  m_video_flag_mode(false),
-	  m_video(NULL)
+	  m_video(NULL),
+	  m_soft_trigger_event_available(false),
+	  m_soft_trigger_event_mode(false),
+	  m_soft_trigger_queue_size(0),
+	  m_soft_trigger_ready_count(0),
+	  m_soft_trigger_sent(0),
+	  m_soft_trigger_pending(0),
+	  m_soft_trigger_stopped(false),
+	  m_tick_host_offset(0.),
+	  m_camera_exp_time(0.),
+	  m_timer_trigger_mode(false),
+	  m_timer_trigger_period(1.),
+	  m_timer_trigger_burst_count(1),
+	  m_sequencer_mode(false),
+	  m_sequencer_advance(AdvanceByFrameCount),
+	  m_sequence_set_executions(1),
+	  m_sequence_chunk_available(false),
+	  m_hdr_mode(false),
+	  m_hdr_output_type(Bpp32F),
+	  m_hdr_saturation_level(0.),
+	  m_hdr_group_size(1),
+	  m_shared_grab_loop(false),
+	  m_buffer_quota(0),
+	  m_accounting_nb_frames(0),
+	  m_accounting_nb_bytes(0),
+	  m_accounting_cpu_time(0.),
+	  m_stream_buffer_count(10),
+	  m_numa_node(-1),
+	  m_numa_local_buffers(false),
+	  m_grab_thread_cpus_pending(false),
+	  m_grab_thread_id(0),
+	  m_video_live_strategy(VideoOneByOne),
+	  m_video_latest_images_depth(2),
+	  m_video_snapshot_strategy(VideoOneByOne),
+	  m_nb_skipped_frames(0),
+	  m_preview_mode(false),
+	  m_frame_stats_mode(false),
+	  m_beam_analysis_mode(false),
+	  m_auto_exposure_loop_mode(AutoExposureLoopOff),
+	  m_auto_exposure_loop_target(0.8),
+	  m_auto_exposure_loop_percentile(0.99),
+	  m_auto_exposure_loop_tolerance(0.05),
+	  m_auto_exposure_loop_max_step(4.),
+	  m_auto_exposure_loop_max_exp_time(0.),
+	  m_auto_exposure_loop_settle_frames(1),
+	  m_auto_exposure_loop(NULL),
+	  m_video_lend_mode(false),
+	  m_video_lend_pool_size(2),
+	  m_video_lender(NULL),
+	  m_nb_video_lend_drops(0),
+	  m_overrun_policy(OverrunStop),
+	  m_overrun_decimation(4),
+	  m_overrun_recovery_frames(100),
+	  m_overrun_active(false),
+	  m_overrun_throttled(false),
+	  m_overrun_frames(0),
+	  m_nb_overruns(0),
+	  m_nb_overrun_drops(0),
+	  m_throttle_saved_rate(-1.),
+	  m_throttle_saved_enable(false),
+	  m_blank_filler(NULL),
+	  m_missed_frame_bitmap_size(0),
+	  m_nb_missed_frames(0),
+	  m_missed_frame_gaps(MISSED_FRAME_GAP_BINS,0),
+	  m_block_id_bits(16),
+	  m_nb_duplicated_frames(0),
+	  m_nb_late_frames(0),
+	  m_telemetry_period(0.),
+	  m_telemetry_grab_rate_limit(100.),
+	  m_telemetry_sampler(NULL),
+	  m_user_grab_loop(false),
+	  m_grab_loop_priority(0),
+	  m_grab_loop(NULL)
 {
     DEB_CONSTRUCTOR();
     m_camera_id = camera_id;
     try
     {
-        // Create the transport layer object needed to enumerate or
-        // create a camera object of type Camera_t::DeviceClass()
-        DEB_TRACE() << "Create a camera object of type Camera_t::DeviceClass()";
-        CTlFactory& TlFactory = CTlFactory::GetInstance();
+	if(!Camera_)
+	  {
+	    IPylonDevice* device = _createDevice(m_camera_id);
+
+	    //- Create the Basler Camera object
+	    DEB_TRACE() << "Create the Camera object corresponding to the created Pylon device";
+	    Camera_ = new Camera_t(device);
+	    if(!Camera_)
+	    {
+	        THROW_HW_ERROR(Error) << "Unable to get the camera from transport_layer!";
+	    }
+	  }
+	_init(packet_size);
+    }
+    catch (Pylon::GenericException &e)
+    {
+      DeviceInfoList_t list;
+      CTlFactory::GetInstance().EnumerateDevices(list);
+      if(!list.empty())
+	DEB_ALWAYS() << "Device founds:";
+      else
+	DEB_ALWAYS() << "No Camera found!";
+      for(auto dev: list)
+	{
+	  DEB_ALWAYS() << "------------------------------------";
+	  DEB_ALWAYS() << "SerialNumber    = " << dev.GetSerialNumber();
+	  DEB_ALWAYS() << "UserDefinedName = " << dev.GetUserDefinedName();
+	  DEB_ALWAYS() << "DeviceVersion   = " << dev.GetDeviceVersion();
+	  DEB_ALWAYS() << "DeviceFactory   = " << dev.GetDeviceFactory();
+	  DEB_ALWAYS() << "FriendlyName    = " << dev.GetFriendlyName();
+	  DEB_ALWAYS() << "FullName        = " << dev.GetFullName();
+	  DEB_ALWAYS() << "DeviceClass     = " << dev.GetDeviceClass();
+	  DEB_ALWAYS() << "\n";
+	}
+        // Error handling
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+
+    // if color camera video capability will be available
+    m_video_flag_mode = m_color_flag;
+    // Camera tick frequency
+    m_tick_frequency = this->Camera_->GevTimestampTickFrequency();
+    DEB_ALWAYS() << DEB_VAR1(m_tick_frequency);
+}
+
+//---------------------------
+//- Dtor
+//---------------------------
+Camera::~Camera()
+{
+    DEB_DESTRUCTOR();
+    ResourcePool::getInstance()._releaseCamera(this);
+    delete m_grab_loop;
+    delete m_video_lender;
+    delete m_blank_filler;
+    delete m_telemetry_sampler;
+    delete m_auto_exposure_loop;
+    try
+    {
+        Camera_->DeregisterImageEventHandler(m_event_handler);
+	if(m_soft_trigger_event_available)
+	  {
+	    Camera_->DeregisterCameraEventHandler(m_event_handler,
+						  m_event_handler->m_frame_start_wait_node.c_str());
+	    Camera_->DeregisterCameraEventHandler(m_event_handler,
+						  m_event_handler->m_exposure_end_node.c_str());
+	  }
+        // Stop Acq thread
+        delete m_event_handler;
+        m_event_handler = NULL;
+        
+        // Close camera, array cameras are closed by their CameraArray
+        if(m_own_camera)
+          {
+            DEB_TRACE() << "Close camera";
+            delete Camera_;
+          }
+        Camera_ = NULL;
+    }
+    catch (Pylon::GenericException &e)
+    {
+        // Error handling
+        DEB_ERROR() << e.GetDescription();
+    }
+}
+
+//---------------------------
+//- Camera::_createDevice()
+//- camera_id is completed with the default ip:// scheme
+//---------------------------
+IPylonDevice* Camera::_createDevice(std::string& camera_id)
+{
+    DEB_STATIC_FUNCT();
+    // Create the transport layer object needed to enumerate or
+    // create a camera object of type Camera_t::DeviceClass()
+    DEB_TRACE() << "Create a camera object of type Camera_t::DeviceClass()";
+    CTlFactory& TlFactory = CTlFactory::GetInstance();
 
-        CDeviceInfo di;
+    CDeviceInfo di;
 
 	// by default use ip:// scheme if none is given
-	if (m_camera_id.find("://") == std::string::npos)
+	if (camera_id.find("://") == std::string::npos)
 	{
-            m_camera_id = "ip://" + m_camera_id;
+        camera_id = "ip://" + camera_id;
 	}
 
-	if(!m_camera_id.compare(0, IP_PREFIX.size(), IP_PREFIX))
-        {
-            // m_camera_id is not really necessarily an IP, it may also be a DNS name
-            Pylon::String_t pylon_camera_ip(_get_ip_addresse(m_camera_id.substr(IP_PREFIX.size()).c_str()));
-            //- Find the Pylon device thanks to its IP Address
-            di.SetIpAddress( pylon_camera_ip);
-            DEB_TRACE() << "Create the Pylon device attached to ip address: "
-			<< DEB_VAR1(m_camera_id);
+	if(!camera_id.compare(0, IP_PREFIX.size(), IP_PREFIX))
+    {
+        // camera_id is not really necessarily an IP, it may also be a DNS name
+        Pylon::String_t pylon_camera_ip(_get_ip_addresse(camera_id.substr(IP_PREFIX.size()).c_str()));
+        //- Find the Pylon device thanks to its IP Address
+        di.SetIpAddress( pylon_camera_ip);
+        DEB_TRACE() << "Create the Pylon device attached to ip address: "
+			<< DEB_VAR1(camera_id);
  	}
-        else if (!m_camera_id.compare(0, SN_PREFIX.size(), SN_PREFIX))
+    else if (!camera_id.compare(0, SN_PREFIX.size(), SN_PREFIX))
 	{
-            Pylon::String_t serial_number(m_camera_id.substr(SN_PREFIX.size()).c_str());
-            //- Find the Pylon device thanks to its serial number
-            di.SetSerialNumber(serial_number);
-            DEB_TRACE() << "Create the Pylon device attached to serial number: "
-			<< DEB_VAR1(m_camera_id);
+        Pylon::String_t serial_number(camera_id.substr(SN_PREFIX.size()).c_str());
+        //- Find the Pylon device thanks to its serial number
+        di.SetSerialNumber(serial_number);
+        DEB_TRACE() << "Create the Pylon device attached to serial number: "
+			<< DEB_VAR1(camera_id);
 	}
-	else if(!m_camera_id.compare(0, UNAME_PREFIX.size(), UNAME_PREFIX))
-        {
-            Pylon::String_t user_name(m_camera_id.substr(UNAME_PREFIX.size()).c_str());
-            //- Find the Pylon device thanks to its user name
-            di.SetUserDefinedName(user_name);
-            DEB_TRACE() << "Create the Pylon device attached to user name: "
-			<< DEB_VAR1(m_camera_id);
+	else if(!camera_id.compare(0, UNAME_PREFIX.size(), UNAME_PREFIX))
+    {
+        Pylon::String_t user_name(camera_id.substr(UNAME_PREFIX.size()).c_str());
+        //- Find the Pylon device thanks to its user name
+        di.SetUserDefinedName(user_name);
+        DEB_TRACE() << "Create the Pylon device attached to user name: "
+			<< DEB_VAR1(camera_id);
  	}
 
 	else 
-        {
+    {
 	    THROW_CTL_ERROR(InvalidValue) << "Unrecognized camera id: " << camera_id;
-        }  
-        IPylonDevice* device = CTlFactory::GetInstance().CreateFirstDevice(di);
-        if (!device)
-        {
-            THROW_HW_ERROR(Error) << "Unable to find camera with selected IP!";
-        }
+    }  
+    IPylonDevice* device = CTlFactory::GetInstance().CreateFirstDevice(di);
+    if (!device)
+    {
+        THROW_HW_ERROR(Error) << "Unable to find camera with selected IP!";
+    }
 
-        //- Create the Basler Camera object
-        DEB_TRACE() << "Create the Camera object corresponding to the created Pylon device";
-        Camera_ = new Camera_t(device);
-        if(!Camera_)
-        {
-            THROW_HW_ERROR(Error) << "Unable to get the camera from transport_layer!";
-        }
+    return device;
+}
 
-        //- Get detector model and type
-        m_detector_type  = Camera_->GetDeviceInfo().GetVendorName();
-        m_detector_model = Camera_->GetDeviceInfo().GetModelName();
-        m_is_usb = Camera_->GetDeviceInfo().IsUsbDriverTypeAvailable();
-
-        //- Infos:
-        DEB_TRACE() << DEB_VAR2(m_detector_type,m_detector_model);
-        DEB_TRACE() << "SerialNumber    = " << Camera_->GetDeviceInfo().GetSerialNumber();
-        DEB_TRACE() << "UserDefinedName = " << Camera_->GetDeviceInfo().GetUserDefinedName();
-        DEB_TRACE() << "DeviceVersion   = " << Camera_->GetDeviceInfo().GetDeviceVersion();
-        DEB_TRACE() << "DeviceFactory   = " << Camera_->GetDeviceInfo().GetDeviceFactory();
-        DEB_TRACE() << "FriendlyName    = " << Camera_->GetDeviceInfo().GetFriendlyName();
-        DEB_TRACE() << "FullName        = " << Camera_->GetDeviceInfo().GetFullName();
-        DEB_TRACE() << "DeviceClass     = " << Camera_->GetDeviceInfo().GetDeviceClass();
+//---------------------------
+//- Camera::_init()
+//- camera setup common to standalone and array cameras
+//---------------------------
+void Camera::_init(int packet_size)
+{
+    DEB_MEMBER_FUNCT();
+    //- Get detector model and type
+    m_detector_type  = Camera_->GetDeviceInfo().GetVendorName();
+    m_detector_model = Camera_->GetDeviceInfo().GetModelName();
+    m_is_usb = Camera_->GetDeviceInfo().IsUsbDriverTypeAvailable();
+
+    //- Infos:
+    DEB_TRACE() << DEB_VAR2(m_detector_type,m_detector_model);
+    DEB_TRACE() << "SerialNumber    = " << Camera_->GetDeviceInfo().GetSerialNumber();
+    DEB_TRACE() << "UserDefinedName = " << Camera_->GetDeviceInfo().GetUserDefinedName();
+    DEB_TRACE() << "DeviceVersion   = " << Camera_->GetDeviceInfo().GetDeviceVersion();
+    DEB_TRACE() << "DeviceFactory   = " << Camera_->GetDeviceInfo().GetDeviceFactory();
+    DEB_TRACE() << "FriendlyName    = " << Camera_->GetDeviceInfo().GetFriendlyName();
+    DEB_TRACE() << "FullName        = " << Camera_->GetDeviceInfo().GetFullName();
+    DEB_TRACE() << "DeviceClass     = " << Camera_->GetDeviceInfo().GetDeviceClass();
 
 	// Register Event handler
-        m_event_handler = new _EventHandler(*this);
+    m_event_handler = new _EventHandler(*this);
 	Camera_->RegisterImageEventHandler(m_event_handler,
 					   RegistrationMode_ReplaceAll,
 					   Cleanup_None);
 	// Camera event processing must be enabled first. The default is off.
 	Camera_->GrabCameraEvents = true;
-        // Open the camera
-        DEB_TRACE() << "Open camera";
-        Camera_->Open();
+    // Open the camera
+    DEB_TRACE() << "Open camera";
+    Camera_->Open();
 
 	if(!Camera_->EventSelector.IsWritable())
 	  THROW_HW_ERROR(Error) << "The device doesn't support events.";
-	
-        if(packet_size > 0 && !m_is_usb) {
-          Camera_->GevSCPSPacketSize.SetValue(packet_size);
 
-        }
+	// Register camera events used by the event driven software trigger
+	m_soft_trigger_event_available = (_is_event_available(Camera_,"FrameStartWait") &&
+					  _is_event_available(Camera_,"ExposureEnd"));
+	if(m_soft_trigger_event_available)
+	  {
+	    if(Camera_->GetSfncVersion() >= Sfnc_2_0_0)
+	      {
+		m_event_handler->m_frame_start_wait_node = "EventFrameStartWaitData";
+		m_event_handler->m_exposure_end_node = "EventExposureEndData";
+	      }
+	    else
+	      {
+		m_event_handler->m_frame_start_wait_node = "FrameStartWaitEventData";
+		m_event_handler->m_exposure_end_node = "ExposureEndEventData";
+	      }
+	    Camera_->RegisterCameraEventHandler(m_event_handler,
+						m_event_handler->m_frame_start_wait_node.c_str(),
+						_EventHandler::FrameStartWaitEvent,
+						RegistrationMode_Append,
+						Cleanup_None);
+	    Camera_->RegisterCameraEventHandler(m_event_handler,
+						m_event_handler->m_exposure_end_node.c_str(),
+						_EventHandler::ExposureEndEvent,
+						RegistrationMode_Append,
+						Cleanup_None);
+	  }
+	DEB_TRACE() << DEB_VAR1(m_soft_trigger_event_available);
+	
+    if(!m_is_usb) {
+      m_numa_node = Affinity::getInterfaceNumaNode(Camera_->GetDeviceInfo().GetInterface().c_str());
+      DEB_ALWAYS() << "Camera " << Camera_->GetDeviceInfo().GetSerialNumber()
+		   << " numa node: " << m_numa_node;
+      // 0 leaves the packet size as is
+      if(packet_size > 0)
+	Camera_->GevSCPSPacketSize.SetValue(packet_size);
+      else if(packet_size == PacketSizeAuto)
+	negotiatePacketSize(packet_size);
+      // GigE Vision 2 extended ids: 64 bit block ids without wrap
+      m_block_id_bits = 16;
+      if(IsWritable(Camera_->GevGVSPExtendedIDMode))
+	{
+	  Camera_->GevGVSPExtendedIDMode.SetValue(GevGVSPExtendedIDMode_On);
+	  m_block_id_bits = 64;
+	}
+    }
+    else
+      m_block_id_bits = 64;
+    DEB_TRACE() << DEB_VAR1(m_block_id_bits);
     
-        // Set the image format and AOI
-        DEB_TRACE() << "Set the image format and AOI";
+    // Set the image format and AOI
+    DEB_TRACE() << "Set the image format and AOI";
 	// basler model string last character codes for color (c) or monochrome (m)
 	std::list<string> formatList;
 
@@ -242,50 +842,50 @@ Camera::Camera(const std::string& camera_id,int packet_size,int receive_priority
 	    m_color_flag = false;
 	  }
 
-        bool formatSetFlag = false;
+    bool formatSetFlag = false;
 	for(list<string>::iterator it = formatList.begin(); it != formatList.end(); it++)
-        {
+    {
 	  GenApi::IEnumEntry *anEntry = Camera_->PixelFormat.GetEntryByName((*it).c_str());
-            if(anEntry && GenApi::IsAvailable(anEntry))
-            {
-                formatSetFlag = true;
+        if(anEntry && GenApi::IsAvailable(anEntry))
+        {
+            formatSetFlag = true;
 		Camera_->PixelFormat.SetIntValue(anEntry->GetValue());
-                DEB_TRACE() << "Set pixel format to " << *it;
-                break;
-            }
+            DEB_TRACE() << "Set pixel format to " << *it;
+            break;
         }
-        if(!formatSetFlag)
-            THROW_HW_ERROR(Error) << "Unable to set PixelFormat for the camera!";
-        DEB_TRACE() << "Set the ROI to full frame";
+    }
+    if(!formatSetFlag)
+        THROW_HW_ERROR(Error) << "Unable to set PixelFormat for the camera!";
+    DEB_TRACE() << "Set the ROI to full frame";
 	if(isRoiAvailable())
 	  {
 	    Roi aFullFrame(0,0,Camera_->WidthMax(),Camera_->HeightMax());
 	    setRoi(aFullFrame);
 	  }
-        // Set Binning to 1, only if the camera has this functionality        
-        if (isBinningAvailable())
-        {
-            DEB_TRACE() << "Set BinningH & BinningV to 1";
-            Camera_->BinningVertical.SetValue(1);
-            Camera_->BinningHorizontal.SetValue(1);
-        }
+    // Set Binning to 1, only if the camera has this functionality        
+    if (isBinningAvailable())
+    {
+        DEB_TRACE() << "Set BinningH & BinningV to 1";
+        Camera_->BinningVertical.SetValue(1);
+        Camera_->BinningHorizontal.SetValue(1);
+    }
 
-        DEB_TRACE() << "Get the Detector Max Size";
-        m_detector_size = Size(Camera_->WidthMax(), Camera_->HeightMax());
+    DEB_TRACE() << "Get the Detector Max Size";
+    m_detector_size = Size(Camera_->WidthMax(), Camera_->HeightMax());
 
-        // Set the camera to continuous frame mode
-        DEB_TRACE() << "Set the camera to continuous frame mode";
-        Camera_->AcquisitionMode.SetValue(AcquisitionMode_Continuous);
-        if ( IsAvailable(Camera_->ExposureAuto ))
-        {
-            DEB_TRACE() << "Set ExposureAuto to Off";           
-            Camera_->ExposureAuto.SetValue(ExposureAuto_Off);
-        }
+    // Set the camera to continuous frame mode
+    DEB_TRACE() << "Set the camera to continuous frame mode";
+    Camera_->AcquisitionMode.SetValue(AcquisitionMode_Continuous);
+    if ( IsAvailable(Camera_->ExposureAuto ))
+    {
+        DEB_TRACE() << "Set ExposureAuto to Off";           
+        Camera_->ExposureAuto.SetValue(ExposureAuto_Off);
+    }
 
 	if (IsAvailable(Camera_->TestImageSelector ))
 	{
-            DEB_TRACE() << "Set TestImage to Off";           
-            Camera_->TestImageSelector.SetValue(TestImageSelector_Off);	  
+        DEB_TRACE() << "Set TestImage to Off";           
+        Camera_->TestImageSelector.SetValue(TestImageSelector_Off);	  
 	}
 	// Start with internal trigger
 	// Force cache variable (camera register) to get trigger really initialized at first call
@@ -297,75 +897,122 @@ Camera::Camera(const std::string& camera_id,int packet_size,int receive_priority
 	//fast basler models do not support 1.0 second exposure but lower value
 	double exp_time = min(1.0, max_exp);
 	setExpTime(exp_time);
-        // Get the image buffer size
-        DEB_TRACE() << "Get the image buffer size";
-        ImageSize_ = (size_t)(Camera_->PayloadSize.GetValue());
-    }
-    catch (Pylon::GenericException &e)
-    {
-      DeviceInfoList_t list;
-      CTlFactory::GetInstance().EnumerateDevices(list);
-      if(!list.empty())
-	DEB_ALWAYS() << "Device founds:";
-      else
-	DEB_ALWAYS() << "No Camera found!";
-      for(auto dev: list)
-	{
-	  DEB_ALWAYS() << "------------------------------------";
-	  DEB_ALWAYS() << "SerialNumber    = " << dev.GetSerialNumber();
-	  DEB_ALWAYS() << "UserDefinedName = " << dev.GetUserDefinedName();
-	  DEB_ALWAYS() << "DeviceVersion   = " << dev.GetDeviceVersion();
-	  DEB_ALWAYS() << "DeviceFactory   = " << dev.GetDeviceFactory();
-	  DEB_ALWAYS() << "FriendlyName    = " << dev.GetFriendlyName();
-	  DEB_ALWAYS() << "FullName        = " << dev.GetFullName();
-	  DEB_ALWAYS() << "DeviceClass     = " << dev.GetDeviceClass();
-	  DEB_ALWAYS() << "\n";
-	}
-        // Error handling
-        THROW_HW_ERROR(Error) << e.GetDescription();
-    }
-
-    // if color camera video capability will be available
-    m_video_flag_mode = m_color_flag;
-    // Camera tick frequency
-    m_tick_frequency = this->Camera_->GevTimestampTickFrequency();
-    DEB_ALWAYS() << DEB_VAR1(m_tick_frequency);
-}
-
-//---------------------------
-//- Dtor
-//---------------------------
-Camera::~Camera()
-{
-    DEB_DESTRUCTOR();
-    try
-    {
-        Camera_->DeregisterImageEventHandler(m_event_handler);
-        // Stop Acq thread
-        delete m_event_handler;
-        m_event_handler = NULL;
-        
-        // Close camera
-        DEB_TRACE() << "Close camera";
-        delete Camera_;
-        Camera_ = NULL;
-    }
-    catch (Pylon::GenericException &e)
-    {
-        // Error handling
-        DEB_ERROR() << e.GetDescription();
-    }
+    // Get the image buffer size
+    DEB_TRACE() << "Get the image buffer size";
+    ImageSize_ = (size_t)(Camera_->PayloadSize.GetValue());
 }
 
 void Camera::prepareAcq()
 {
     DEB_MEMBER_FUNCT();
     m_image_number=0;
+    m_nb_grab_results=0;
     // new flag to better manage multiple acqStart() with trigger mode IntTrigMult
     // startAcq can be recalled before the threadFunction has processed the new image and
     // incremented the counter m_image_number
-    m_acq_started = false;
-    m_event_handler->m_block_id = 0; // reset block id counter
+    _resetAcqState();
+    // reset block id counter, GigE block ids start at 1,
+    // USB ones from the first frame
+    m_event_handler->m_block_id = 0;
+    m_event_handler->m_block_id_started = !m_is_usb;
+    // block 1 of GigE is number 0
+    m_event_handler->m_block_nb = -1;
+    m_event_handler->m_missing_block_ids.clear();
+    if(m_preview_mode)
+      m_preview.reset();
+    // merged HDR frames are not raw camera frames
+    bool auto_exposure = m_auto_exposure_loop_mode != AutoExposureLoopOff;
+    if((m_frame_stats_mode || auto_exposure) && !m_hdr_mode)
+      {
+	ImageType type;
+	_getCameraImageType(type);
+	m_frame_stats.prepare(type);
+      }
+    else
+      m_frame_stats.deactivate();
+    if(auto_exposure && !m_auto_exposure_loop)
+      {
+	m_auto_exposure_loop = new _AutoExposureLoop(*this);
+	m_auto_exposure_loop->start();
+      }
+    if(m_auto_exposure_loop)
+      _prepareAutoExposureLoop();
+    if(m_beam_analysis_mode && !m_hdr_mode)
+      {
+	ImageType type;
+	_getCameraImageType(type);
+	Size frame_size(int(Camera_->Width.GetValue()),int(Camera_->Height.GetValue()));
+	m_beam_analysis.prepare(type,frame_size);
+      }
+    else
+      m_beam_analysis.deactivate();
+
+    // array cameras are grabbed together, one frame per trigger
+    if(m_camera_array && m_trigger_mode == IntTrigMult)
+      THROW_HW_ERROR(NotSupported) << "IntTrigMult is not available with a camera array";
+    if(m_camera_array && m_hdr_mode)
+      THROW_HW_ERROR(NotSupported) << "HDR mode is not available with a camera array";
+
+    // HDR: m_hdr_group_size camera frames for each lima frame
+    m_hdr_group_size = 1;
+    if(m_hdr_mode)
+      _prepareHdrMerge();
+    int nb_camera_frames = m_nb_frames * m_hdr_group_size;
+
+    // ExtTrigSingle: one trigger starts a burst of m_nb_frames frames
+    if(m_trigger_mode == ExtTrigSingle)
+      {
+	int max_frame_count;
+	_getBurstFrameCountMax(max_frame_count);
+	if(nb_camera_frames < 1 || nb_camera_frames > max_frame_count)
+	  THROW_HW_ERROR(InvalidValue) << "ExtTrigSingle: nb frames must be in range [1,"
+				       << max_frame_count / m_hdr_group_size << "]";
+	setAcquisitionFrameCount(nb_camera_frames);
+      }
+
+    // frame sequence set tags, ring of buffer size for continuous acquisition
+    if(m_sequencer_mode)
+      {
+	int nb_tags = nb_camera_frames;
+	if(!nb_tags)
+	  {
+	    m_buffer_ctrl_obj.getBuffer().getNbBuffers(nb_tags);
+	    nb_tags *= m_hdr_group_size;
+	  }
+	m_frame_sequence_set_indexes.assign(nb_tags,-1);
+      }
+    else
+      m_frame_sequence_set_indexes.clear();
+
+    // missed frame bitmap, ring of buffer size for continuous acquisition
+    int nb_bits = m_nb_frames;
+    if(!nb_bits)
+      m_buffer_ctrl_obj.getBuffer().getNbBuffers(nb_bits);
+    {
+      AutoMutex aLock(m_accounting_mutex);
+      m_missed_frame_bitmap_size = nb_bits;
+      m_missed_frame_bitmap.assign((nb_bits + 63) / 64,0);
+    }
+
+    // exposure end events carry the camera time
+    m_tick_latch_time = Timestamp();
+    if(m_trigger_mode == IntTrigMult && m_soft_trigger_event_mode)
+      _latchCameraClock();
+
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    m_soft_trigger_ready_count = 0;
+    m_soft_trigger_sent = 0;
+    m_soft_trigger_pending = 0;
+    m_soft_trigger_stopped = false;
+    if(m_trigger_mode == IntTrigMult)
+      {
+	int nb_triggers = SOFT_TRIGGER_RING_SIZE;
+	if(m_nb_frames > 0)
+	  nb_triggers = min(m_nb_frames,nb_triggers);
+	m_soft_triggers.assign(nb_triggers,_SoftTrigger());
+      }
+    else
+      m_soft_triggers.clear();
 }
 
 //---------------------------
@@ -376,13 +1023,23 @@ void Camera::startAcq()
     DEB_MEMBER_FUNCT();
     try
     {
+	if(m_trigger_mode == IntTrigMult && m_soft_trigger_event_mode)
+	  {
+	    _startAcq();
+	    // the camera clock drifts from the host one
+	    if(double(Timestamp::now()) - double(m_tick_latch_time) > CAMERA_CLOCK_LATCH_PERIOD)
+	      _latchCameraClock();
+	    _sendSoftTrigger();
+	    return;
+	  }
+
 	_startAcq();
 
 	// start acquisition at first image
 	// code moved from prepareAcq(), otherwise with color camera
 	// CtVideo::_prepareAcq() which calls stopAcq() will kill the acquisition 
 	if(m_trigger_mode == IntTrigMult)
-	  this->Camera_->TriggerSoftware.Execute();
+	  _executeSoftTrigger();
     }
     catch (GenICam::GenericException &e)
     {
@@ -394,23 +1051,98 @@ void Camera::startAcq()
 void Camera::_startAcq()
 {
   DEB_MEMBER_FUNCT();
-  if(!m_acq_started)
+  if(!m_acq_state.acq_started.load(std::memory_order_relaxed))
     {
       if(m_video)
 	m_video->getBuffer().setStartTimestamp(Timestamp::now());
       else
 	m_buffer_ctrl_obj.getBuffer().setStartTimestamp(Timestamp::now());
 
-      if (m_nb_frames)
-	Camera_->StartGrabbing(m_nb_frames,GrabStrategy_OneByOne,GrabLoop_ProvidedByInstantCamera);
-      else
-	Camera_->StartGrabbing(GrabStrategy_OneByOne,GrabLoop_ProvidedByInstantCamera);
-      m_acq_started = true;
+      {
+	AutoMutex aLock(m_accounting_mutex);
+	m_accounting_start = m_accounting_last = Timestamp::now();
+	m_accounting_nb_frames = m_accounting_nb_bytes = 0;
+	m_accounting_cpu_time = 0.;
+	m_nb_skipped_frames = 0;
+	m_nb_video_lend_drops = 0;
+	m_overrun_active = m_overrun_throttled = false;
+	m_nb_overruns = m_nb_overrun_drops = 0;
+	m_nb_missed_frames = m_nb_duplicated_frames = m_nb_late_frames = 0;
+	// the stream grabber counters restart with the grabbing
+	m_stream_statistics_base = StreamStatistics();
+	m_stream_statistics_start = Timestamp::now();
+	m_missed_frame_gaps.assign(MISSED_FRAME_GAP_BINS,0);
+      }
+
+      _reserveStreamBuffers();
+
+      // Pylon receive and grab threads are created by StartGrabbing,
+      // they inherit the cpus of the calling thread
+      Affinity::CpuList caller_cpus;
+      bool receive_cpus = !m_thread_cpus[ReceiveThread].empty() && !m_camera_array;
+      if(receive_cpus)
+	{
+	  Affinity::getThreadCpus(caller_cpus);
+	  Affinity::setThreadCpus(m_thread_cpus[ReceiveThread]);
+	}
+      // shared pool and array threads serve several cameras
+      m_grab_thread_cpus.clear();
+      if(!m_camera_array && !m_shared_grab_loop)
+	m_grab_thread_cpus = m_thread_cpus[GrabThread].empty() ?
+	  (receive_cpus ? caller_cpus : Affinity::CpuList()) : m_thread_cpus[GrabThread];
+      m_grab_thread_cpus_pending = !m_grab_thread_cpus.empty();
+
+      EGrabStrategy strategy = _getGrabStrategy();
+      // the output queue can't be larger than the stream buffers
+      if(strategy == GrabStrategy_LatestImages)
+	Camera_->OutputQueueSize.SetValue(min<int64_t>(m_video_latest_images_depth,
+						       Camera_->MaxNumBuffer.GetValue()));
+
+      try
+	{
+	  if(m_camera_array)
+	    m_camera_array->_startCamera(m_array_index);
+	  else if(m_shared_grab_loop)
+	    {
+	      if (m_nb_frames)
+		Camera_->StartGrabbing(m_nb_frames * m_hdr_group_size,strategy,GrabLoop_ProvidedByUser);
+	      else
+		Camera_->StartGrabbing(strategy,GrabLoop_ProvidedByUser);
+	      ResourcePool::getInstance()._addGrabCamera(this);
+	    }
+	  else if(m_user_grab_loop)
+	    {
+	      if (m_nb_frames)
+		Camera_->StartGrabbing(m_nb_frames * m_hdr_group_size,strategy,GrabLoop_ProvidedByUser);
+	      else
+		Camera_->StartGrabbing(strategy,GrabLoop_ProvidedByUser);
+	      m_grab_loop->startGrab();
+	    }
+	  else if (m_nb_frames)
+	    Camera_->StartGrabbing(m_nb_frames * m_hdr_group_size,strategy,GrabLoop_ProvidedByInstantCamera);
+	  else
+	    Camera_->StartGrabbing(strategy,GrabLoop_ProvidedByInstantCamera);
+	}
+      catch(...)
+	{
+	  if(receive_cpus)
+	    Affinity::setThreadCpus(caller_cpus);
+	  throw;
+	}
+      if(receive_cpus)
+	Affinity::setThreadCpus(caller_cpus);
+      _setStatus(Camera::Exposure,false);
+      m_acq_state.acq_started.store(true,std::memory_order_release);
     }
   
   try
     {
-      if(m_trigger_mode != IntTrig)
+      // with event driven software trigger, readiness comes from FrameStartWait events
+      // in ExtTrigSingle the frame trigger is off, the camera waits for a burst trigger
+      // array cameras may not be grabbing yet
+      if(!m_camera_array &&
+	 m_trigger_mode != IntTrig && m_trigger_mode != ExtTrigSingle &&
+	 !(m_trigger_mode == IntTrigMult && m_soft_trigger_event_mode))
 	Camera_->WaitForFrameTriggerReady(1000, TimeoutHandling_ThrowException);
     }
   catch(GenICam::GenericException &e)
@@ -437,8 +1169,36 @@ void Camera::_stopAcq(bool internalFlag)
     {
       // Stop acquisition
       DEB_TRACE() << "Stop acquisition";
+      if(m_camera_array)
+	m_camera_array->_stopCamera(m_array_index);
       Camera_->StopGrabbing();
+      // from a frame callback the pool worker removes the camera itself
+      if(m_shared_grab_loop && !internalFlag)
+	ResourcePool::getInstance()._removeGrabCamera(this);
+      // returns at once from the grab loop thread itself
+      if(m_grab_loop)
+	m_grab_loop->waitIdle();
+      // lent video frames are delivered before the stop
+      if(m_video_lender)
+	m_video_lender->flush();
+      // missed frames blanked off the grab thread
+      if(m_blank_filler)
+	m_blank_filler->flush(internalFlag);
+      // frame rate lowered by the throttle overrun policy
+      if(m_throttle_saved_rate >= 0.)
+	_restoreFrameRate();
+      // exposure time and gain adjusted by the auto exposure loop
+      if(m_auto_exposure_loop)
+	m_auto_exposure_loop->stop();
+      // Pylon frees the stream buffers when grabbing stops
+      ResourcePool::getInstance()._setBufferMemory(this,0,true);
       _setStatus(Camera::Ready,false);
+      m_acq_state.acq_started.store(false,std::memory_order_release);
+
+      AutoMutex aLock(m_soft_trigger_cond.mutex());
+      m_soft_trigger_pending = 0;
+      m_soft_trigger_stopped = true;
+      m_soft_trigger_cond.broadcast();
     }
     catch (Pylon::GenericException &e)
     {
@@ -454,6 +1214,19 @@ void Camera::_forceVideoMode(bool force)
   m_video_flag_mode = force;
   
 }
+//---------------------------
+//- Camera::_EventHandler::OnImagesSkipped()
+//- frames dropped by the LatestImage(s) strategies
+//---------------------------
+void Camera::_EventHandler::OnImagesSkipped(CBaslerUniversalInstantCamera &camera,
+					    size_t countOfSkippedImages)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(countOfSkippedImages);
+  AutoMutex aLock(m_cam.m_accounting_mutex);
+  m_cam.m_nb_skipped_frames += countOfSkippedImages;
+}
+
 //---------------------------
 //- Camera::_EventHandler::OnImageGrabbed()
 //---------------------------
@@ -461,6 +1234,18 @@ void Camera::_EventHandler::OnImageGrabbed(CBaslerUniversalInstantCamera &camera
 					   const CBaslerUniversalGrabResultPtr &ptrGrabResult)
 {
   DEB_MEMBER_FUNCT();
+  if(m_cam.m_grab_thread_cpus_pending)
+    m_cam._applyGrabThreadCpus();
+  double cpu_start = _get_thread_cpu_time();
+  // the acquisition state is published whatever the way out
+  struct _Publisher
+  {
+    _Publisher(Camera& cam) : m_cam(cam),error_code(0) {}
+    ~_Publisher() {m_cam._publishFrame(error_code);}
+    Camera&	m_cam;
+    int		error_code;
+  } publisher(m_cam);
+  m_last_frame_nb = -1;
   try
     {
       if(m_cam.m_video_flag_mode)
@@ -469,16 +1254,34 @@ void Camera::_EventHandler::OnImageGrabbed(CBaslerUniversalInstantCamera &camera
 	  m_cam.m_video->getVideoMode(mode);
 	  if(ptrGrabResult->GrabSucceeded())
 	    {
-	      m_cam.m_video->callNewImage((char*)ptrGrabResult->GetBuffer(),
-					  ptrGrabResult->GetWidth(),
-					  ptrGrabResult->GetHeight(),
-					  mode);
-	      ++m_cam.m_image_number;
+	      if(m_cam.m_video_lend_mode)
+		{
+		  if(!m_cam.m_video_lender->lend(ptrGrabResult,mode))
+		    {
+		      AutoMutex aLock(m_cam.m_accounting_mutex);
+		      ++m_cam.m_nb_video_lend_drops;
+		    }
+		}
+	      else
+		m_cam.m_video->callNewImage((char*)ptrGrabResult->GetBuffer(),
+					    ptrGrabResult->GetWidth(),
+					    ptrGrabResult->GetHeight(),
+					    mode);
+	      if(_analysing())
+		{
+		  auto frame_tick = ptrGrabResult->GetTimeStamp();
+		  if(!m_cam.m_image_number)
+		    m_cam.m_tick_start = frame_tick;
+		  _analyse_frame(ptrGrabResult,m_cam.m_image_number,
+				 double(frame_tick - m_cam.m_tick_start) / m_cam.m_tick_frequency);
+		}
+	      m_last_frame_nb = m_cam.m_image_number++;
 	    }
         else
         {
             // Error handling
             DEB_ERROR() << "GeniCam Error! "<< ptrGrabResult->GetErrorDescription();
+            publisher.error_code = int(ptrGrabResult->GetErrorCode());
         }
      
 	}
@@ -489,25 +1292,49 @@ void Camera::_EventHandler::OnImageGrabbed(CBaslerUniversalInstantCamera &camera
 	      // Access the image data.
 	      uint8_t* pImageBuffer = (uint8_t*) ptrGrabResult->GetBuffer();
 
-	      _check_missing_frame(ptrGrabResult);
+	      // late and duplicated frames are dropped
+	      if(!_check_missing_frame(ptrGrabResult))
+		return;
+	      // not the blank frames given for the missed ones
+	      m_last_frame_nb = -1;
 
 	      auto frame_tick = ptrGrabResult->GetTimeStamp();
 	      if(!m_cam.m_image_number)
 		m_cam.m_tick_start = frame_tick;
 
+	      if(m_cam.m_sequencer_mode)
+		_tag_sequence_set(ptrGrabResult);
+
 	      HwFrameInfoType frame_info;
 	      double tick_diff = frame_tick - m_cam.m_tick_start;
 	      frame_info.frame_timestamp = tick_diff / m_cam.m_tick_frequency;
 	      DEB_TRACE() << DEB_VAR3(frame_tick,tick_diff,frame_info.frame_timestamp);
+	      if(m_cam.m_hdr_mode)
+		{
+		  _merge_hdr_frame(pImageBuffer,frame_info.frame_timestamp);
+		  return;
+		}
+	      if(_overrun_drop())
+		return;
 	      frame_info.acq_frame_nb = m_cam.m_image_number;
+	      m_cam._markMissedFrame(frame_info.acq_frame_nb,false);
 	      void *framePt = m_buffer_mgr.getFrameBufferPtr(m_cam.m_image_number);
 	      const FrameDim& fDim = m_buffer_mgr.getFrameDim();
 	      void* srcPt = ((char*)pImageBuffer);
 	      DEB_TRACE() << "memcpy:" << DEB_VAR2(srcPt,framePt);
 	      memcpy(framePt,srcPt,fDim.getMemSize());
 
-	      if(!m_buffer_mgr.newFrameReady(frame_info))
-		m_cam._stopAcq(true);
+	      if(m_cam.m_preview_mode)
+		m_cam.m_preview.tap(ptrGrabResult,frame_info.acq_frame_nb,fDim.getImageType());
+
+	      // refused: stopped by the overrun policy or dropped,
+	      // the next frame gets the number
+	      if(!_new_frame_ready(frame_info))
+		return;
+
+	      // from the grab buffer, lima has the frame already
+	      if(_analysing())
+		_analyse_frame(ptrGrabResult,frame_info.acq_frame_nb,frame_info.frame_timestamp);
 
 	      ++m_cam.m_image_number;
 	    }
@@ -515,6 +1342,7 @@ void Camera::_EventHandler::OnImageGrabbed(CBaslerUniversalInstantCamera &camera
         {
             // Error handling
             DEB_ERROR() << "GeniCam Error! "<< ptrGrabResult->GetErrorDescription();
+            publisher.error_code = int(ptrGrabResult->GetErrorCode());
         }
 	}
     }
@@ -523,51 +1351,312 @@ void Camera::_EventHandler::OnImageGrabbed(CBaslerUniversalInstantCamera &camera
       // Error handling
       DEB_ERROR() << "GeniCam Error! "<< e.GetDescription();
       m_cam._setStatus(Camera::Fault, true);
+      publisher.error_code = -1;
     }
+  if(ptrGrabResult->GrabSucceeded())
+    m_cam._accountFrame(ptrGrabResult->GetPayloadSize(),
+			_get_thread_cpu_time() - cpu_start);
 }
 
-void Camera::_EventHandler::_check_missing_frame(const CBaslerUniversalGrabResultPtr &ptrGrabResult)
+//---------------------------
+//- Camera::_EventHandler::OnCameraEvent()
+//---------------------------
+void Camera::_EventHandler::OnCameraEvent(CBaslerUniversalInstantCamera &camera,
+					  intptr_t userProvidedId,
+					  GenApi::INode* pNode)
 {
   DEB_MEMBER_FUNCT();
-  
-  if(!m_cam.m_is_usb) // GigE Camera
+  try
     {
-      auto block_id = ptrGrabResult->GetBlockID();
-      if(block_id)	// 0 -> not available for this camera
+      switch(userProvidedId)
 	{
-	  ++m_block_id;
-	  if(!m_block_id) ++m_block_id; // overflow to 0
-	  if(block_id != m_block_id) // missed a frame
-	    {
-	      DEB_WARNING() << "Missed frame expected : "
-			    << m_block_id
-			    << " get : "
-			    << block_id;
-	      if(m_cam.m_blank_image_for_missed)
-		{
-		  unsigned short missed_frames = block_id - m_block_id;
-		  if(m_block_id > block_id)  --missed_frames; // overflow
-		  //missing frames are blank
-		  for(int i = 0;i < missed_frames;++i)
-		    {
-		      void *framePt = m_buffer_mgr.getFrameBufferPtr(m_cam.m_image_number);
-		      const FrameDim& fDim = m_buffer_mgr.getFrameDim();
-		      memset(framePt,0,fDim.getMemSize());
-		      HwFrameInfoType frame_info;
-		      frame_info.acq_frame_nb = m_cam.m_image_number;
-		      DEB_WARNING() << "Frame " << m_cam.m_image_number << " is blank";
-		      if(!m_buffer_mgr.newFrameReady(frame_info))
-			{
-			  m_cam._stopAcq(true);
-			  break;
-			}
-		      ++m_cam.m_image_number;
-		    }
-		}
-	      m_block_id = block_id;
-	    }
+	case FrameStartWaitEvent:
+	  m_cam._softTriggerReadyEvent();	break;
+	case ExposureEndEvent:
+	  m_cam._exposureEndEvent();		break;
+	default:
+	  break;
+	}
+    }
+  catch (Pylon::GenericException &e)
+    {
+      DEB_ERROR() << "GeniCam Error! "<< e.GetDescription();
+      m_cam._setStatus(Camera::Fault, true);
+    }
+}
+
+//---------------------------
+//- Camera::_EventHandler::_tag_sequence_set()
+//- chunk data if available, else computed from the frame number
+//---------------------------
+void Camera::_EventHandler::_tag_sequence_set(const CBaslerUniversalGrabResultPtr &ptrGrabResult)
+{
+  DEB_MEMBER_FUNCT();
+
+  int set_index;
+  if(m_cam.m_sequence_chunk_available)
+    {
+      if(IsReadable(ptrGrabResult->ChunkSequencerSetActive))
+	set_index = ptrGrabResult->ChunkSequencerSetActive.GetValue();
+      else
+	set_index = ptrGrabResult->ChunkSequenceSetIndex.GetValue();
+    }
+  else if(m_cam.m_sequencer_advance == Camera::AdvanceByFrameCount)
+    set_index = (m_cam.m_image_number / m_cam.m_sequence_set_executions) %
+      m_cam.m_sequence_sets.size();
+  else
+    set_index = -1;
+  m_cam._setFrameSequenceSetIndex(m_cam.m_image_number,set_index);
+}
+
+//---------------------------
+//- Camera::_EventHandler::_analyse_frame()
+//- frame statistics and beam analysis
+//---------------------------
+void Camera::_EventHandler::_analyse_frame(const CBaslerUniversalGrabResultPtr &ptrGrabResult,
+					   int frame_nb,double timestamp)
+{
+  const void* data = ptrGrabResult->GetBuffer();
+  int width = int(ptrGrabResult->GetWidth());
+  int height = int(ptrGrabResult->GetHeight());
+  size_t image_size = ptrGrabResult->GetImageSize();
+  if(m_cam.m_frame_stats.isActive())
+    {
+      m_cam.m_frame_stats.process(data,width,height,image_size,frame_nb,timestamp);
+      if(m_cam.m_auto_exposure_loop)
+	m_cam.m_auto_exposure_loop->notify();
+    }
+  if(m_cam.m_beam_analysis.isActive())
+    m_cam.m_beam_analysis.process(data,width,height,image_size,frame_nb,timestamp);
+}
+
+//---------------------------
+//- Camera::_EventHandler::_merge_hdr_frame()
+//- last exposure of a group gives the lima frame,
+//- false if lima did not take it, the next group gets its number
+//---------------------------
+bool Camera::_EventHandler::_merge_hdr_frame(const void* srcPt,double timestamp)
+{
+  DEB_MEMBER_FUNCT();
+
+  int group_size = m_cam.m_hdr_group_size;
+  int exposure_index = m_cam.m_image_number % group_size;
+  int frame_nb = m_cam.m_image_number / group_size;
+  if(!exposure_index)
+    {
+      m_hdr_timestamp = timestamp;
+      m_cam.m_hdr_merge.reset();
+    }
+  if(srcPt)
+    m_cam.m_hdr_merge.accumulate(exposure_index,srcPt);
+  ++m_cam.m_image_number;
+
+  if(exposure_index == group_size - 1)
+    {
+      HwFrameInfoType frame_info;
+      frame_info.acq_frame_nb = frame_nb;
+      frame_info.frame_timestamp = m_hdr_timestamp;
+      m_cam.m_hdr_merge.merge(m_buffer_mgr.getFrameBufferPtr(frame_nb));
+      DEB_TRACE() << "HDR frame merged: " << DEB_VAR1(frame_nb);
+      if(!_new_frame_ready(frame_info))
+	{
+	  m_cam.m_image_number -= group_size;
+	  return false;
+	}
+    }
+  return true;
+}
+
+//---------------------------
+//- Camera::_EventHandler::_new_frame_ready()
+//- the frames after a blank frame still being cleared go through
+//- the filler thread, lima gets them in order and one at a time;
+//- true if lima took the frame or it is queued, the frame number
+//- is only used up then
+//---------------------------
+bool Camera::_EventHandler::_new_frame_ready(HwFrameInfoType& frame_info)
+{
+  _BlankFiller* filler = m_cam.m_blank_filler;
+  bool ready = (filler && filler->defer(frame_info)) || _deliver_frame(frame_info);
+  m_last_frame_nb = ready ? frame_info.acq_frame_nb : -1;
+  return ready;
+}
+
+//---------------------------
+//- Camera::_EventHandler::_deliver_frame()
+//- false if lima refused the frame: the acquisition is stopped by the
+//- overrun policy or the frame is counted as an overrun drop.
+//- A refused frame leaves the lima control in AcqFault (ProcessingOverun),
+//- the camera side keeps going for the recovery policies
+//---------------------------
+bool Camera::_EventHandler::_deliver_frame(HwFrameInfoType& frame_info)
+{
+  DEB_MEMBER_FUNCT();
+  if(m_buffer_mgr.newFrameReady(frame_info))
+    return true;
+
+  // lima would wait forever for the frames dropped from a finite acquisition
+  Camera::OverrunPolicy policy = m_cam.m_overrun_policy;
+  if(policy == Camera::OverrunStop ||
+     (m_cam.m_nb_frames && policy != Camera::OverrunThrottle))
+    {
+      m_cam._stopAcq(true);
+      return false;
+    }
+
+  DEB_WARNING() << "Overrun at frame " << frame_info.acq_frame_nb << ": "
+		<< DEB_VAR1(policy);
+  bool throttled = policy == Camera::OverrunThrottle && m_cam._throttleFrameRate();
+  AutoMutex aLock(m_cam.m_accounting_mutex);
+  m_cam.m_overrun_active = true;
+  m_cam.m_overrun_throttled = throttled;
+  m_cam.m_overrun_frames = 0;
+  ++m_cam.m_nb_overruns;
+  ++m_cam.m_nb_overrun_drops;
+  return false;
+}
+
+//---------------------------
+//- Camera::_EventHandler::_overrun_drop()
+//- true if the frame is dropped, the overrun state ends after
+//- the recovery frames without new overrun
+//---------------------------
+bool Camera::_EventHandler::_overrun_drop()
+{
+  // set under the lock, the lock is only taken during an overrun
+  if(!m_cam.m_overrun_active.load(std::memory_order_acquire))
+    return false;
+  AutoMutex aLock(m_cam.m_accounting_mutex);
+  int frame_index = m_cam.m_overrun_frames++;
+  if(frame_index >= m_cam.m_overrun_recovery_frames)
+    {
+      m_cam.m_overrun_active = false;
+      return false;
+    }
+
+  bool drop;
+  switch(m_cam.m_overrun_policy)
+    {
+    case Camera::OverrunDecimate:
+      drop = (frame_index + 1) % m_cam.m_overrun_decimation != 0;	break;
+    case Camera::OverrunThrottle:
+      // frame rate at its min: drop the newest
+      drop = !m_cam.m_overrun_throttled;				break;
+    default:
+      drop = true;							break;
+    }
+  if(drop)
+    ++m_cam.m_nb_overrun_drops;
+  return drop;
+}
+
+//---------------------------
+//- Camera::_EventHandler::_block_id_distance()
+//---------------------------
+int64_t Camera::_EventHandler::_block_id_distance(uint64_t from,uint64_t to) const
+{
+  return BlockId::distance(from,to,m_cam.m_block_id_bits);
+}
+
+//---------------------------
+//- Camera::_EventHandler::_next_block_id()
+//---------------------------
+uint64_t Camera::_EventHandler::_next_block_id(uint64_t block_id,long long nb) const
+{
+  return BlockId::next(block_id,nb,m_cam.m_block_id_bits);
+}
+
+//---------------------------
+//- Camera::_EventHandler::_check_missing_frame()
+//- false if the frame is late or duplicated
+//---------------------------
+bool Camera::_EventHandler::_check_missing_frame(const CBaslerUniversalGrabResultPtr &ptrGrabResult)
+{
+  DEB_MEMBER_FUNCT();
+
+  uint64_t block_id = ptrGrabResult->GetBlockID();
+  if(!m_cam.m_is_usb && !block_id)	// GigE: 0 -> not available for this camera
+    {
+      m_block_nb = -1;
+      return true;
+    }
+  if(!m_block_id_started)
+    {
+      m_block_id_started = true;
+      m_block_id = block_id;
+      m_block_nb = 0;
+      return true;
+    }
+
+  int64_t distance = _block_id_distance(m_block_id,block_id);
+  if(distance == 1)
+    {
+      m_block_id = block_id;
+      ++m_block_nb;
+      return true;
+    }
+  if(distance <= 0)
+    {
+      std::deque<uint64_t>::iterator i = std::find(m_missing_block_ids.begin(),
+						   m_missing_block_ids.end(),
+						   block_id);
+      bool late = i != m_missing_block_ids.end();
+      if(late)
+	m_missing_block_ids.erase(i);
+      DEB_WARNING() << (late ? "Late" : "Duplicated") << " frame: " << DEB_VAR2(block_id,m_block_id);
+      m_cam._accountMisorderedFrame(late);
+      return false;
+    }
+
+  long long missed_frames = distance - 1;
+  DEB_WARNING() << "Missed frame expected : "
+		<< _next_block_id(m_block_id)
+		<< " get : "
+		<< block_id;
+  m_cam._accountMissedFrames(missed_frames);
+  for(long long i = max(missed_frames - MISSING_BLOCK_IDS_MAX,0LL);i < missed_frames;++i)
+    m_missing_block_ids.push_back(_next_block_id(m_block_id,i + 1));
+  while(m_missing_block_ids.size() > size_t(MISSING_BLOCK_IDS_MAX))
+    m_missing_block_ids.pop_front();
+  m_block_id = block_id;
+  m_block_nb += distance;
+
+  Camera::MissedFrameMode mode = m_cam.m_missed_frame_mode;
+  if(mode == Camera::MissedIgnore)
+    return true;
+  if(missed_frames > MISSED_FRAMES_MAX)
+    {
+      DEB_WARNING() << "Block id jump, no blank frames: " << DEB_VAR1(missed_frames);
+      return true;
+    }
+  //missing frames are blank
+  for(long long i = 0;i < missed_frames;++i)
+    {
+      if(m_cam.m_hdr_mode)
+	{
+	  // missed exposure does not contribute to the merged frame
+	  if(!_merge_hdr_frame(NULL,m_hdr_timestamp))
+	    break;
+	  continue;
+	}
+      m_cam._markMissedFrame(m_cam.m_image_number,true);
+      if(mode == Camera::MissedMark)
+	{
+	  m_cam.m_blank_filler->fill(m_cam.m_image_number);
+	  ++m_cam.m_image_number;
+	  continue;
 	}
+      void *framePt = m_buffer_mgr.getFrameBufferPtr(m_cam.m_image_number);
+      const FrameDim& fDim = m_buffer_mgr.getFrameDim();
+      memset(framePt,0,fDim.getMemSize());
+      HwFrameInfoType frame_info;
+      frame_info.acq_frame_nb = m_cam.m_image_number;
+      DEB_WARNING() << "Frame " << m_cam.m_image_number << " is blank";
+      if(!_new_frame_ready(frame_info))
+	break;
+      ++m_cam.m_image_number;
     }
+  return true;
 }
 //-----------------------------------------------------
 //
@@ -586,6 +1675,19 @@ void Camera::getDetectorImageSize(Size& size)
 //
 //-----------------------------------------------------
 void Camera::getImageType(ImageType& type)
+{
+    DEB_MEMBER_FUNCT();
+    // in HDR mode lima gets the merged frames
+    if(m_hdr_mode)
+      type = m_hdr_output_type;
+    else
+      _getCameraImageType(type);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_getCameraImageType(ImageType& type)
 {
     DEB_MEMBER_FUNCT();
     PixelFormatEnums ps;
@@ -641,6 +1743,25 @@ void Camera::getImageType(ImageType& type)
 //
 //-----------------------------------------------------
 void Camera::setImageType(ImageType type)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(type);
+    if(HdrMerge::isOutputType(type))
+      {
+	if(!m_hdr_mode)
+	  THROW_HW_ERROR(NotSupported) << "Bpp32 and Bpp32F are only available in HDR mode";
+	m_hdr_output_type = type;
+	return;
+      }
+    if(m_hdr_mode)
+      THROW_HW_ERROR(Error) << "Can't change camera image type while HDR mode is active";
+    _setCameraImageType(type);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_setCameraImageType(ImageType type)
 {
     DEB_MEMBER_FUNCT();
     try
@@ -709,51 +1830,109 @@ void Camera::setTrigMode(TrigMode mode)
 
     if(mode == m_trigger_mode)
       return;			// Nothing to do
+
+    _setTrigMode(mode);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_setTrigMode(TrigMode mode)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(mode);
+
+    // IntTrig variant, frame or burst trigger comes from the camera signal generator
+    bool timer_trigger = mode == IntTrig && m_timer_trigger_mode;
+    bool timer_burst = timer_trigger && m_timer_trigger_burst_count > 1;
     
     try
     {        
-        GenApi::IEnumEntry *enumEntryFrameStart = Camera_->TriggerSelector.GetEntryByName("FrameStart");
-        if(enumEntryFrameStart && GenApi::IsAvailable(enumEntryFrameStart))
-            this->Camera_->TriggerSelector.SetValue( TriggerSelector_FrameStart );
-        else
-            this->Camera_->TriggerSelector.SetValue( TriggerSelector_AcquisitionStart );
+	m_control.command(ControlChannel::Normal,[&]() {
+	    // The burst trigger (AcquisitionStart or FrameBurstStart) is only used
+	    // in ExtTrigSingle and IntTrig timer burst, the frames are then timed by the camera
+	    const char* burst_trigger = _getBurstTriggerSelector();
+	    if(burst_trigger)
+	    {
+		GenApi::IEnumEntry *enumEntryBurst = Camera_->TriggerSelector.GetEntryByName(burst_trigger);
+		this->Camera_->TriggerSelector.SetIntValue(enumEntryBurst->GetValue());
+		if(mode == ExtTrigSingle)
+		{
+		    this->Camera_->TriggerMode.SetValue( TriggerMode_On );
+		    this->Camera_->TriggerSource.SetValue(TriggerSource_Line1);
+		}
+		else if(timer_burst)
+		{
+		    this->Camera_->TriggerMode.SetValue( TriggerMode_On );
+		    _setTimerTriggerSource();
+		}
+		else
+		    this->Camera_->TriggerMode.SetValue( TriggerMode_Off );
+	    }
+	    else if(mode == ExtTrigSingle || timer_burst)
+		THROW_HW_ERROR(NotSupported) << "This camera model does not support burst trigger";
 
-    	if ( mode == IntTrig )
-        {
-            //- INTERNAL
-            this->Camera_->TriggerMode.SetValue( TriggerMode_Off );
-            this->Camera_->ExposureMode.SetValue(ExposureMode_Timed);
-	    // setExposure() can disable FrameRate if latency_time is ~0,
-	    // do not reenable FrameRate here if not required
-	    // and when cold start the camera can have the FrameRate enabled
-	    // from previous acquisition, so disable it if latency is 0
-	    if (m_latency_time >= 1e-6)
-	      this->Camera_->AcquisitionFrameRateEnable.SetValue(true);
+	    GenApi::IEnumEntry *enumEntryFrameStart = Camera_->TriggerSelector.GetEntryByName("FrameStart");
+	    if(enumEntryFrameStart && GenApi::IsAvailable(enumEntryFrameStart))
+		this->Camera_->TriggerSelector.SetValue( TriggerSelector_FrameStart );
 	    else
-	      this->Camera_->AcquisitionFrameRateEnable.SetValue(false);	    
-	}
-        else if ( mode == IntTrigMult )
-        {
-	    this->Camera_->TriggerMode.SetValue(TriggerMode_On);
-	    this->Camera_->TriggerSource.SetValue(TriggerSource_Software);
-            this->Camera_->AcquisitionFrameRateEnable.SetValue( false );
-	    this->Camera_->ExposureMode.SetValue(ExposureMode_Timed);
-        }
-        else if ( mode == ExtGate )
-        {
-            //- EXTERNAL - TRIGGER WIDTH
-            this->Camera_->TriggerMode.SetValue( TriggerMode_On );
-	    this->Camera_->TriggerSource.SetValue(TriggerSource_Line1);
-            this->Camera_->AcquisitionFrameRateEnable.SetValue( false );
-            this->Camera_->ExposureMode.SetValue( ExposureMode_TriggerWidth );
-        }        
-        else //ExtTrigMult
-        {
-            this->Camera_->TriggerMode.SetValue( TriggerMode_On );
-	    this->Camera_->TriggerSource.SetValue(TriggerSource_Line1);
-            this->Camera_->AcquisitionFrameRateEnable.SetValue( false );
-            this->Camera_->ExposureMode.SetValue( ExposureMode_Timed );
-        }
+		this->Camera_->TriggerSelector.SetValue( TriggerSelector_AcquisitionStart );
+
+	    if ( timer_trigger )
+	    {
+		//- INTERNAL - CAMERA SIGNAL GENERATOR
+		_setTimerTriggerPeriod();
+		if ( timer_burst )
+		{
+		    // frames of the burst at the maximum camera rate
+		    this->Camera_->TriggerMode.SetValue( TriggerMode_Off );
+		    setAcquisitionFrameCount(m_timer_trigger_burst_count);
+		}
+		else
+		{
+		    this->Camera_->TriggerMode.SetValue( TriggerMode_On );
+		    _setTimerTriggerSource();
+		}
+		this->Camera_->ExposureMode.SetValue(ExposureMode_Timed);
+		this->Camera_->AcquisitionFrameRateEnable.SetValue( false );
+	    }
+	    else if ( mode == IntTrig || mode == ExtTrigSingle )
+	    {
+		//- INTERNAL
+		this->Camera_->TriggerMode.SetValue( TriggerMode_Off );
+		this->Camera_->ExposureMode.SetValue(ExposureMode_Timed);
+		// setExposure() can disable FrameRate if latency_time is ~0,
+		// do not reenable FrameRate here if not required
+		// and when cold start the camera can have the FrameRate enabled
+		// from previous acquisition, so disable it if latency is 0
+		if (m_latency_time >= 1e-6)
+		  this->Camera_->AcquisitionFrameRateEnable.SetValue(true);
+		else
+		  this->Camera_->AcquisitionFrameRateEnable.SetValue(false);	    
+	    }
+	    else if ( mode == IntTrigMult )
+	    {
+		this->Camera_->TriggerMode.SetValue(TriggerMode_On);
+		this->Camera_->TriggerSource.SetValue(TriggerSource_Software);
+		this->Camera_->AcquisitionFrameRateEnable.SetValue( false );
+		this->Camera_->ExposureMode.SetValue(ExposureMode_Timed);
+	    }
+	    else if ( mode == ExtGate )
+	    {
+		//- EXTERNAL - TRIGGER WIDTH
+		this->Camera_->TriggerMode.SetValue( TriggerMode_On );
+		this->Camera_->TriggerSource.SetValue(TriggerSource_Line1);
+		this->Camera_->AcquisitionFrameRateEnable.SetValue( false );
+		this->Camera_->ExposureMode.SetValue( ExposureMode_TriggerWidth );
+	    }        
+	    else //ExtTrigMult
+	    {
+		this->Camera_->TriggerMode.SetValue( TriggerMode_On );
+		this->Camera_->TriggerSource.SetValue(TriggerSource_Line1);
+		this->Camera_->AcquisitionFrameRateEnable.SetValue( false );
+		this->Camera_->ExposureMode.SetValue( ExposureMode_Timed );
+	    }
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -779,11 +1958,19 @@ void Camera::getTrigMode(TrigMode& mode)
 void Camera::_readTrigMode()
 {
     DEB_MEMBER_FUNCT();
-    int frameStart = TriggerMode_Off, acqStart, expMode;
+    int frameStart = TriggerMode_Off, acqStart, expMode, burstStart = TriggerMode_Off;
     try
     {
         acqStart =  this->Camera_->TriggerMode.GetValue();
 
+        const char* burst_trigger = _getBurstTriggerSelector();
+        if(burst_trigger)
+        {
+            GenApi::IEnumEntry *enumEntryBurst = Camera_->TriggerSelector.GetEntryByName(burst_trigger);
+            this->Camera_->TriggerSelector.SetIntValue(enumEntryBurst->GetValue());
+            burstStart = this->Camera_->TriggerMode.GetValue();
+        }
+
         GenApi::IEnumEntry *enumEntryFrameStart = Camera_->TriggerSelector.GetEntryByName("FrameStart");  
         if(enumEntryFrameStart && GenApi::IsAvailable(enumEntryFrameStart))            
         {
@@ -803,6 +1990,8 @@ void Camera::_readTrigMode()
 	    else
 	      m_trigger_mode = ExtTrigMult;
 	  }
+	else if(burstStart == TriggerMode_On)
+	  m_trigger_mode = ExtTrigSingle;
 	else
 	  m_trigger_mode = IntTrig;
     }
@@ -812,7 +2001,7 @@ void Camera::_readTrigMode()
         THROW_HW_ERROR(Error) << e.GetDescription();
     }        
    	
-    DEB_RETURN() << DEB_VAR4(m_trigger_mode,acqStart, frameStart, expMode);
+    DEB_RETURN() << DEB_VAR5(m_trigger_mode,acqStart, frameStart, burstStart, expMode);
 }
 
 //-----------------------------------------------------
@@ -823,12 +2012,14 @@ void Camera::setTrigActivation(TrigActivation activation)
     DEB_MEMBER_FUNCT();
     try
     {
-        TriggerActivationEnums act =
-            static_cast<TriggerActivationEnums>(activation);
-
-        // If the parameter TriggerActivation is available for this camera
-        if (GenApi::IsAvailable(Camera_->TriggerActivation))
-            Camera_->TriggerActivation.SetValue(act);
+	m_control.command(ControlChannel::Normal,[&]() {
+	    TriggerActivationEnums act =
+		static_cast<TriggerActivationEnums>(activation);
+
+	    // If the parameter TriggerActivation is available for this camera
+	    if (GenApi::IsAvailable(Camera_->TriggerActivation))
+		Camera_->TriggerActivation.SetValue(act);
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -844,13 +2035,15 @@ void Camera::getTrigActivation(TrigActivation& activation) const
     DEB_MEMBER_FUNCT();
     try
     {
-        TriggerActivationEnums act;
+	m_control.command(ControlChannel::Normal,[&]() {
+	    TriggerActivationEnums act;
 
-        // If the parameter AcquisitionFrameCount is available for this camera
-        if (GenApi::IsAvailable(Camera_->TriggerActivation))
-            act = Camera_->TriggerActivation.GetValue();
+	    // If the parameter AcquisitionFrameCount is available for this camera
+	    if (GenApi::IsAvailable(Camera_->TriggerActivation))
+		act = Camera_->TriggerActivation.GetValue();
 
-        activation = static_cast<TrigActivation>(act);
+	    activation = static_cast<TrigActivation>(act);
+	  });
 
     }
     catch (Pylon::GenericException &e)
@@ -873,62 +2066,11 @@ void Camera::setExpTime(double exp_time)
     
     try
     {
-        if(mode !=  ExtGate) { // the expTime can not be set in ExtGate!
-            // ExposureTimeBaseAbs is only available for GigE Ace camera
-            if (IsAvailable(Camera_->ExposureTimeBaseAbs))
-            {
-                //If scout or pilot, exposure time has to be adjusted using
-                // the exposure time base + the exposure time raw.
-                //see ImageGrabber for more details !!!
-                Camera_->ExposureTimeBaseAbs.SetValue(100.0); //- to be sure we can set the Raw setting on the full range (1 .. 4095)
-                double raw = ::ceil(exp_time / 50);
-                Camera_->ExposureTimeRaw.SetValue(static_cast<int> (raw));
-                raw = static_cast<double> (Camera_->ExposureTimeRaw.GetValue());
-                Camera_->ExposureTimeBaseAbs.SetValue(1E6 * (exp_time / raw));
-                DEB_TRACE() << "raw = " << raw;
-                DEB_TRACE() << "ExposureTimeBaseAbs = " << (1E6 * (exp_time / raw));			
-            }
-            else
-            {
-	      if (IsAvailable(Camera_->ExposureTime) || m_is_usb)
-                    Camera_->ExposureTime.SetValue(1E6 * exp_time);
-                else
-                    Camera_->ExposureTimeAbs.SetValue(1E6 * exp_time);
-            }
-        }
-        
+      // not merged, m_exp_time follows each call
+      m_control.command(ControlChannel::Normal,[&]() {
+        _writeExpTime(exp_time,mode);
         m_exp_time = exp_time;
-
-        // set the frame rate using expo time + latency
-        if (m_latency_time < 1e-6) // Max camera speed
-        {
-            Camera_->AcquisitionFrameRateEnable.SetValue(false);
-        }
-        else
-        {
-            double rate = 1/ (m_latency_time + m_exp_time);
-            Camera_->AcquisitionFrameRateEnable.SetValue(true);
-            DEB_TRACE() << DEB_VAR1(rate);
-	    if (IsAvailable(Camera_->AcquisitionFrameRate) || m_is_usb)
-	    {
-	        double minrate = Camera_->AcquisitionFrameRate.GetMin();
-	        double maxrate = Camera_->AcquisitionFrameRate.GetMax();
-		if (rate < minrate) rate = minrate;
-		if (rate > maxrate) rate = maxrate;
-	        Camera_->AcquisitionFrameRate.SetValue(rate);
-		DEB_TRACE() << DEB_VAR1(Camera_->AcquisitionFrameRate.GetValue());
-	    }
-            else
-	    {
-	        double minrate = Camera_->AcquisitionFrameRateAbs.GetMin();
-	        double maxrate = Camera_->AcquisitionFrameRateAbs.GetMax();
-		if (rate < minrate) rate = minrate;
-		if (rate > maxrate) rate = maxrate;
-	        Camera_->AcquisitionFrameRateAbs.SetValue(rate);
-		DEB_TRACE() << DEB_VAR1(Camera_->AcquisitionFrameRateAbs.GetValue());
-	    }            
-        }
-
+      });
     }
     catch (Pylon::GenericException &e)
     {
@@ -938,17 +2080,107 @@ void Camera::setExpTime(double exp_time)
 }
 
 //-----------------------------------------------------
-//
+// exposure time and frame rate nodes, from the control channel
 //-----------------------------------------------------
-void Camera::getExpTime(double& exp_time)
+void Camera::_writeExpTime(double exp_time,TrigMode mode)
 {
     DEB_MEMBER_FUNCT();
-    try
+    if(mode !=  ExtGate) { // the expTime can not be set in ExtGate!
+	// ExposureTimeBaseAbs is only available for GigE Ace camera
+	if (IsAvailable(Camera_->ExposureTimeBaseAbs))
+	{
+	    //If scout or pilot, exposure time has to be adjusted using
+	    // the exposure time base + the exposure time raw.
+	    //see ImageGrabber for more details !!!
+	    Camera_->ExposureTimeBaseAbs.SetValue(100.0); //- to be sure we can set the Raw setting on the full range (1 .. 4095)
+	    double raw = ::ceil(exp_time / 50);
+	    Camera_->ExposureTimeRaw.SetValue(static_cast<int> (raw));
+	    raw = static_cast<double> (Camera_->ExposureTimeRaw.GetValue());
+	    Camera_->ExposureTimeBaseAbs.SetValue(1E6 * (exp_time / raw));
+	    DEB_TRACE() << "raw = " << raw;
+	    DEB_TRACE() << "ExposureTimeBaseAbs = " << (1E6 * (exp_time / raw));			
+	}
+	else
+	{
+	  if (IsAvailable(Camera_->ExposureTime) || m_is_usb)
+		Camera_->ExposureTime.SetValue(1E6 * exp_time);
+	    else
+		Camera_->ExposureTimeAbs.SetValue(1E6 * exp_time);
+	}
+	// read by the event thread to date the exposure start
+	m_camera_exp_time.store(exp_time,std::memory_order_relaxed);
+    }
+
+    // set the frame rate using expo time + latency
+    // with timer trigger the rate comes from the signal generator period
+    bool timer_trigger = mode == IntTrig && m_timer_trigger_mode;
+    if (m_latency_time < 1e-6 || timer_trigger) // Max camera speed
     {
-        double value = 1.0E-6 * static_cast<double>(Camera_->ExposureTime.GetValue());    
-        exp_time = value;
+	Camera_->AcquisitionFrameRateEnable.SetValue(false);
     }
-    catch (Pylon::GenericException &e)
+    else
+    {
+	double rate = 1/ (m_latency_time + exp_time);
+	Camera_->AcquisitionFrameRateEnable.SetValue(true);
+	DEB_TRACE() << DEB_VAR1(rate);
+	if (IsAvailable(Camera_->AcquisitionFrameRate) || m_is_usb)
+	{
+	    double minrate = Camera_->AcquisitionFrameRate.GetMin();
+	    double maxrate = Camera_->AcquisitionFrameRate.GetMax();
+	    if (rate < minrate) rate = minrate;
+	    if (rate > maxrate) rate = maxrate;
+	    Camera_->AcquisitionFrameRate.SetValue(rate);
+	    DEB_TRACE() << DEB_VAR1(Camera_->AcquisitionFrameRate.GetValue());
+	}
+	else
+	{
+	    double minrate = Camera_->AcquisitionFrameRateAbs.GetMin();
+	    double maxrate = Camera_->AcquisitionFrameRateAbs.GetMax();
+	    if (rate < minrate) rate = minrate;
+	    if (rate > maxrate) rate = maxrate;
+	    Camera_->AcquisitionFrameRateAbs.SetValue(rate);
+	    DEB_TRACE() << DEB_VAR1(Camera_->AcquisitionFrameRateAbs.GetValue());
+	}            
+    }
+}
+
+//-----------------------------------------------------
+// the auto exposure loop exposure time, m_exp_time stays the one of lima
+//-----------------------------------------------------
+void Camera::_setLoopExpTime(double exp_time)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(exp_time);
+    TrigMode mode;
+    getTrigMode(mode);
+    try
+    {
+      // only the latest of the pending loop exposure times is set,
+      // the write only sets the nodes
+      m_control.write(ControlChannel::Normal,"AutoExposureTime",[this,exp_time,mode]() {
+        _writeExpTime(exp_time,mode);
+      });
+    }
+    catch (Pylon::GenericException &e)
+    {
+        // Error handling
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getExpTime(double& exp_time)
+{
+    DEB_MEMBER_FUNCT();
+    try
+    {
+        exp_time = m_control.read<double>(ControlChannel::Normal,"ExposureTime",[this]() {
+	    return 1.0E-6 * static_cast<double>(Camera_->ExposureTime.GetValue());
+	  });
+    }
+    catch (Pylon::GenericException &e)
     {
         // Error handling
         THROW_HW_ERROR(Error) << e.GetDescription();
@@ -985,45 +2217,47 @@ void Camera::getExposureTimeRange(double& min_expo, double& max_expo) const
 
     try
     {
-        // Pilot and and Scout do not have TimeAbs capability
-        // ExposureTimeBaseAbs is available fot GigE cams only
-        if (IsAvailable(Camera_->ExposureTimeBaseAbs) && !m_is_usb)
-        {
-            // memorize initial value of exposure time
-            DEB_TRACE() << "memorize initial value of exposure time";
-            int initial_raw = Camera_->ExposureTimeRaw.GetValue();
-            DEB_TRACE() << "initial_raw = " << initial_raw;
-            double initial_base = Camera_->ExposureTimeBaseAbs.GetValue();
-            DEB_TRACE() << "initial_base = " << initial_base;
-
-            DEB_TRACE() << "compute Min/Max allowed values of exposure time";
-            // fix raw/base in order to get the Max of Exposure            
-            Camera_->ExposureTimeBaseAbs.SetValue(Camera_->ExposureTimeBaseAbs.GetMax());
-            max_expo = 1E-06 * Camera_->ExposureTimeBaseAbs.GetValue() * Camera_->ExposureTimeRaw.GetMax();
-            DEB_TRACE() << "max_expo = " << max_expo << " (s)";
-
-            // fix raw/base in order to get the Min of Exposure            
-            Camera_->ExposureTimeBaseAbs.SetValue(Camera_->ExposureTimeBaseAbs.GetMin());
-            min_expo = 1E-06 * Camera_->ExposureTimeBaseAbs.GetValue() * Camera_->ExposureTimeRaw.GetMin();
-            DEB_TRACE() << "min_expo = " << min_expo << " (s)";
-
-            // reload initial value of exposure time
-            Camera_->ExposureTimeBaseAbs.SetValue(initial_base);
-            Camera_->ExposureTimeRaw.SetValue(initial_raw);
-
-            DEB_TRACE() << "initial value of exposure time was reloaded";
-        }
-        else
-        {
-	  if (IsAvailable(Camera_->ExposureTime) || m_is_usb) {
-                min_expo = Camera_->ExposureTime.GetMin()*1e-6;
-                max_expo = Camera_->ExposureTime.GetMax()*1e-6;
-            } else {
-                min_expo = Camera_->ExposureTimeAbs.GetMin()*1e-6;
-                max_expo = Camera_->ExposureTimeAbs.GetMax()*1e-6;
-            }
+	m_control.command(ControlChannel::Normal,[&]() {
+	    // Pilot and and Scout do not have TimeAbs capability
+	    // ExposureTimeBaseAbs is available fot GigE cams only
+	    if (IsAvailable(Camera_->ExposureTimeBaseAbs) && !m_is_usb)
+	    {
+		// memorize initial value of exposure time
+		DEB_TRACE() << "memorize initial value of exposure time";
+		int initial_raw = Camera_->ExposureTimeRaw.GetValue();
+		DEB_TRACE() << "initial_raw = " << initial_raw;
+		double initial_base = Camera_->ExposureTimeBaseAbs.GetValue();
+		DEB_TRACE() << "initial_base = " << initial_base;
+
+		DEB_TRACE() << "compute Min/Max allowed values of exposure time";
+		// fix raw/base in order to get the Max of Exposure            
+		Camera_->ExposureTimeBaseAbs.SetValue(Camera_->ExposureTimeBaseAbs.GetMax());
+		max_expo = 1E-06 * Camera_->ExposureTimeBaseAbs.GetValue() * Camera_->ExposureTimeRaw.GetMax();
+		DEB_TRACE() << "max_expo = " << max_expo << " (s)";
+
+		// fix raw/base in order to get the Min of Exposure            
+		Camera_->ExposureTimeBaseAbs.SetValue(Camera_->ExposureTimeBaseAbs.GetMin());
+		min_expo = 1E-06 * Camera_->ExposureTimeBaseAbs.GetValue() * Camera_->ExposureTimeRaw.GetMin();
+		DEB_TRACE() << "min_expo = " << min_expo << " (s)";
+
+		// reload initial value of exposure time
+		Camera_->ExposureTimeBaseAbs.SetValue(initial_base);
+		Camera_->ExposureTimeRaw.SetValue(initial_raw);
+
+		DEB_TRACE() << "initial value of exposure time was reloaded";
+	    }
+	    else
+	    {
+	      if (IsAvailable(Camera_->ExposureTime) || m_is_usb) {
+		    min_expo = Camera_->ExposureTime.GetMin()*1e-6;
+		    max_expo = Camera_->ExposureTime.GetMax()*1e-6;
+		} else {
+		    min_expo = Camera_->ExposureTimeAbs.GetMin()*1e-6;
+		    max_expo = Camera_->ExposureTimeAbs.GetMax()*1e-6;
+		}
             
-        }
+	    }
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1101,7 +2335,8 @@ void Camera::getNbFrames(int& nb_frames)
 void Camera::getNbHwAcquiredFrames(int &nb_acq_frames)
 { 
     DEB_MEMBER_FUNCT();    
-    nb_acq_frames = m_image_number;
+    nb_acq_frames = m_acq_state.image_number.load(std::memory_order_acquire) /
+      m_hdr_group_size;
 }
   
 //-----------------------------------------------------
@@ -1110,26 +2345,48 @@ void Camera::getNbHwAcquiredFrames(int &nb_acq_frames)
 void Camera::getStatus(Camera::Status& status)
 {
     DEB_MEMBER_FUNCT();
-    AutoMutex aLock(m_cond.mutex());
-    status = m_status;
-    aLock.unlock();
-    if(status != Camera::Fault)
-      status = Camera_->IsGrabbing() ? Camera::Exposure : Camera::Ready;
-    //Check if camera is not waiting for trigger
+    // Exposure from the first startAcq to the stop or the last grab result
+    status = Camera::Status(m_acq_state.status.load(std::memory_order_acquire));
+    //Check if camera is not waiting for trigger, not lock free
     if((m_trigger_mode == IntTrigMult ||
 	m_trigger_mode == ExtTrigMult ||
 	m_trigger_mode == ExtGate) &&
        status == Camera::Exposure)
       {
-	// Check the frame start trigger acquisition status
-	// Set the acquisition status selector
-	Camera_->AcquisitionStatusSelector.SetValue
-	  (AcquisitionStatusSelector_FrameTriggerWait);
-	// Read the acquisition status
-	bool IsWaitingForFrameTrigger = Camera_->AcquisitionStatus.GetValue();
+	bool IsWaitingForFrameTrigger;
+	// event driven software trigger already knows if the camera is waiting
+	if(m_trigger_mode == IntTrigMult && m_soft_trigger_event_mode)
+	  isReadyForSoftTrigger(IsWaitingForFrameTrigger);
+	else
+	  // selector and status read in one request
+	  IsWaitingForFrameTrigger = m_control.read<bool>
+	    (ControlChannel::Normal,"FrameTriggerWait",[this]() {
+	      // Check the frame start trigger acquisition status
+	      // Set the acquisition status selector
+	      Camera_->AcquisitionStatusSelector.SetValue
+		(AcquisitionStatusSelector_FrameTriggerWait);
+	      // Read the acquisition status
+	      return bool(Camera_->AcquisitionStatus.GetValue());
+	    });
 	status = IsWaitingForFrameTrigger ? Camera::WaitForTrigger : status;
 	DEB_TRACE() << DEB_VAR1(IsWaitingForFrameTrigger);
       }
+    else if(m_trigger_mode == ExtTrigSingle && status == Camera::Exposure)
+      {
+	bool IsWaitingForBurstTrigger = m_control.read<bool>
+	  (ControlChannel::Normal,"BurstTriggerWait",[this]() {
+	    // Check the burst trigger acquisition status
+	    if(Camera_->GetSfncVersion() >= Sfnc_2_0_0)
+	      Camera_->AcquisitionStatusSelector.SetValue
+		(AcquisitionStatusSelector_FrameBurstTriggerWait);
+	    else
+	      Camera_->AcquisitionStatusSelector.SetValue
+		(AcquisitionStatusSelector_AcquisitionTriggerWait);
+	    return bool(Camera_->AcquisitionStatus.GetValue());
+	  });
+	status = IsWaitingForBurstTrigger ? Camera::WaitForTrigger : status;
+	DEB_TRACE() << DEB_VAR1(IsWaitingForBurstTrigger);
+      }
     DEB_RETURN() << DEB_VAR1(status);
 }
 
@@ -1139,23 +2396,146 @@ void Camera::getStatus(Camera::Status& status)
 void Camera::_setStatus(Camera::Status status,bool force)
 {
     DEB_MEMBER_FUNCT();
-    AutoMutex aLock(m_cond.mutex());
-    if(force || m_status != Camera::Fault)
-        m_status = status;
-    m_cond.broadcast();
+    // a Fault is only cleared when forced
+    int current = m_acq_state.status.load(std::memory_order_relaxed);
+    while((force || current != Camera::Fault) &&
+	  !m_acq_state.status.compare_exchange_weak(current,status,
+						    std::memory_order_release));
+}
+
+//-----------------------------------------------------
+// seqlock reader, retried while the grab thread writes
+//-----------------------------------------------------
+void Camera::getAcqState(AcqState& state) const
+{
+    DEB_MEMBER_FUNCT();
+    const _AcqStateBlock& block = m_acq_state;
+    unsigned before,after;
+    do
+      {
+	before = block.sequence.load(std::memory_order_acquire);
+	state.image_number = block.image_number.load(std::memory_order_relaxed);
+	state.last_frame_time = block.last_frame_time.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	after = block.sequence.load(std::memory_order_relaxed);
+      }
+    while((before & 1) || before != after);
+    state.acq_started = block.acq_started.load(std::memory_order_acquire);
+    state.status = Camera::Status(block.status.load(std::memory_order_acquire));
+    state.error_code = block.error_code.load(std::memory_order_relaxed);
+    state.nb_frames = state.image_number / m_hdr_group_size;
+    state.last_frame_age = state.last_frame_time > 0. ?
+      double(Timestamp::now()) - state.last_frame_time : -1.;
+    DEB_RETURN() << DEB_VAR3(state.image_number,state.status,state.error_code);
+}
+
+//-----------------------------------------------------
+// grab thread, at the end of each frame callback
+//-----------------------------------------------------
+void Camera::_publishFrame(int error_code)
+{
+    _AcqStateBlock& block = m_acq_state;
+    unsigned sequence = block.sequence.load(std::memory_order_relaxed);
+    block.sequence.store(sequence + 1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    block.image_number.store(m_image_number,std::memory_order_relaxed);
+    block.last_frame_time.store(double(Timestamp::now()),std::memory_order_relaxed);
+    block.sequence.store(sequence + 2,std::memory_order_release);
+    if(error_code)
+      block.error_code.store(error_code,std::memory_order_relaxed);
+    // Pylon stops grabbing after the requested number of results, failed,
+    // late, duplicated or dropped ones included
+    ++m_nb_grab_results;
+    if(m_nb_frames && m_nb_grab_results >= m_nb_frames * m_hdr_group_size)
+      _setStatus(Camera::Ready,false);
+}
+
+//-----------------------------------------------------
+// grab thread, frame given to lima by the last grab result
+//-----------------------------------------------------
+int Camera::_getLastFrameNb() const
+{
+    return m_event_handler->m_last_frame_nb;
+}
+
+//-----------------------------------------------------
+// grab thread, block ids since the first frame, -1 if not available
+//-----------------------------------------------------
+long long Camera::_getLastBlockNb() const
+{
+    return m_event_handler->m_block_nb;
+}
+
+//-----------------------------------------------------
+// prepareAcq, the grab thread is idle
+//-----------------------------------------------------
+void Camera::_resetAcqState()
+{
+    _AcqStateBlock& block = m_acq_state;
+    unsigned sequence = block.sequence.load(std::memory_order_relaxed);
+    block.sequence.store(sequence + 1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    block.image_number.store(0,std::memory_order_relaxed);
+    block.last_frame_time.store(0.,std::memory_order_relaxed);
+    block.sequence.store(sequence + 2,std::memory_order_release);
+    block.error_code.store(0,std::memory_order_relaxed);
+    block.acq_started.store(false,std::memory_order_release);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Camera::AcqState::AcqState() :
+  acq_started(false),
+  status(Camera::Ready),
+  image_number(0),
+  nb_frames(0),
+  last_frame_time(0.),
+  last_frame_age(-1.),
+  error_code(0)
+{
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Camera::_AcqStateBlock::_AcqStateBlock() :
+  sequence(0),
+  image_number(0),
+  last_frame_time(0.),
+  status(Camera::Ready),
+  error_code(0),
+  acq_started(false)
+{
 }
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
 void Camera::getFrameRate(double& frame_rate) const
+{
+    DEB_MEMBER_FUNCT();
+    std::shared_ptr<const Telemetry> telemetry = _getCachedTelemetry();
+    if(telemetry)
+      frame_rate = telemetry->frame_rate;
+    else
+      _readFrameRate(frame_rate);
+    DEB_RETURN() << DEB_VAR1(frame_rate);
+}
+
+//-----------------------------------------------------
+// live ResultingFrameRate
+//-----------------------------------------------------
+void Camera::_readFrameRate(double& frame_rate) const
 {
     DEB_MEMBER_FUNCT();
     try
     {
-        if (GenApi::IsAvailable(Camera_->ResultingFrameRate) || m_is_usb)
-            frame_rate = static_cast<double>(Camera_->ResultingFrameRate.GetValue());        
-        else 
-            frame_rate = static_cast<double>(Camera_->ResultingFrameRateAbs.GetValue());        
+        frame_rate = m_control.read<double>(ControlChannel::Normal,"ResultingFrameRate",[this]() {
+	    if (GenApi::IsAvailable(Camera_->ResultingFrameRate) || m_is_usb)
+	      return static_cast<double>(Camera_->ResultingFrameRate.GetValue());
+	    else
+	      return static_cast<double>(Camera_->ResultingFrameRateAbs.GetValue());
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1171,7 +2551,7 @@ void Camera::setBlankImageForMissed(bool active)
 {
   /** This will create blank images when missing an image.
    */
-  m_blank_image_for_missed = active;
+  setMissedFrameMode(active ? MissedBlank : MissedIgnore);
 }
 //-----------------------------------------------------
 //
@@ -1228,39 +2608,43 @@ void Camera::setRoi(const Roi& ask_roi)
     Roi r;    
     try
     {
-        //- backup old roi, in order to rollback if error
-        getRoi(r);
-        if(r == ask_roi) return;
+	m_control.command(ControlChannel::Normal,[&]() {
+	    //- backup old roi, in order to rollback if error
+	    getRoi(r);
+	    if(r == ask_roi) return;
         
-        //- first reset the ROI
-        Camera_->OffsetX.SetValue(Camera_->OffsetX.GetMin());
-        Camera_->OffsetY.SetValue(Camera_->OffsetY.GetMin());
-        Camera_->Width.SetValue(Camera_->Width.GetMax());
-        Camera_->Height.SetValue(Camera_->Height.GetMax());
+	    //- first reset the ROI
+	    Camera_->OffsetX.SetValue(Camera_->OffsetX.GetMin());
+	    Camera_->OffsetY.SetValue(Camera_->OffsetY.GetMin());
+	    Camera_->Width.SetValue(Camera_->Width.GetMax());
+	    Camera_->Height.SetValue(Camera_->Height.GetMax());
         
-        Roi fullFrame(  Camera_->OffsetX.GetMin(),
-			Camera_->OffsetY.GetMin(),
-			Camera_->Width.GetMax(),
-			Camera_->Height.GetMax());
+	    Roi fullFrame(  Camera_->OffsetX.GetMin(),
+			    Camera_->OffsetY.GetMin(),
+			    Camera_->Width.GetMax(),
+			    Camera_->Height.GetMax());
 
-        if(ask_roi.isActive() && fullFrame != ask_roi)
-	{
-            //- then fix the new ROI
-            Camera_->Width.SetValue(ask_roi.getSize().getWidth());
-            Camera_->Height.SetValue(ask_roi.getSize().getHeight());
-            Camera_->OffsetX.SetValue(ask_roi.getTopLeft().x);
-            Camera_->OffsetY.SetValue(ask_roi.getTopLeft().y);
-        }
+	    if(ask_roi.isActive() && fullFrame != ask_roi)
+	    {
+		//- then fix the new ROI
+		Camera_->Width.SetValue(ask_roi.getSize().getWidth());
+		Camera_->Height.SetValue(ask_roi.getSize().getHeight());
+		Camera_->OffsetX.SetValue(ask_roi.getTopLeft().x);
+		Camera_->OffsetY.SetValue(ask_roi.getTopLeft().y);
+	    }
+	  });
     }
     catch (Pylon::GenericException &e)
     {
         try
         {
-            //-  rollback the old roi
-            Camera_->Width.SetValue( r.getSize().getWidth());
-            Camera_->Height.SetValue(r.getSize().getHeight());
-            Camera_->OffsetX.SetValue(r.getTopLeft().x);
-            Camera_->OffsetY.SetValue(r.getTopLeft().y);
+	    m_control.command(ControlChannel::Normal,[&]() {
+		//-  rollback the old roi
+		Camera_->Width.SetValue( r.getSize().getWidth());
+		Camera_->Height.SetValue(r.getSize().getHeight());
+		Camera_->OffsetX.SetValue(r.getTopLeft().x);
+		Camera_->OffsetY.SetValue(r.getTopLeft().y);
+	      });
             // Error handling
         }
         catch (Pylon::GenericException &e2)
@@ -1280,13 +2664,15 @@ void Camera::getRoi(Roi& hw_roi)
     DEB_MEMBER_FUNCT();
     try
     {
-        Roi  r( static_cast<int>(Camera_->OffsetX()),
-                static_cast<int>(Camera_->OffsetY()),
-                static_cast<int>(Camera_->Width())    ,
-                static_cast<int>(Camera_->Height())
-        );
+	m_control.command(ControlChannel::Normal,[&]() {
+	    Roi  r( static_cast<int>(Camera_->OffsetX()),
+		    static_cast<int>(Camera_->OffsetY()),
+		    static_cast<int>(Camera_->Width())    ,
+		    static_cast<int>(Camera_->Height())
+	    );
         
-        hw_roi = r;
+	    hw_roi = r;
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1328,8 +2714,10 @@ void Camera::setBin(const Bin &aBin)
     DEB_MEMBER_FUNCT();
     try
     {
-        Camera_->BinningVertical.SetValue(aBin.getY());
-        Camera_->BinningHorizontal.SetValue(aBin.getX());
+	m_control.command(ControlChannel::Normal,[&]() {
+	    Camera_->BinningVertical.SetValue(aBin.getY());
+	    Camera_->BinningHorizontal.SetValue(aBin.getX());
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1347,7 +2735,9 @@ void Camera::getBin(Bin &aBin)
     DEB_MEMBER_FUNCT();
     try
     {
-      aBin = Bin(Camera_->BinningHorizontal.GetValue(), Camera_->BinningVertical.GetValue());
+      m_control.command(ControlChannel::Normal,[&]() {
+	  aBin = Bin(Camera_->BinningHorizontal.GetValue(), Camera_->BinningVertical.GetValue());
+	});
     }
     catch (Pylon::GenericException &e)
     {
@@ -1409,7 +2799,9 @@ void Camera::setPacketSize(int isize)
     DEB_TRACE()<<"setPacketSize : "<<isize;
     try
     {
-        Camera_->GevSCPSPacketSize.SetValue(isize);
+	m_control.command(ControlChannel::Normal,[&]() {
+	    Camera_->GevSCPSPacketSize.SetValue(isize);
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1433,6 +2825,91 @@ void Camera::getPacketSize(int& isize)
     }
 }
 
+//-----------------------------------------------------
+// negotiatePacketSize
+// The largest packet size of the path is negotiated by the stream grabber
+// (AutoPacketSize, test packets sent with the don't fragment bit) when it
+// opens, the result is cached per serial number for the next opens.
+//-----------------------------------------------------
+void Camera::negotiatePacketSize(int& packet_size,bool use_cache)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(use_cache);
+    if(m_is_usb)
+      THROW_HW_ERROR(NotSupported) << "Packet size negotiation is only for GigE cameras";
+
+    std::string serial_number = Camera_->GetDeviceInfo().GetSerialNumber().c_str();
+    packet_size = 0;
+    if(use_cache)
+      {
+	AutoMutex lock(_packet_size_cache_mutex);
+	std::map<std::string,int>::iterator i = _packet_size_cache.find(serial_number);
+	if(i != _packet_size_cache.end())
+	  packet_size = i->second;
+      }
+
+    try
+    {
+        int max_packet_size = Camera_->GevSCPSPacketSize.GetMax();
+        if(packet_size)
+	  {
+	    DEB_TRACE() << "Cached packet size for " << serial_number;
+	    Camera_->GevSCPSPacketSize.SetValue(packet_size);
+	  }
+	else if(IsWritable(Camera_->GetStreamGrabberParams().AutoPacketSize))
+	  {
+	    if(Camera_->IsGrabbing())
+	      THROW_HW_ERROR(Error) << "Can't negotiate the packet size while grabbing";
+	    // the stream grabber of the camera negotiates when grabbing starts,
+	    // no frame is exposed meanwhile: the frame trigger waits for software
+	    Camera_->TriggerSelector.SetValue(TriggerSelector_FrameStart);
+	    TriggerModeEnums trigger_mode = Camera_->TriggerMode.GetValue();
+	    TriggerSourceEnums trigger_source = Camera_->TriggerSource.GetValue();
+	    Camera_->TriggerMode.SetValue(TriggerMode_On);
+	    Camera_->TriggerSource.SetValue(TriggerSource_Software);
+	    Camera_->GetStreamGrabberParams().AutoPacketSize.SetValue(true);
+	    try
+	      {
+		Camera_->StartGrabbing(GrabStrategy_OneByOne,GrabLoop_ProvidedByUser);
+		Camera_->StopGrabbing();
+	      }
+	    catch (Pylon::GenericException &e)
+	      {
+		Camera_->GetStreamGrabberParams().AutoPacketSize.SetValue(false);
+		Camera_->TriggerSource.SetValue(trigger_source);
+		Camera_->TriggerMode.SetValue(trigger_mode);
+		throw;
+	      }
+	    // no new negotiation on each acquisition start
+	    Camera_->GetStreamGrabberParams().AutoPacketSize.SetValue(false);
+	    Camera_->TriggerSource.SetValue(trigger_source);
+	    Camera_->TriggerMode.SetValue(trigger_mode);
+	    packet_size = Camera_->GevSCPSPacketSize.GetValue();
+
+	    AutoMutex lock(_packet_size_cache_mutex);
+	    _packet_size_cache[serial_number] = packet_size;
+	  }
+	else
+	  {
+	    packet_size = min(STANDARD_PACKET_SIZE,max_packet_size);
+	    DEB_WARNING() << "Packet size negotiation not available, "
+			  << "using standard packet size " << packet_size;
+	    Camera_->GevSCPSPacketSize.SetValue(packet_size);
+	  }
+
+	if(packet_size <= STANDARD_PACKET_SIZE && max_packet_size > STANDARD_PACKET_SIZE)
+	  DEB_WARNING() << "Jumbo frames not available to camera " << serial_number
+			<< ": packet size " << packet_size << " (camera max " << max_packet_size
+			<< "), check the MTU of the network interface and switches";
+    }
+    catch (Pylon::GenericException &e)
+    {
+        THROW_HW_ERROR(Error) << "Packet size negotiation failed: " << e.GetDescription();
+    }
+    DEB_ALWAYS() << "Packet size " << packet_size << " for camera " << serial_number;
+    DEB_RETURN() << DEB_VAR1(packet_size);
+}
+
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
@@ -1443,7 +2920,9 @@ void Camera::setInterPacketDelay(int ipd)
     DEB_TRACE()<<"setInterPacketDelay : "<<ipd;
     try
     {
-        Camera_->GevSCPD.SetValue(ipd);
+	m_control.command(ControlChannel::Normal,[&]() {
+	    Camera_->GevSCPD.SetValue(ipd);
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1501,9 +2980,17 @@ bool Camera::isAutoGainAvailable() const
 void Camera::getBandwidthAssigned(int& ipd)
 {
     DEB_MEMBER_FUNCT();
+    std::shared_ptr<const Telemetry> telemetry = _getCachedTelemetry();
+    if(telemetry)
+      {
+	ipd = telemetry->bandwidth_assigned;
+	return;
+      }
     try
     {
-        ipd = Camera_->GevSCBWA.GetValue();
+        ipd = int(m_control.read<int64_t>(ControlChannel::Normal,"GevSCBWA",[this]() {
+	    return int64_t(Camera_->GevSCBWA.GetValue());
+	  }));
     }
     catch (Pylon::GenericException &e)
     {
@@ -1516,9 +3003,17 @@ void Camera::getBandwidthAssigned(int& ipd)
 void Camera::getMaxThroughput(int& ipd)
 {
     DEB_MEMBER_FUNCT();
+    std::shared_ptr<const Telemetry> telemetry = _getCachedTelemetry();
+    if(telemetry)
+      {
+	ipd = telemetry->max_throughput;
+	return;
+      }
     try
     {
-        ipd = Camera_->GevSCDMT.GetValue();
+        ipd = int(m_control.read<int64_t>(ControlChannel::Normal,"GevSCDMT",[this]() {
+	    return int64_t(Camera_->GevSCDMT.GetValue());
+	  }));
     }
     catch (Pylon::GenericException &e)
     {
@@ -1526,15 +3021,47 @@ void Camera::getMaxThroughput(int& ipd)
     }
 }    
 
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBandwidthLoad(BandwidthPlanner::CameraLoad& load) const
+{
+    DEB_MEMBER_FUNCT();
+    if(m_is_usb)
+      THROW_HW_ERROR(NotSupported) << "Bandwidth planning is only for GigE cameras";
+    try
+    {
+        load.payload_size = Camera_->PayloadSize.GetValue();
+        load.packet_size = Camera_->GevSCPSPacketSize.GetValue();
+        load.max_throughput = Camera_->GevSCDMT.GetValue();
+        load.tick_frequency = m_tick_frequency;
+        _readFrameRate(load.frame_rate);
+    }
+    catch (Pylon::GenericException &e)
+    {
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+    DEB_RETURN() << DEB_VAR4(load.payload_size,load.packet_size,
+			     load.max_throughput,load.frame_rate);
+}
+
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
 void Camera::getCurrentThroughput(int& ipd)
 {
     DEB_MEMBER_FUNCT();
+    std::shared_ptr<const Telemetry> telemetry = _getCachedTelemetry();
+    if(telemetry)
+      {
+	ipd = telemetry->current_throughput;
+	return;
+      }
     try
     {
-        ipd = Camera_->GevSCDCT.GetValue();
+        ipd = int(m_control.read<int64_t>(ControlChannel::Normal,"GevSCDCT",[this]() {
+	    return int64_t(Camera_->GevSCDCT.GetValue());
+	  }));
     }
     catch (Pylon::GenericException &e)
     {
@@ -1557,8 +3084,15 @@ bool Camera::isTemperatureAvailable() const
 void Camera::getTemperature(double& temperature)
 {
     DEB_MEMBER_FUNCT();
+    std::shared_ptr<const Telemetry> telemetry = _getCachedTelemetry();
+    if(telemetry)
+      {
+	temperature = telemetry->temperature;
+	return;
+      }
     try
     {
+      m_control.command(ControlChannel::Normal,[&]() {
         // If the parameter TemperatureAbs is available for this camera
         if (GenApi::IsAvailable(Camera_->TemperatureAbs))
             temperature = Camera_->TemperatureAbs.GetValue();
@@ -1566,6 +3100,7 @@ void Camera::getTemperature(double& temperature)
 	// to change measurement DeviceTemperatureSelector should be call
 	else if (IsAvailable(Camera_->DeviceTemperature))
 	  temperature = Camera_->DeviceTemperature.GetValue();
+      });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1634,37 +3169,19 @@ void Camera::setGain(double gain)
 {
     DEB_MEMBER_FUNCT();
     DEB_PARAM() << DEB_VAR1(gain);
-    int raw_gain, low_limit, high_limit;
     if (gain < 0. || gain > 1.)
       THROW_HW_ERROR(InvalidValue) << "Gain must be in range <0.0,1.0>";
     try
     {
+      // not merged, it also turns the auto gain off
+      m_control.command(ControlChannel::Normal,[&]() {
         // you want to set the gain, remove autogain
         if (GenApi::IsAvailable(Camera_->GainAuto))
         {		
 	    setAutoGain(false);
 	}
-
-	if (Camera_->GetSfncVersion() >= Sfnc_2_0_0) {
-	    Camera_->GainSelector.SetValue(GainSelector_All);
-	    
-            low_limit = Camera_->Gain.GetMin();
-            high_limit = Camera_->Gain.GetMax();
-            raw_gain = int((high_limit - low_limit) * gain + low_limit);
-            Camera_->Gain.SetValue(raw_gain);
-        }
-        else
-        {
-            Camera_->GainSelector.SetValue(GainSelector_All);
-	    
-            low_limit = Camera_->GainRaw.GetMin();
-            high_limit = Camera_->GainRaw.GetMax();
-            raw_gain = int((high_limit - low_limit) * gain + low_limit);
-            Camera_->GainRaw.SetValue(raw_gain);
-        }
-	DEB_TRACE() << "low_limit   = " << low_limit;
-	DEB_TRACE() << "high_limit = " << high_limit;
-	DEB_TRACE() << "raw_gain    = " << raw_gain;
+	_writeGain(gain);
+      });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1673,6 +3190,59 @@ void Camera::setGain(double gain)
     }
 }
 
+//-----------------------------------------------------
+// gain nodes, from the control channel
+//-----------------------------------------------------
+void Camera::_writeGain(double gain)
+{
+    DEB_MEMBER_FUNCT();
+    int raw_gain, low_limit, high_limit;
+    if (Camera_->GetSfncVersion() >= Sfnc_2_0_0) {
+	Camera_->GainSelector.SetValue(GainSelector_All);
+
+	low_limit = Camera_->Gain.GetMin();
+	high_limit = Camera_->Gain.GetMax();
+	raw_gain = int((high_limit - low_limit) * gain + low_limit);
+	Camera_->Gain.SetValue(raw_gain);
+    }
+    else
+    {
+	Camera_->GainSelector.SetValue(GainSelector_All);
+
+	low_limit = Camera_->GainRaw.GetMin();
+	high_limit = Camera_->GainRaw.GetMax();
+	raw_gain = int((high_limit - low_limit) * gain + low_limit);
+	Camera_->GainRaw.SetValue(raw_gain);
+    }
+    DEB_TRACE() << "low_limit   = " << low_limit;
+    DEB_TRACE() << "high_limit = " << high_limit;
+    DEB_TRACE() << "raw_gain    = " << raw_gain;
+}
+
+//-----------------------------------------------------
+// the auto exposure loop gain, the auto gain setting is left as is
+//-----------------------------------------------------
+void Camera::_setLoopGain(double gain)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(gain);
+    if (gain < 0. || gain > 1.)
+      THROW_HW_ERROR(InvalidValue) << "Gain must be in range <0.0,1.0>";
+    try
+    {
+      // only the latest of the pending loop gains is set, its own key
+      // keeps a pending user gain out of the merge
+      m_control.write(ControlChannel::Normal,"AutoGain",[this,gain]() {
+        _writeGain(gain);
+      });
+    }
+    catch (Pylon::GenericException &e)
+    {
+        // Error handling
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+}
+
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
@@ -1683,6 +3253,7 @@ void Camera::getGain(double& gain) const
     
     try
     {
+      m_control.command(ControlChannel::Normal,[&]() {
         if (Camera_->GetSfncVersion() >= Sfnc_2_0_0) {
             raw_gain = Camera_->Gain.GetValue();
 	    low_limit = Camera_->Gain.GetMin();
@@ -1692,6 +3263,7 @@ void Camera::getGain(double& gain) const
             low_limit = Camera_->GainRaw.GetMin();
 	    high_limit = Camera_->GainRaw.GetMax();
         }
+      });
 	DEB_TRACE() << "low_limit = " << low_limit;
 	DEB_TRACE() << "high_limit = " << high_limit;
 	DEB_TRACE() << "raw_gain    = " << raw_gain;
@@ -1714,8 +3286,10 @@ void Camera::setFrameTransmissionDelay(int ftd)
     DEB_PARAM() << DEB_VAR1(ftd);
     try
     {
-        if (!m_is_usb)
-            Camera_->GevSCFTD.SetValue(ftd);
+	m_control.command(ControlChannel::Normal,[&]() {
+	    if (!m_is_usb)
+		Camera_->GevSCFTD.SetValue(ftd);
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1733,7 +3307,9 @@ void Camera::setAcquisitionFrameRateEnable(bool AFRE)
     DEB_PARAM() << DEB_VAR1(AFRE);
     try
     {
-        Camera_->AcquisitionFrameRateEnable.SetValue(AFRE);
+	m_control.command(ControlChannel::Normal,[&]() {
+	    Camera_->AcquisitionFrameRateEnable.SetValue(AFRE);
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1778,7 +3354,9 @@ void Camera::setAcquisitionFrameRateAbs(int AFRA)
     DEB_PARAM() << DEB_VAR1(AFRA);
     try
     {
-        Camera_->AcquisitionFrameRateAbs.SetValue(AFRA);
+	m_control.command(ControlChannel::Normal,[&]() {
+	    Camera_->AcquisitionFrameRateAbs.SetValue(AFRA);
+	  });
     }
     catch (Pylon::GenericException &e)
     {
@@ -1849,8 +3427,6 @@ void Camera::setOutput1LineSource(Camera::LineSource source)
     {
        THROW_HW_ERROR(NotSupported) << "This camera model does not support LineSource and/or LineSelector";
     }
-  
-  Camera_->LineSelector.SetValue(LineSelector_Out1);
 
   LineSourceEnums line_src;
   switch(source)
@@ -1882,7 +3458,11 @@ void Camera::setOutput1LineSource(Camera::LineSource source)
     default:
       THROW_HW_ERROR(NotSupported) << "Not yet supported";
     }
-  Camera_->LineSource.SetValue(line_src);
+  // the selector and the source must not be interleaved with another line access
+  m_control.command(ControlChannel::Normal,[&]() {
+      Camera_->LineSelector.SetValue(LineSelector_Out1);
+      Camera_->LineSource.SetValue(line_src);
+    });
 }
 
 void Camera::getOutput1LineSource(Camera::LineSource& source) const
@@ -1894,9 +3474,12 @@ void Camera::getOutput1LineSource(Camera::LineSource& source) const
       source = Off;
       return;
     }
-      
-  Camera_->LineSelector.SetValue(LineSelector_Out1);
-  switch(Camera_->LineSource.GetValue())
+
+  LineSourceEnums line_src = m_control.read<LineSourceEnums>(ControlChannel::Normal,"LineSource",[this]() {
+      Camera_->LineSelector.SetValue(LineSelector_Out1);
+      return Camera_->LineSource.GetValue();
+    });
+  switch(line_src)
     {
     case LineSource_Off:			source = Off;				break;
     case LineSource_ExposureActive:		source = ExposureActive;		break;
@@ -1930,20 +3513,29 @@ void Camera::getOutput1LineSource(Camera::LineSource& source) const
 }
 
 //-----------------------------------------------------
-//
+// a burst of the wrong length would leave lima waiting
+// or drop frames, a failed write is an error
 //-----------------------------------------------------
 void Camera::setAcquisitionFrameCount(int AFC)
 {
     DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(AFC);
     try
     {
         // If the parameter AcquisitionFrameCount is available for this camera
         if (GenApi::IsAvailable(Camera_->AcquisitionFrameCount))
             Camera_->AcquisitionFrameCount.SetValue(AFC);
+        // SFNC 2.0 cameras count frames per FrameBurstStart trigger
+        else if (GenApi::IsAvailable(Camera_->AcquisitionBurstFrameCount))
+            Camera_->AcquisitionBurstFrameCount.SetValue(AFC);
+        else
+            THROW_HW_ERROR(NotSupported) << "This camera model has no burst frame count";
     }
     catch (Pylon::GenericException &e)
     {
-        DEB_WARNING() << e.GetDescription();
+        // Error handling
+        THROW_HW_ERROR(Error) << "Burst frame count " << AFC << " failed: "
+			      << e.GetDescription();
     }
 }
 
@@ -1958,6 +3550,8 @@ void Camera::getAcquisitionFrameCount(int& AFC) const
         // If the parameter AcquisitionFrameCount is available for this camera
         if (GenApi::IsAvailable(Camera_->AcquisitionFrameCount))
            AFC = Camera_->AcquisitionFrameCount.GetValue();
+        else if (GenApi::IsAvailable(Camera_->AcquisitionBurstFrameCount))
+           AFC = Camera_->AcquisitionBurstFrameCount.GetValue();
     }
     catch (Pylon::GenericException &e)
     {
@@ -1965,71 +3559,390 @@ void Camera::getAcquisitionFrameCount(int& AFC) const
     }
 }
 
-//---------------------------
-// The Total Buffer Count will count the number of all buffers with "status == succeeded" and "status == failed". 
-// That means, all successfully and all incompletely grabbed (error code: 0xE1000014) buffers. 
-// That means, the Failed Buffer Count will also be included into this number.
-//---------------------------
-void Camera::getStatisticsTotalBufferCount(long& count)
+//-----------------------------------------------------
+// Periodic signal generator used as trigger source
+// for the IntTrig timer variant, NULL if none
+//-----------------------------------------------------
+const char* Camera::_getTimerTriggerSource() const
 {
-	DEB_MEMBER_FUNCT();
-	count = Camera_->GetStreamGrabberParams().Statistic_Total_Buffer_Count.GetValue();
+    GenApi::IEnumEntry *anEntry = Camera_->TriggerSource.GetEntryByName("PeriodicSignal1");
+    if(anEntry && GenApi::IsAvailable(anEntry))
+      return "PeriodicSignal1";
+    return NULL;
 }
 
-//---------------------------    
-// The Failed Buffer Count will count only buffers, which were received with "status == failed". 
-// That means, buffers that were incompletely grabbed (error code: 0xE1000014).
-//---------------------------
-void Camera::getStatisticsFailedBufferCount(long& count)
+//-----------------------------------------------------
+// TriggerSelector must be set by the caller
+//-----------------------------------------------------
+void Camera::_setTimerTriggerSource()
 {
-	DEB_MEMBER_FUNCT();
-	count = Camera_->GetStreamGrabberParams().Statistic_Failed_Buffer_Count.GetValue();
+    DEB_MEMBER_FUNCT();
+    const char* source = _getTimerTriggerSource();
+    if(!source)
+      THROW_HW_ERROR(NotSupported) << "This camera model does not support timer trigger";
+    GenApi::IEnumEntry *anEntry = Camera_->TriggerSource.GetEntryByName(source);
+    this->Camera_->TriggerSource.SetIntValue(anEntry->GetValue());
+    if (GenApi::IsAvailable(Camera_->TriggerActivation))
+      this->Camera_->TriggerActivation.SetValue(TriggerActivation_RisingEdge);
+    DEB_TRACE() << "Trigger source: " << source;
 }
-//---------------------------    
 
+//-----------------------------------------------------
+// Program the signal generator with the trigger period
+//-----------------------------------------------------
+void Camera::_setTimerTriggerPeriod()
+{
+    DEB_MEMBER_FUNCT();
+    const char* source = _getTimerTriggerSource();
+    if(!source)
+      THROW_HW_ERROR(NotSupported) << "This camera model does not support timer trigger";
+
+    Camera_->PeriodicSignalSelector.SetValue(PeriodicSignalSelector_PeriodicSignal1);
+    Camera_->PeriodicSignalPeriod.SetValue(1E6 * m_timer_trigger_period);
+    Camera_->PeriodicSignalDelay.SetValue(0.);
+    if(m_timer_trigger_period < m_exp_time)
+      DEB_WARNING() << "Timer trigger period shorter than exposure time, triggers will be lost";
+}
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::setTestImageSelector(TestImageSelector sel)
+bool Camera::isTimerTriggerAvailable() const
 {
     DEB_MEMBER_FUNCT();
-
-    if (GenApi::IsAvailable(Camera_->TestImageSelector))
-      {
-	THROW_HW_ERROR(NotSupported) << "This camera model does not support TestImageSelector";
-      }
-
+    bool isAvailable = false;
     try
     {
-        TestImageSelectorEnums test =
-	  static_cast<TestImageSelectorEnums>(sel);
-	Camera_->TestImageSelector.SetValue(test);
+	isAvailable = _getTimerTriggerSource() != NULL;
     }
     catch (Pylon::GenericException &e)
     {
         DEB_WARNING() << e.GetDescription();
     }
+    DEB_RETURN() << DEB_VAR1(isAvailable);
+    return isAvailable;
 }
 
 //-----------------------------------------------------
 //
 //-----------------------------------------------------
-void Camera::getTestImageSelector(TestImageSelector& sel) const
+void Camera::setTimerTriggerMode(bool active)
 {
     DEB_MEMBER_FUNCT();
-    try
-    {
-        TestImageSelectorEnums test;
-
-        // If the parameter TestImage is available for this camera
-        if (GenApi::IsAvailable(Camera_->TestImageSelector))
-	  {
-            test = Camera_->TestImageSelector.GetValue();
-	    sel = static_cast<TestImageSelector>(test);
-	  }
-	else
-	  sel = TestImage_Off;
+    DEB_PARAM() << DEB_VAR1(active);
+    if(active && !isTimerTriggerAvailable())
+      THROW_HW_ERROR(NotSupported) << "This camera model does not support timer trigger";
+
+    m_timer_trigger_mode = active;
+    // IntTrig already set, reprogram it
+    if(m_trigger_mode == IntTrig)
+      _setTrigMode(IntTrig);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getTimerTriggerMode(bool& active) const
+{
+    DEB_MEMBER_FUNCT();
+    active = m_timer_trigger_mode;
+    DEB_RETURN() << DEB_VAR1(active);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setTimerTriggerPeriod(double period)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(period);
+    if(period <= 0.)
+      THROW_HW_ERROR(InvalidValue) << "Timer trigger period must be > 0";
+
+    m_timer_trigger_period = period;
+    if(m_trigger_mode == IntTrig && m_timer_trigger_mode)
+      _setTrigMode(IntTrig);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getTimerTriggerPeriod(double& period) const
+{
+    DEB_MEMBER_FUNCT();
+    period = m_timer_trigger_period;
+    DEB_RETURN() << DEB_VAR1(period);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setTimerTriggerBurstCount(int nb_frames)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_frames);
+    if(nb_frames < 1)
+      THROW_HW_ERROR(InvalidValue) << "Timer trigger burst count must be >= 1";
+
+    m_timer_trigger_burst_count = nb_frames;
+    if(m_trigger_mode == IntTrig && m_timer_trigger_mode)
+      _setTrigMode(IntTrig);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getTimerTriggerBurstCount(int& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    nb_frames = m_timer_trigger_burst_count;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+// Trigger which starts a burst of frames, NULL if the
+// camera only has one trigger used as frame trigger
+//-----------------------------------------------------
+const char* Camera::_getBurstTriggerSelector() const
+{
+    if(!_is_trigger_available(Camera_,"FrameStart"))
+      return NULL;
+    else if(_is_trigger_available(Camera_,"FrameBurstStart"))
+      return "FrameBurstStart";
+    else if(_is_trigger_available(Camera_,"AcquisitionStart"))
+      return "AcquisitionStart";
+    else
+      return NULL;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool Camera::isExtTrigSingleAvailable() const
+{
+    DEB_MEMBER_FUNCT();
+    bool isAvailable = false;
+    try
+    {
+	isAvailable = _getBurstTriggerSelector() != NULL;
+    }
+    catch (Pylon::GenericException &e)
+    {
+        DEB_WARNING() << e.GetDescription();
+    }
+    DEB_RETURN() << DEB_VAR1(isAvailable);
+    return isAvailable;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_getBurstFrameCountMax(int& max_frame_count) const
+{
+    DEB_MEMBER_FUNCT();
+    try
+    {
+        if (GenApi::IsAvailable(Camera_->AcquisitionFrameCount))
+	    max_frame_count = Camera_->AcquisitionFrameCount.GetMax();
+        else if (GenApi::IsAvailable(Camera_->AcquisitionBurstFrameCount))
+	    max_frame_count = Camera_->AcquisitionBurstFrameCount.GetMax();
+	else
+	    max_frame_count = 1;
+    }
+    catch (Pylon::GenericException &e)
+    {
+        // Error handling
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+    DEB_RETURN() << DEB_VAR1(max_frame_count);
+}
+
+//---------------------------
+// The Total Buffer Count will count the number of all buffers with "status == succeeded" and "status == failed". 
+// That means, all successfully and all incompletely grabbed (error code: 0xE1000014) buffers. 
+// That means, the Failed Buffer Count will also be included into this number.
+//---------------------------
+void Camera::getStatisticsTotalBufferCount(long& count)
+{
+	DEB_MEMBER_FUNCT();
+	count = long(m_control.read<int64_t>(ControlChannel::Background,"TotalBufferCount",[this]() {
+	    return int64_t(Camera_->GetStreamGrabberParams().Statistic_Total_Buffer_Count.GetValue());
+	  }));
+}
+
+//---------------------------    
+// The Failed Buffer Count will count only buffers, which were received with "status == failed". 
+// That means, buffers that were incompletely grabbed (error code: 0xE1000014).
+//---------------------------
+void Camera::getStatisticsFailedBufferCount(long& count)
+{
+	DEB_MEMBER_FUNCT();
+	count = long(m_control.read<int64_t>(ControlChannel::Background,"FailedBufferCount",[this]() {
+	    return int64_t(Camera_->GetStreamGrabberParams().Statistic_Failed_Buffer_Count.GetValue());
+	  }));
+}
+
+//---------------------------
+//
+//---------------------------
+Camera::StreamStatistics::StreamStatistics() :
+  total_buffers(-1),
+  failed_buffers(-1),
+  buffer_underruns(-1),
+  total_packets(-1),
+  lost_packets(-1),
+  resend_requests(-1),
+  resent_packets(-1),
+  missed_frames(-1),
+  usb_resyncs(-1),
+  last_failed_buffer_status(-1),
+  elapsed(0.),
+  buffer_rate(0.),
+  failed_buffer_rate(0.),
+  lost_packet_rate(0.),
+  resend_request_rate(0.),
+  resent_packet_rate(0.)
+{
+}
+
+template<class Node>
+static inline long long _read_statistic(Node& node)
+{
+  return IsReadable(node) ? (long long)node.GetValue() : -1;
+}
+
+// counter since the reset, restarted with the stream grabber
+static inline long long _statistic_delta(long long value,long long base)
+{
+  return (value < 0 || base < 0 || value < base) ? value : value - base;
+}
+
+static inline double _statistic_rate(long long count,double elapsed)
+{
+  return (count > 0 && elapsed > 0.) ? count / elapsed : 0.;
+}
+
+//---------------------------
+// raw counters of the stream grabber
+//---------------------------
+void Camera::_readStreamStatistics(StreamStatistics& stats) const
+{
+  DEB_MEMBER_FUNCT();
+  try
+    {
+      m_control.command(ControlChannel::Background,[&]() {
+	  auto& params = Camera_->GetStreamGrabberParams();
+	  stats.total_buffers = _read_statistic(params.Statistic_Total_Buffer_Count);
+	  stats.failed_buffers = _read_statistic(params.Statistic_Failed_Buffer_Count);
+	  stats.last_failed_buffer_status = _read_statistic(params.Statistic_Last_Failed_Buffer_Status);
+	  if(m_is_usb)
+	    {
+	      stats.missed_frames = _read_statistic(params.Statistic_Missed_Frame_Count);
+	      stats.usb_resyncs = _read_statistic(params.Statistic_Resynchronization_Count);
+	    }
+	  else
+	    {
+	      stats.buffer_underruns = _read_statistic(params.Statistic_Buffer_Underrun_Count);
+	      stats.total_packets = _read_statistic(params.Statistic_Total_Packet_Count);
+	      stats.lost_packets = _read_statistic(params.Statistic_Failed_Packet_Count);
+	      stats.resend_requests = _read_statistic(params.Statistic_Resend_Request_Count);
+	      stats.resent_packets = _read_statistic(params.Statistic_Resend_Packet_Count);
+	    }
+	});
+    }
+  catch (Pylon::GenericException &e)
+    {
+      THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+}
+
+//---------------------------
+// one snapshot of the statistics with the rates since the reset
+//---------------------------
+void Camera::getStreamStatistics(StreamStatistics& stats) const
+{
+  DEB_MEMBER_FUNCT();
+  _readStreamStatistics(stats);
+
+  AutoMutex aLock(m_accounting_mutex);
+  const StreamStatistics& base = m_stream_statistics_base;
+  stats.total_buffers = _statistic_delta(stats.total_buffers,base.total_buffers);
+  stats.failed_buffers = _statistic_delta(stats.failed_buffers,base.failed_buffers);
+  stats.buffer_underruns = _statistic_delta(stats.buffer_underruns,base.buffer_underruns);
+  stats.total_packets = _statistic_delta(stats.total_packets,base.total_packets);
+  stats.lost_packets = _statistic_delta(stats.lost_packets,base.lost_packets);
+  stats.resend_requests = _statistic_delta(stats.resend_requests,base.resend_requests);
+  stats.resent_packets = _statistic_delta(stats.resent_packets,base.resent_packets);
+  stats.missed_frames = _statistic_delta(stats.missed_frames,base.missed_frames);
+  stats.usb_resyncs = _statistic_delta(stats.usb_resyncs,base.usb_resyncs);
+  if(m_stream_statistics_start.isSet())
+    stats.elapsed = Timestamp::now() - m_stream_statistics_start;
+  aLock.unlock();
+
+  stats.buffer_rate = _statistic_rate(stats.total_buffers,stats.elapsed);
+  stats.failed_buffer_rate = _statistic_rate(stats.failed_buffers,stats.elapsed);
+  stats.lost_packet_rate = _statistic_rate(stats.lost_packets,stats.elapsed);
+  stats.resend_request_rate = _statistic_rate(stats.resend_requests,stats.elapsed);
+  stats.resent_packet_rate = _statistic_rate(stats.resent_packets,stats.elapsed);
+  DEB_RETURN() << DEB_VAR4(stats.total_buffers,stats.failed_buffers,
+			   stats.lost_packets,stats.resend_requests);
+}
+
+//---------------------------
+// Pylon counters are read only, the reset keeps their current values
+//---------------------------
+void Camera::resetStreamStatistics()
+{
+  DEB_MEMBER_FUNCT();
+  StreamStatistics base;
+  _readStreamStatistics(base);
+  AutoMutex aLock(m_accounting_mutex);
+  m_stream_statistics_base = base;
+  m_stream_statistics_start = Timestamp::now();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setTestImageSelector(TestImageSelector sel)
+{
+    DEB_MEMBER_FUNCT();
+
+    if (GenApi::IsAvailable(Camera_->TestImageSelector))
+      {
+	THROW_HW_ERROR(NotSupported) << "This camera model does not support TestImageSelector";
+      }
+
+    try
+    {
+        TestImageSelectorEnums test =
+	  static_cast<TestImageSelectorEnums>(sel);
+	Camera_->TestImageSelector.SetValue(test);
+    }
+    catch (Pylon::GenericException &e)
+    {
+        DEB_WARNING() << e.GetDescription();
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getTestImageSelector(TestImageSelector& sel) const
+{
+    DEB_MEMBER_FUNCT();
+    try
+    {
+        TestImageSelectorEnums test;
+
+        // If the parameter TestImage is available for this camera
+        if (GenApi::IsAvailable(Camera_->TestImageSelector))
+	  {
+            test = Camera_->TestImageSelector.GetValue();
+	    sel = static_cast<TestImageSelector>(test);
+	  }
+	else
+	  sel = TestImage_Off;
 
     }
     catch (Pylon::GenericException &e)
@@ -2037,3 +3950,2880 @@ void Camera::getTestImageSelector(TestImageSelector& sel) const
         DEB_WARNING() << e.GetDescription();
     }
 }
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool Camera::isSoftTriggerEventAvailable() const
+{
+    return m_soft_trigger_event_available;
+}
+
+//-----------------------------------------------------
+// Event driven software trigger: each FrameStartWait event
+// gives one trigger slot, each software trigger consumes one.
+//-----------------------------------------------------
+void Camera::setSoftTriggerEventMode(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+
+    if(active && !m_soft_trigger_event_available)
+      THROW_HW_ERROR(NotSupported) << "This camera model does not support FrameStartWait and/or ExposureEnd events";
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change software trigger mode while acquisition is running";
+
+    try
+    {
+	if(m_soft_trigger_event_available)
+	  _enableSoftTriggerEvents(active);
+    }
+    catch (Pylon::GenericException &e)
+    {
+        // Error handling
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+    m_soft_trigger_event_mode = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSoftTriggerEventMode(bool& active) const
+{
+    DEB_MEMBER_FUNCT();
+    active = m_soft_trigger_event_mode;
+    DEB_RETURN() << DEB_VAR1(active);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setSoftTriggerQueueSize(int nb_triggers)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_triggers);
+    if(nb_triggers < 0)
+      THROW_HW_ERROR(InvalidValue) << "Software trigger queue size must be >= 0";
+
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    m_soft_trigger_queue_size = nb_triggers;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSoftTriggerQueueSize(int& nb_triggers) const
+{
+    DEB_MEMBER_FUNCT();
+    nb_triggers = m_soft_trigger_queue_size;
+    DEB_RETURN() << DEB_VAR1(nb_triggers);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::isReadyForSoftTrigger(bool& ready)
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    ready = (m_soft_trigger_ready_count > m_soft_trigger_sent &&
+	     !m_soft_trigger_pending);
+    DEB_RETURN() << DEB_VAR1(ready);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSoftTriggerLatency(int frame_nb, double& latency)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(frame_nb);
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    int nb_kept = int(m_soft_triggers.size());
+    if(frame_nb < 0 || frame_nb >= m_soft_trigger_sent ||
+       frame_nb < m_soft_trigger_sent - nb_kept ||
+       m_soft_triggers[frame_nb % nb_kept].latency < 0.)
+      THROW_HW_ERROR(InvalidValue) << "No trigger latency for frame " << frame_nb;
+    latency = m_soft_triggers[frame_nb % nb_kept].latency;
+    DEB_RETURN() << DEB_VAR1(latency);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSoftTriggerLatencies(std::vector<double>& latencies)
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    int nb_kept = int(m_soft_triggers.size());
+    latencies.clear();
+    for(int trigger_nb = max(0,m_soft_trigger_sent - nb_kept);
+	trigger_nb < m_soft_trigger_sent;++trigger_nb)
+      latencies.push_back(m_soft_triggers[trigger_nb % nb_kept].latency);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_enableSoftTriggerEvents(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+
+    const char* events[] = {"FrameStartWait", "ExposureEnd"};
+    for(unsigned int i = 0;i < sizeof(events) / sizeof(events[0]);++i)
+      {
+	GenApi::IEnumEntry *anEntry = Camera_->EventSelector.GetEntryByName(events[i]);
+	Camera_->EventSelector.SetIntValue(anEntry->GetValue());
+	if(!active)
+	  Camera_->EventNotification.SetValue(EventNotification_Off);
+	// GigE cameras use On, USB cameras GenICamEvent
+	else if(!Camera_->EventNotification.TrySetValue(EventNotification_On))
+	  Camera_->EventNotification.SetValue(EventNotification_GenICamEvent);
+      }
+}
+
+//-----------------------------------------------------
+// if the camera is ready and no trigger is queued, trigger now;
+// else queue the trigger or wait for the FrameStartWait event
+// if the queue is full.
+//-----------------------------------------------------
+void Camera::_sendSoftTrigger()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    while(m_soft_trigger_ready_count <= m_soft_trigger_sent || m_soft_trigger_pending)
+      {
+	if(m_soft_trigger_pending < m_soft_trigger_queue_size)
+	  {
+	    ++m_soft_trigger_pending;
+	    DEB_TRACE() << "Trigger queued: " << DEB_VAR1(m_soft_trigger_pending);
+	    return;
+	  }
+	if(!m_soft_trigger_cond.wait(1.) || m_soft_trigger_stopped)
+	  THROW_HW_ERROR(Error) << "Wait ready for trigger failed: "
+				<< "no FrameStartWait event";
+      }
+    _recordSoftTrigger();
+    aLock.unlock();
+
+    // Not under lock, Pylon event thread may need the node map
+    _executeSoftTrigger();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_executeSoftTrigger()
+{
+    DEB_MEMBER_FUNCT();
+    m_control.command(ControlChannel::Critical,
+		      [this]() {Camera_->TriggerSoftware.Execute();});
+}
+
+//-----------------------------------------------------
+// under the soft trigger lock
+//-----------------------------------------------------
+void Camera::_recordSoftTrigger()
+{
+    if(!m_soft_triggers.empty())
+      {
+	_SoftTrigger& trigger = m_soft_triggers[m_soft_trigger_sent % m_soft_triggers.size()];
+	trigger.sent = Timestamp::now();
+	trigger.latency = -1.;
+      }
+    ++m_soft_trigger_sent;
+}
+
+//-----------------------------------------------------
+// called from the Pylon event thread on FrameStartWait
+//-----------------------------------------------------
+void Camera::_softTriggerReadyEvent()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    ++m_soft_trigger_ready_count;
+    bool send_trigger = m_soft_trigger_pending > 0;
+    if(send_trigger)
+      {
+	--m_soft_trigger_pending;
+	_recordSoftTrigger();
+      }
+    m_soft_trigger_cond.broadcast();
+    aLock.unlock();
+
+    DEB_TRACE() << DEB_VAR2(m_soft_trigger_ready_count,send_trigger);
+    if(send_trigger)
+      _executeSoftTrigger();
+}
+
+//-----------------------------------------------------
+// called from the Pylon event thread on ExposureEnd,
+// exposure start is the camera timestamp of the event, in host
+// time, minus the exposure time set to the camera (the event
+// arrival time if the camera clock is not mapped).
+// The events come in camera order and the next trigger waits for
+// the FrameStartWait event following this exposure: the exposed
+// frame is the last trigger sent before the exposure start, a lost
+// event leaves its frame without latency and shifts no other one.
+//-----------------------------------------------------
+void Camera::_exposureEndEvent()
+{
+    DEB_MEMBER_FUNCT();
+    double exposure_end = double(Timestamp::now());
+    long long tick = -1;
+    if(IsReadable(Camera_->EventExposureEndTimestamp))
+      tick = Camera_->EventExposureEndTimestamp.GetValue();
+    else if(IsReadable(Camera_->ExposureEndEventTimestamp))
+      tick = Camera_->ExposureEndEventTimestamp.GetValue();
+    double exp_time = m_camera_exp_time.load(std::memory_order_relaxed);
+
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    if(tick >= 0 && m_tick_latch_time.isSet())
+      exposure_end = m_tick_host_offset + double(tick) / m_tick_frequency;
+    double exposure_start = exposure_end - exp_time;
+    int nb_kept = int(m_soft_triggers.size());
+    for(int frame_nb = m_soft_trigger_sent - 1;
+	frame_nb >= 0 && frame_nb >= m_soft_trigger_sent - nb_kept;--frame_nb)
+      {
+	_SoftTrigger& trigger = m_soft_triggers[frame_nb % nb_kept];
+	if(double(trigger.sent) > exposure_start)
+	  continue;
+	if(trigger.latency < 0.)
+	  {
+	    trigger.latency = exposure_start - double(trigger.sent);
+	    DEB_TRACE() << DEB_VAR2(frame_nb,trigger.latency);
+	  }
+	break;
+      }
+}
+
+//-----------------------------------------------------
+// host time of the camera tick 0, from a latched camera
+// timestamp and the host time around the latch
+//-----------------------------------------------------
+void Camera::_latchCameraClock()
+{
+    DEB_MEMBER_FUNCT();
+    double before,after;
+    long long tick;
+    try
+    {
+	m_control.command(ControlChannel::Normal,[&]() {
+	    before = double(Timestamp::now());
+	    if(IsAvailable(Camera_->TimestampLatch))
+	    {
+		Camera_->TimestampLatch.Execute();
+		tick = Camera_->TimestampLatchValue.GetValue();
+	    }
+	    else
+	    {
+		Camera_->GevTimestampControlLatch.Execute();
+		tick = Camera_->GevTimestampValue.GetValue();
+	    }
+	    after = double(Timestamp::now());
+	  });
+    }
+    catch (Pylon::GenericException &e)
+    {
+	DEB_WARNING() << "Camera clock latch failed: " << e.GetDescription();
+	return;
+    }
+    AutoMutex aLock(m_soft_trigger_cond.mutex());
+    m_tick_host_offset = (before + after) / 2. - double(tick) / m_tick_frequency;
+    m_tick_latch_time = Timestamp(after);
+    DEB_TRACE() << DEB_VAR2(m_tick_host_offset,after - before);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+bool Camera::isSequencerAvailable() const
+{
+    DEB_MEMBER_FUNCT();
+    bool isAvailable = false;
+    try
+    {
+	isAvailable = (GenApi::IsAvailable(Camera_->SequenceEnable) ||
+		       GenApi::IsAvailable(Camera_->SequencerMode));
+    }
+    catch (Pylon::GenericException &e)
+    {
+        DEB_WARNING() << e.GetDescription();
+    }
+    DEB_RETURN() << DEB_VAR1(isAvailable);
+    return isAvailable;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::clearSequenceSets()
+{
+    DEB_MEMBER_FUNCT();
+    if(m_sequencer_mode)
+      THROW_HW_ERROR(Error) << "Can't change sequence sets while sequencer is active";
+    m_sequence_sets.clear();
+}
+
+//-----------------------------------------------------
+// all sets must have the same pixel depth, the LIMA
+// frame buffers are allocated for one image type
+//-----------------------------------------------------
+void Camera::addSequenceSet(double exp_time,double gain,
+			    int offset_x,int offset_y,ImageType type)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR5(exp_time,gain,offset_x,offset_y,type);
+
+    if(m_sequencer_mode)
+      THROW_HW_ERROR(Error) << "Can't change sequence sets while sequencer is active";
+    if(gain < 0. || gain > 1.)
+      THROW_HW_ERROR(InvalidValue) << "Gain must be in range <0.0,1.0>";
+    if(!m_sequence_sets.empty() &&
+       FrameDim::getImageTypeDepth(type) !=
+       FrameDim::getImageTypeDepth(m_sequence_sets.front().image_type))
+      THROW_HW_ERROR(InvalidValue) << "All sequence sets must have the same pixel depth";
+
+    SequenceSet aSet;
+    aSet.exp_time = exp_time;
+    aSet.gain = gain;
+    aSet.offset_x = offset_x;
+    aSet.offset_y = offset_y;
+    aSet.image_type = type;
+    m_sequence_sets.push_back(aSet);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSequenceSet(int set_index,double& exp_time,double& gain,
+			    int& offset_x,int& offset_y,ImageType& type) const
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(set_index);
+    if(set_index < 0 || set_index >= int(m_sequence_sets.size()))
+      THROW_HW_ERROR(InvalidValue) << "Invalid sequence set index " << set_index;
+
+    const SequenceSet& aSet = m_sequence_sets[set_index];
+    exp_time = aSet.exp_time;
+    gain = aSet.gain;
+    offset_x = aSet.offset_x;
+    offset_y = aSet.offset_y;
+    type = aSet.image_type;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbSequenceSets(int& nb_sets) const
+{
+    nb_sets = int(m_sequence_sets.size());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setSequencerAdvance(SequencerAdvance advance)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(advance);
+    if(m_sequencer_mode)
+      THROW_HW_ERROR(Error) << "Can't change sequencer advance while sequencer is active";
+    m_sequencer_advance = advance;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSequencerAdvance(SequencerAdvance& advance) const
+{
+    advance = m_sequencer_advance;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setSequenceSetExecutions(int nb_frames)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_frames);
+    if(m_sequencer_mode)
+      THROW_HW_ERROR(Error) << "Can't change sequence set executions while sequencer is active";
+    if(nb_frames < 1)
+      THROW_HW_ERROR(InvalidValue) << "Sequence set executions must be >= 1";
+    m_sequence_set_executions = nb_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSequenceSetExecutions(int& nb_frames) const
+{
+    nb_frames = m_sequence_set_executions;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setSequencerMode(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+
+    if(active == m_sequencer_mode)
+      return;
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change sequencer mode while acquisition is running";
+    if(active && !isSequencerAvailable())
+      THROW_HW_ERROR(NotSupported) << "This camera model does not support sequencer";
+    if(active && m_sequence_sets.empty())
+      THROW_HW_ERROR(InvalidValue) << "No sequence set defined";
+
+    try
+    {
+	if(active)
+	  _uploadSequenceSets();
+	_enableSequencer(active);
+    }
+    catch (Pylon::GenericException &e)
+    {
+        // Error handling
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+    m_sequencer_mode = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSequencerMode(bool& active) const
+{
+    active = m_sequencer_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameSequenceSetIndex(int frame_nb,int& set_index) const
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(frame_nb);
+    if(frame_nb < 0 || m_frame_sequence_set_indexes.empty())
+      set_index = -1;
+    else
+      set_index = m_frame_sequence_set_indexes[frame_nb % m_frame_sequence_set_indexes.size()];
+    DEB_RETURN() << DEB_VAR1(set_index);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameSequenceSetIndexes(std::vector<int>& set_indexes) const
+{
+    set_indexes = m_frame_sequence_set_indexes;
+}
+
+//-----------------------------------------------------
+// called from the grab thread
+//-----------------------------------------------------
+void Camera::_setFrameSequenceSetIndex(int frame_nb,int set_index)
+{
+    if(!m_frame_sequence_set_indexes.empty())
+      m_frame_sequence_set_indexes[frame_nb % m_frame_sequence_set_indexes.size()] = set_index;
+}
+
+//-----------------------------------------------------
+// GigE cameras (SFNC 1.x) use SequenceSet* features,
+// USB and ace 2 cameras (SFNC 2.0) SequencerSet* features.
+// The set values are written to the nodes directly, the
+// user exposure time, gain, auto gain, image type and
+// offsets are restored once the sets are stored.
+//-----------------------------------------------------
+void Camera::_uploadSequenceSets()
+{
+    DEB_MEMBER_FUNCT();
+    bool sfnc2 = Camera_->GetSfncVersion() >= Sfnc_2_0_0;
+    int nb_sets = int(m_sequence_sets.size());
+
+    TrigMode mode;
+    getTrigMode(mode);
+    double user_gain;
+    getGain(user_gain);
+    bool user_auto_gain;
+    getAutoGain(user_auto_gain);
+    // the set gains are manual ones
+    if(user_auto_gain)
+      setAutoGain(false);
+    ImageType user_image_type;
+    _getCameraImageType(user_image_type);
+    int64_t user_offset_x = Camera_->OffsetX.GetValue();
+    int64_t user_offset_y = Camera_->OffsetY.GetValue();
+
+    if(sfnc2)
+      {
+	if(m_sequencer_advance == AdvanceByFrameCount && m_sequence_set_executions > 1)
+	  THROW_HW_ERROR(NotSupported) << "This camera model only advance sequencer at each frame";
+	Camera_->SequencerMode.SetValue(SequencerMode_Off);
+	Camera_->SequencerConfigurationMode.SetValue(SequencerConfigurationMode_On);
+      }
+    else
+      {
+	Camera_->SequenceEnable.SetValue(false);
+	if(nb_sets > Camera_->SequenceSetTotalNumber.GetMax())
+	  THROW_HW_ERROR(InvalidValue) << "Too many sequence sets, max is "
+				       << Camera_->SequenceSetTotalNumber.GetMax();
+	Camera_->SequenceSetTotalNumber.SetValue(nb_sets);
+	Camera_->SequenceAdvanceMode.SetValue(m_sequencer_advance == AdvanceByFrameCount ?
+					      SequenceAdvanceMode_Auto :
+					      SequenceAdvanceMode_Controlled);
+	if(m_sequencer_advance == AdvanceByLine1)
+	  {
+	    Camera_->SequenceControlSelector.SetValue(SequenceControlSelector_Advance);
+	    Camera_->SequenceControlSource.SetValue(SequenceControlSource_Line1);
+	  }
+      }
+
+    for(int set_index = 0;set_index < nb_sets;++set_index)
+      {
+	const SequenceSet& aSet = m_sequence_sets[set_index];
+	_setCameraImageType(aSet.image_type);
+	_writeExpTime(aSet.exp_time,mode);
+	_writeGain(aSet.gain);
+	Camera_->OffsetX.SetValue(aSet.offset_x);
+	Camera_->OffsetY.SetValue(aSet.offset_y);
+
+	if(sfnc2)
+	  {
+	    Camera_->SequencerSetSelector.SetValue(set_index);
+	    Camera_->SequencerPathSelector.SetValue(0);
+	    Camera_->SequencerSetNext.SetValue((set_index + 1) % nb_sets);
+	    Camera_->SequencerTriggerSource.SetValue(m_sequencer_advance == AdvanceByFrameCount ?
+						     SequencerTriggerSource_FrameStart :
+						     SequencerTriggerSource_Line1);
+	    Camera_->SequencerSetSave.Execute();
+	  }
+	else
+	  {
+	    Camera_->SequenceSetIndex.SetValue(set_index);
+	    if(m_sequencer_advance == AdvanceByFrameCount)
+	      Camera_->SequenceSetExecutions.SetValue(m_sequence_set_executions);
+	    Camera_->SequenceSetStore.Execute();
+	  }
+	DEB_TRACE() << "Sequence set " << set_index << " stored";
+      }
+
+    if(sfnc2)
+      {
+	Camera_->SequencerSetStart.SetValue(0);
+	Camera_->SequencerConfigurationMode.SetValue(SequencerConfigurationMode_Off);
+      }
+
+    _setCameraImageType(user_image_type);
+    _writeExpTime(m_exp_time,mode);
+    _writeGain(user_gain);
+    if(user_auto_gain)
+      setAutoGain(true);
+    Camera_->OffsetX.SetValue(user_offset_x);
+    Camera_->OffsetY.SetValue(user_offset_y);
+}
+
+//-----------------------------------------------------
+// sequence set index of each frame comes from chunk
+// data if the camera provides it
+//-----------------------------------------------------
+void Camera::_enableSequencer(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    bool sfnc2 = Camera_->GetSfncVersion() >= Sfnc_2_0_0;
+
+    const char* chunk_name = sfnc2 ? "SequencerSetActive" : "SequenceSetIndex";
+    GenApi::IEnumEntry *anEntry = IsAvailable(Camera_->ChunkSelector) ?
+      Camera_->ChunkSelector.GetEntryByName(chunk_name) : NULL;
+    m_sequence_chunk_available = active && anEntry && GenApi::IsAvailable(anEntry);
+    if(anEntry && GenApi::IsAvailable(anEntry))
+      {
+	Camera_->ChunkModeActive.SetValue(active);
+	Camera_->ChunkSelector.SetIntValue(anEntry->GetValue());
+	Camera_->ChunkEnable.SetValue(active);
+      }
+
+    if(sfnc2)
+      Camera_->SequencerMode.SetValue(active ? SequencerMode_On : SequencerMode_Off);
+    else
+      Camera_->SequenceEnable.SetValue(active);
+
+    // chunk data changes the payload size
+    ImageSize_ = (size_t)(Camera_->PayloadSize.GetValue());
+    DEB_TRACE() << DEB_VAR2(m_sequence_chunk_available,ImageSize_);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setHdrMode(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+
+    if(active == m_hdr_mode)
+      return;
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change HDR mode while acquisition is running";
+    if(active && m_video_flag_mode)
+      THROW_HW_ERROR(NotSupported) << "HDR mode is not available in video mode";
+    m_hdr_mode = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getHdrMode(bool& active) const
+{
+    active = m_hdr_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setHdrExposureTimes(const std::vector<double>& exp_times)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(exp_times.size());
+    for(std::vector<double>::const_iterator i = exp_times.begin();
+	i != exp_times.end();++i)
+      if(*i <= 0.)
+	THROW_HW_ERROR(InvalidValue) << "HDR exposure times must be > 0";
+    m_hdr_exp_times = exp_times;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getHdrExposureTimes(std::vector<double>& exp_times) const
+{
+    exp_times = m_hdr_exp_times;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setHdrSaturationLevel(double level)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(level);
+    if(level < 0.)
+      THROW_HW_ERROR(InvalidValue) << "HDR saturation level must be >= 0";
+    m_hdr_saturation_level = level;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getHdrSaturationLevel(double& level) const
+{
+    level = m_hdr_saturation_level;
+}
+
+//-----------------------------------------------------
+// group of exposures from the user list, or from the
+// sequencer sets each taken sequence set executions times
+//-----------------------------------------------------
+void Camera::_prepareHdrMerge()
+{
+    DEB_MEMBER_FUNCT();
+
+    if(m_trigger_mode == IntTrigMult)
+      THROW_HW_ERROR(NotSupported) << "HDR mode is not available in IntTrigMult";
+
+    std::vector<double> exp_times = m_hdr_exp_times;
+    if(exp_times.empty())
+      {
+	if(!m_sequencer_mode)
+	  THROW_HW_ERROR(Error) << "HDR mode needs exposure times or an active sequencer";
+	if(m_sequencer_advance != AdvanceByFrameCount)
+	  THROW_HW_ERROR(NotSupported) << "HDR mode needs a sequencer advancing on frame count";
+	for(std::vector<SequenceSet>::const_iterator i = m_sequence_sets.begin();
+	    i != m_sequence_sets.end();++i)
+	  exp_times.insert(exp_times.end(),m_sequence_set_executions,i->exp_time);
+      }
+
+    ImageType camera_type;
+    _getCameraImageType(camera_type);
+    const Size& frame_size = m_buffer_ctrl_obj.getBuffer().getFrameDim().getSize();
+    m_hdr_merge.prepare(camera_type,m_hdr_output_type,
+			frame_size.getWidth() * frame_size.getHeight(),
+			exp_times,m_hdr_saturation_level);
+    m_hdr_group_size = m_hdr_merge.getNbExposures();
+    DEB_TRACE() << DEB_VAR1(m_hdr_group_size);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setSharedGrabLoop(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change grab loop while acquisition is running";
+    if(active && m_camera_array)
+      THROW_HW_ERROR(NotSupported) << "Array cameras are grabbed by their CameraArray";
+    m_shared_grab_loop = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getSharedGrabLoop(bool& active) const
+{
+    active = m_shared_grab_loop;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBufferQuota(long long nb_bytes)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_bytes);
+    if(nb_bytes < 0)
+      THROW_HW_ERROR(InvalidValue) << "Buffer quota must be >= 0";
+    m_buffer_quota = nb_bytes;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBufferQuota(long long& nb_bytes) const
+{
+    nb_bytes = m_buffer_quota;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getThroughput(double& frame_rate,double& data_rate) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    double elapsed = m_accounting_last - m_accounting_start;
+    frame_rate = elapsed > 0. ? m_accounting_nb_frames / elapsed : 0.;
+    data_rate = elapsed > 0. ? m_accounting_nb_bytes / elapsed : 0.;
+    DEB_RETURN() << DEB_VAR2(frame_rate,data_rate);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getGrabCpuUsage(double& cpu_time,double& cpu_load) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    double elapsed = m_accounting_last - m_accounting_start;
+    cpu_time = m_accounting_cpu_time;
+    cpu_load = elapsed > 0. ? cpu_time / elapsed : 0.;
+    DEB_RETURN() << DEB_VAR2(cpu_time,cpu_load);
+}
+
+//-----------------------------------------------------
+// called from the grab thread
+//-----------------------------------------------------
+void Camera::_accountFrame(size_t nb_bytes,double cpu_time)
+{
+    AutoMutex aLock(m_accounting_mutex);
+    m_accounting_last = Timestamp::now();
+    ++m_accounting_nb_frames;
+    m_accounting_nb_bytes += nb_bytes;
+    m_accounting_cpu_time += cpu_time;
+}
+
+//-----------------------------------------------------
+// shared grab loop, image event handler is called by
+// RetrieveResult. Returns false once grabbing is over
+//-----------------------------------------------------
+bool Camera::_retrieveResult()
+{
+    DEB_MEMBER_FUNCT();
+    try
+    {
+	CBaslerUniversalGrabResultPtr ptrGrabResult;
+	Camera_->RetrieveResult(0,ptrGrabResult,TimeoutHandling_Return);
+	return Camera_->IsGrabbing();
+    }
+    catch (Pylon::GenericException &e)
+    {
+	DEB_ERROR() << "GeniCam Error! " << e.GetDescription();
+	return false;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_BlankFiller::fill(int frame_nb)
+{
+    AutoMutex aLock(m_cond.mutex());
+    _Frame frame;
+    frame.info.acq_frame_nb = frame_nb;
+    frame.blank = true;
+    m_pending.push_back(frame);
+    ++m_nb_queued;
+    m_cond.broadcast();
+}
+
+//-----------------------------------------------------
+// true if the frame is queued behind the pending blank frames,
+// only the grab thread queues so an empty queue stays empty
+//-----------------------------------------------------
+bool Camera::_BlankFiller::defer(HwFrameInfoType& frame_info)
+{
+    if(!m_nb_queued.load(std::memory_order_acquire))
+      return false;
+    AutoMutex aLock(m_cond.mutex());
+    _Frame frame;
+    frame.info = frame_info;
+    frame.blank = false;
+    m_pending.push_back(frame);
+    ++m_nb_queued;
+    m_cond.broadcast();
+    return true;
+}
+
+//-----------------------------------------------------
+// discard: drop the pending frames of an aborted acquisition
+//-----------------------------------------------------
+void Camera::_BlankFiller::flush(bool discard)
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    if(discard)
+      {
+	m_nb_queued -= int(m_pending.size());
+	m_pending.clear();
+      }
+    if(discard || m_thread_id == Affinity::getThreadId())
+      return;
+    while(m_busy || !m_pending.empty())
+      m_cond.wait();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_BlankFiller::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    m_thread_id = Affinity::getThreadId();
+    while(!m_quit)
+      {
+	if(m_pending.empty())
+	  {
+	    m_cond.wait();
+	    continue;
+	  }
+	_Frame frame = m_pending.front();
+	m_pending.pop_front();
+	m_busy = true;
+	bool delivered;
+	{
+	  AutoMutexUnlock aUnlock(aLock);
+	  _EventHandler& handler = *m_cam.m_event_handler;
+	  if(frame.blank)
+	    {
+	      void *framePt = handler.m_buffer_mgr.getFrameBufferPtr(frame.info.acq_frame_nb);
+	      const FrameDim& fDim = handler.m_buffer_mgr.getFrameDim();
+	      _stream_zero(framePt,fDim.getMemSize());
+	      DEB_TRACE() << "Frame " << frame.info.acq_frame_nb << " is blank";
+	    }
+	  delivered = handler._deliver_frame(frame.info);
+	}
+	m_busy = false;
+	// the frames queued after a refused one keep their numbers,
+	// a stopping overrun policy has discarded them already
+	if(!delivered)
+	  DEB_TRACE() << "Frame " << frame.info.acq_frame_nb << " refused";
+	--m_nb_queued;
+	m_cond.broadcast();
+      }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_TelemetrySampler::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    while(!m_quit)
+      {
+	double period = m_cam.m_telemetry_period;
+	{
+	  AutoMutexUnlock aUnlock(aLock);
+	  std::shared_ptr<Telemetry> telemetry = std::make_shared<Telemetry>();
+	  try
+	    {
+	      m_cam._sampleTelemetry(*telemetry);
+	      std::atomic_store(&m_cam.m_telemetry,
+				std::shared_ptr<const Telemetry>(telemetry));
+	    }
+	  catch(Exception& e)
+	    {
+	      DEB_WARNING() << "Telemetry sampling failed: " << e.getErrMsg();
+	    }
+	  // the reads share the control channel with the stream
+	  double frame_rate,data_rate;
+	  m_cam.getThroughput(frame_rate,data_rate);
+	  double rate_limit = m_cam.m_telemetry_grab_rate_limit;
+	  if(rate_limit > 0. && frame_rate > rate_limit &&
+	     m_cam.Camera_->IsGrabbing())
+	    period *= TELEMETRY_GRAB_SLOWDOWN;
+	}
+	if(!m_quit)
+	  m_cond.wait(period);
+      }
+}
+
+//-----------------------------------------------------
+// level below which percentile of the pixels are, in fraction of the
+// histogram full scale, interpolated in the bin
+//-----------------------------------------------------
+static double _histogram_level(const std::vector<unsigned int>& histogram,
+			       int nb_pixels,double percentile)
+{
+    int nb_bins = int(histogram.size());
+    double rank = percentile * nb_pixels;
+    double count = 0.;
+    for(int bin = 0;bin < nb_bins;++bin)
+      {
+	if(!histogram[bin])
+	  continue;
+	double next_count = count + histogram[bin];
+	if(next_count >= rank)
+	  return (bin + (rank - count) / histogram[bin]) / nb_bins;
+	count = next_count;
+      }
+    return 1.;
+}
+
+//-----------------------------------------------------
+// gain (0 to 1 over span dB) changed toward factor, returns the factor done
+//-----------------------------------------------------
+static double _gain_step(double& gain,double factor,double span)
+{
+    double new_gain = gain + 20. * log10(factor) / span;
+    new_gain = min(max(new_gain,0.),1.);
+    double done = pow(10.,(new_gain - gain) * span / 20.);
+    gain = new_gain;
+    return done;
+}
+
+//-----------------------------------------------------
+// prepareAcq, the grab thread is idle
+//-----------------------------------------------------
+void Camera::_AutoExposureLoop::reset(bool running,double exp_time,double gain,
+				      double min_exp_time,double max_exp_time,
+				      double gain_span,bool exp_time_adjustable)
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    ++m_generation;
+    m_min_exp_time = min_exp_time;
+    m_max_exp_time = max_exp_time;
+    m_gain_span = gain_span;
+    m_exp_time_adjustable = exp_time_adjustable;
+    m_next_index = 0;
+    m_user_gain = gain;
+    m_state = AutoExposureLoopState();
+    m_state.running = running;
+    m_state.exp_time = exp_time;
+    m_state.gain = gain;
+}
+
+//-----------------------------------------------------
+// the loop exposure time is not the one cached by lima,
+// it is only set while the acquisition runs
+//-----------------------------------------------------
+void Camera::_AutoExposureLoop::stop()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    while(m_busy)
+      m_cond.wait();
+    if(!m_state.running)
+      return;
+    m_state.running = false;
+    double exp_time = m_state.exp_time,gain = m_state.gain;
+    double user_gain = m_user_gain;
+    aLock.unlock();
+
+    try
+      {
+	if(exp_time != m_cam.m_exp_time)
+	  m_cam.setExpTime(m_cam.m_exp_time);
+	if(gain != user_gain)
+	  m_cam._setLoopGain(user_gain);
+      }
+    catch(Exception& e)
+      {
+	DEB_WARNING() << "Auto exposure restore failed: " << e.getErrMsg();
+      }
+}
+
+//-----------------------------------------------------
+// new exposure time and gain from the level of result, false if unchanged
+//-----------------------------------------------------
+bool Camera::_AutoExposureLoop::_step(const FrameStats::Result& result,
+				      double& exp_time,double& gain)
+{
+    int nb_bins = int(result.histogram.size());
+    if(!result.nb_pixels || !nb_bins || exp_time <= 0.)
+      return false;
+
+    double percentile = m_cam.m_auto_exposure_loop_percentile;
+    double max_step = m_cam.m_auto_exposure_loop_max_step;
+    double level = _histogram_level(result.histogram,result.nb_pixels,percentile);
+    m_state.level = level;
+    m_state.frame_index = result.index;
+
+    double factor;
+    // a saturated percentile has an unknown level
+    if(result.nb_saturated > (1. - percentile) * result.nb_pixels)
+      factor = 1. / max_step;
+    else
+      factor = m_cam.m_auto_exposure_loop_target / max(level,0.5 / nb_bins);
+    m_state.converged = fabs(factor - 1.) <= m_cam.m_auto_exposure_loop_tolerance;
+    if(m_state.converged)
+      return false;
+    factor = min(max(factor,1. / max_step),max_step);
+
+    // the gain is lowered first and raised last, it adds noise
+    bool use_gain = (m_cam.m_auto_exposure_loop_mode == AutoExposureLoopExpTimeGain &&
+		     m_gain_span > 0.);
+    if(factor < 1. && use_gain)
+      factor /= _gain_step(gain,factor,m_gain_span);
+    if(m_exp_time_adjustable)
+      {
+	double new_exp_time = min(max(exp_time * factor,m_min_exp_time),m_max_exp_time);
+	factor *= exp_time / new_exp_time;
+	exp_time = new_exp_time;
+      }
+    if(factor > 1. && use_gain)
+      _gain_step(gain,factor,m_gain_span);
+    return exp_time != m_state.exp_time || gain != m_state.gain;
+}
+
+//-----------------------------------------------------
+// one adjustment per new frame stats result, the frames exposed
+// before the adjustment are skipped
+//-----------------------------------------------------
+void Camera::_AutoExposureLoop::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    while(!m_quit)
+      {
+	FrameStats::Result result;
+	if(!m_state.running ||
+	   m_cam.m_auto_exposure_loop_mode == AutoExposureLoopOff ||
+	   !m_cam.m_frame_stats.getLastResult(result) ||
+	   result.index < m_next_index)
+	  {
+	    m_cond.wait(AUTO_EXPOSURE_POLL_PERIOD);
+	    continue;
+	  }
+	// the results published meanwhile are not used
+	m_next_index = result.index + 1;
+	double exp_time = m_state.exp_time,gain = m_state.gain;
+	if(!_step(result,exp_time,gain))
+	  continue;
+
+	unsigned long long generation = m_generation;
+	double set_exp_time = m_state.exp_time,set_gain = m_state.gain;
+	m_busy = true;
+	{
+	  AutoMutexUnlock aUnlock(aLock);
+	  try
+	    {
+	      if(exp_time != set_exp_time)
+		{
+		  m_cam._setLoopExpTime(exp_time);
+		  set_exp_time = exp_time;
+		}
+	      if(gain != set_gain)
+		{
+		  m_cam._setLoopGain(gain);
+		  set_gain = gain;
+		}
+	    }
+	  catch(Exception& e)
+	    {
+	      DEB_WARNING() << "Auto exposure adjustment failed: " << e.getErrMsg();
+	    }
+	}
+	m_busy = false;
+	m_cond.broadcast();
+	if(generation != m_generation)
+	  continue;
+	m_state.exp_time = set_exp_time;
+	m_state.gain = set_gain;
+	++m_state.nb_adjustments;
+	// the frames grabbed so far may be exposed with the previous setting
+	m_next_index = m_cam.m_frame_stats.getNbResults() +
+	  m_cam.m_auto_exposure_loop_settle_frames;
+      }
+}
+
+//-----------------------------------------------------
+// false if all the handles are lent, the frame is not delivered
+//-----------------------------------------------------
+bool Camera::_VideoLender::lend(const CBaslerUniversalGrabResultPtr& result,VideoMode mode)
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    if(m_free.empty())
+      return false;
+    int index = m_free.back();
+    m_free.pop_back();
+    m_loans[index].result = result;
+    m_loans[index].mode = mode;
+    m_pending.push_back(index);
+    m_cond.broadcast();
+    return true;
+}
+
+//-----------------------------------------------------
+// wait all the loans returned
+//-----------------------------------------------------
+void Camera::_VideoLender::flush()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    while(m_free.size() < m_loans.size())
+      m_cond.wait();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_VideoLender::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    while(!m_quit)
+      {
+	if(m_pending.empty())
+	  {
+	    m_cond.wait();
+	    continue;
+	  }
+	int index = m_pending.front();
+	m_pending.pop_front();
+	_Loan& aLoan = m_loans[index];
+	{
+	  AutoMutexUnlock aUnlock(aLock);
+	  m_cam.m_video->callNewImage((char*)aLoan.result->GetBuffer(),
+				      aLoan.result->GetWidth(),
+				      aLoan.result->GetHeight(),
+				      aLoan.mode);
+	  aLoan.result.Release();
+	}
+	m_free.push_back(index);
+	m_cond.broadcast();
+      }
+}
+
+// adaptive wait timeout of the user grab loop (ms)
+static const unsigned GRAB_LOOP_MIN_TIMEOUT = 1;
+static const unsigned GRAB_LOOP_MAX_TIMEOUT = 1000;
+
+//-----------------------------------------------------
+// start the grab loop on the current acquisition
+//-----------------------------------------------------
+void Camera::_GrabLoop::startGrab()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    _resetStatistics();
+    m_wakeup.Reset();
+    m_run = true;
+    m_cond.broadcast();
+}
+
+//-----------------------------------------------------
+// wait the end of the grab, not from the loop thread
+//-----------------------------------------------------
+void Camera::_GrabLoop::waitIdle()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    if(m_thread_id == Affinity::getThreadId())
+      return;
+    m_wakeup.Signal();
+    while(m_run || m_running)
+      m_cond.wait();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_GrabLoop::getStatistics(double& wakeups_per_frame,
+				      double& mean_latency,double& max_latency) const
+{
+    AutoMutex aLock(m_cond.mutex());
+    wakeups_per_frame = m_nb_frames ? double(m_nb_wakeups) / m_nb_frames : 0.;
+    mean_latency = m_nb_latencies ? m_latency_sum / m_nb_latencies : 0.;
+    max_latency = m_latency_max;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_GrabLoop::_resetStatistics()
+{
+    m_nb_wakeups = m_nb_frames = m_nb_latencies = 0;
+    m_latency_sum = m_latency_max = 0.;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_GrabLoop::threadFunction()
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_cond.mutex());
+    m_thread_id = Affinity::getThreadId();
+    while(!m_quit)
+      {
+	if(!m_run)
+	  {
+	    m_cond.wait();
+	    continue;
+	  }
+	m_running = true;
+	int priority = m_cam.m_grab_loop_priority;
+	{
+	  AutoMutexUnlock aUnlock(aLock);
+	  _setPriority(priority);
+	  _grab();
+	}
+	m_run = m_running = false;
+	m_cond.broadcast();
+      }
+}
+
+//-----------------------------------------------------
+// SCHED_FIFO if priority > 0
+//-----------------------------------------------------
+void Camera::_GrabLoop::_setPriority(int priority)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(priority);
+#if defined(WIN32)
+    SetThreadPriority(GetCurrentThread(),priority > 0 ?
+		      THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_NORMAL);
+#else
+    struct sched_param param;
+    param.sched_priority = priority > 0 ? priority : 0;
+    int ret = pthread_setschedparam(pthread_self(),priority > 0 ? SCHED_FIFO : SCHED_OTHER,&param);
+    if(ret)
+      DEB_WARNING() << "Can't set grab loop priority " << priority << ": " << strerror(ret)
+		    << " (check rtprio in /etc/security/limits.conf)";
+#endif
+}
+
+//-----------------------------------------------------
+// The wait timeout follows the frame period, so that timeouts
+// are rare while grabbing. Each wakeup with results samples the
+// latency of its first, oldest, result: the wakeup time minus the
+// camera timestamp, in excess of the smallest such delay of the
+// acquisition (the camera clock drift is small against it).
+//-----------------------------------------------------
+void Camera::_GrabLoop::_grab()
+{
+    DEB_MEMBER_FUNCT();
+    WaitObjects waitObjects;
+    waitObjects.Add(m_wakeup);
+    waitObjects.Add(m_cam.Camera_->GetGrabResultWaitObject());
+
+    unsigned timeout = GRAB_LOOP_MAX_TIMEOUT;
+    double period = 0.;
+    Timestamp last_frames;
+    double min_delay = 0.;
+    bool min_delay_set = false;
+    try
+      {
+	while(m_cam.Camera_->IsGrabbing())
+	  {
+	    unsigned int index;
+	    bool ready = waitObjects.WaitForAny(timeout,&index);
+	    Timestamp wake = Timestamp::now();
+	    if(ready && !index)	// stop request
+	      {
+		m_wakeup.Reset();
+		continue;
+	      }
+
+	    long long nb_frames = 0;
+	    double latency = -1.;
+	    if(ready)
+	      {
+		CBaslerUniversalGrabResultPtr ptrGrabResult;
+		while(m_cam.Camera_->IsGrabbing() &&
+		      m_cam.Camera_->RetrieveResult(0,ptrGrabResult,TimeoutHandling_Return))
+		  {
+		    if(!nb_frames && m_cam.m_tick_frequency > 0 &&
+		       ptrGrabResult->GrabSucceeded())
+		      {
+			double delay = double(wake) -
+			  double(ptrGrabResult->GetTimeStamp()) / m_cam.m_tick_frequency;
+			if(!min_delay_set || delay < min_delay)
+			  {
+			    min_delay = delay;
+			    min_delay_set = true;
+			  }
+			latency = delay - min_delay;
+		      }
+		    ptrGrabResult.Release();
+		    ++nb_frames;
+		  }
+	      }
+
+	    if(nb_frames)
+	      {
+		if(last_frames.isSet())
+		  {
+		    double frame_period = (wake - last_frames) / nb_frames;
+		    period = period > 0. ? .9 * period + .1 * frame_period : frame_period;
+		    timeout = unsigned(4e3 * period);
+		    timeout = max(GRAB_LOOP_MIN_TIMEOUT,min(timeout,GRAB_LOOP_MAX_TIMEOUT));
+		  }
+		last_frames = wake;
+	      }
+	    else if(!ready)
+	      timeout = min(timeout * 2,GRAB_LOOP_MAX_TIMEOUT);
+
+	    AutoMutex aLock(m_cond.mutex());
+	    ++m_nb_wakeups;
+	    m_nb_frames += nb_frames;
+	    if(latency >= 0.)
+	      {
+		++m_nb_latencies;
+		m_latency_sum += latency;
+		if(latency > m_latency_max)
+		  m_latency_max = latency;
+	      }
+	  }
+      }
+    catch (Pylon::GenericException &e)
+      {
+	DEB_ERROR() << "GeniCam Error! " << e.GetDescription();
+      }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::_BufferCtrlObj::setNbBuffers(int nb_buffers)
+{
+    SoftBufferCtrlObj::setNbBuffers(nb_buffers);
+    FrameDim frame_dim;
+    getFrameDim(frame_dim);
+    if(m_cam.m_numa_local_buffers && m_cam.m_numa_node >= 0)
+      for(int i = 0;i < nb_buffers;++i)
+	Affinity::bindMemory(getBuffer().getFrameBufferPtr(i),
+			     frame_dim.getMemSize(),m_cam.m_numa_node);
+    ResourcePool::getInstance()._setBufferMemory(&m_cam,
+						  (long long)nb_buffers * frame_dim.getMemSize(),
+						  false);
+}
+
+//-----------------------------------------------------
+// lima reduces its buffer count to this maximum
+//-----------------------------------------------------
+void Camera::_BufferCtrlObj::getMaxNbBuffers(int& max_nb_buffers)
+{
+    SoftBufferCtrlObj::getMaxNbBuffers(max_nb_buffers);
+    FrameDim frame_dim;
+    getFrameDim(frame_dim);
+    long long frame_size = frame_dim.getMemSize();
+    if(frame_size <= 0)
+      return;
+
+    long long available = ResourcePool::getInstance()._getBufferMemoryAvailable(&m_cam,false);
+    if(m_cam.m_buffer_quota && (available < 0 || m_cam.m_buffer_quota < available))
+      available = m_cam.m_buffer_quota;
+    if(available >= 0)
+      max_nb_buffers = int(std::min<long long>(max_nb_buffers,available / frame_size));
+}
+
+//-----------------------------------------------------
+// Pylon default is 10
+//-----------------------------------------------------
+void Camera::setStreamBufferCount(int nb_buffers)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_buffers);
+    if(nb_buffers < 1)
+      THROW_HW_ERROR(InvalidValue) << "Stream buffer count must be >= 1";
+    m_stream_buffer_count = nb_buffers;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getStreamBufferCount(int& nb_buffers) const
+{
+    nb_buffers = m_stream_buffer_count;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getMemoryUsage(long long& used,long long& peak) const
+{
+    DEB_MEMBER_FUNCT();
+    ResourcePool::getInstance()._getCameraMemory(const_cast<Camera*>(this),used,peak);
+    DEB_RETURN() << DEB_VAR2(used,peak);
+}
+
+//-----------------------------------------------------
+// Pylon stream buffers fitted in the memory budget, fails if
+// not even one buffer fits or none is left beside the lent ones
+//-----------------------------------------------------
+void Camera::_reserveStreamBuffers()
+{
+    DEB_MEMBER_FUNCT();
+    ResourcePool& aPool = ResourcePool::getInstance();
+
+    // video buffers are allocated by lima core, only accounted
+    if(m_video)
+      {
+	int nb_buffers;
+	m_video->getBuffer().getNbBuffers(nb_buffers);
+	aPool._setBufferMemory(this,
+			       (long long)nb_buffers * m_video->getBuffer().getFrameDim().getMemSize(),
+			       false);
+      }
+
+    long long payload_size = Camera_->PayloadSize.GetValue();
+    long long available = aPool._getBufferMemoryAvailable(this,true);
+    int nb_buffers = m_stream_buffer_count;
+    if(available >= 0 && payload_size > 0)
+      {
+	long long max_nb_buffers = available / payload_size;
+	if(max_nb_buffers < 1)
+	  THROW_HW_ERROR(Error) << "Buffer memory budget exceeded: no room for stream buffers";
+	if(max_nb_buffers < nb_buffers)
+	  {
+	    DEB_WARNING() << "Stream buffers reduced to fit the memory budget: "
+			  << DEB_VAR2(nb_buffers,max_nb_buffers);
+	    nb_buffers = int(max_nb_buffers);
+	  }
+      }
+    // a lent result keeps its stream buffer, one must stay for the grab
+    if(m_video_flag_mode && m_video_lend_mode && nb_buffers <= m_video_lend_pool_size)
+      THROW_HW_ERROR(Error) << "Video lend pool size (" << m_video_lend_pool_size
+			    << ") must be below the stream buffer count (" << nb_buffers
+			    << "), reduce it or raise the memory budget";
+    Camera_->MaxNumBuffer.SetValue(nb_buffers);
+    aPool._setBufferMemory(this,nb_buffers * payload_size,true);
+}
+
+//-----------------------------------------------------
+// setThreadCpus
+//-----------------------------------------------------
+void Camera::setThreadCpus(ThreadRole role,const std::string& cpus)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR2(role,cpus);
+    if(role < ReceiveThread || role > ProcessingThread)
+      THROW_HW_ERROR(InvalidValue) << "Invalid thread role: " << role;
+
+    Affinity::CpuList cpu_list;
+    if(cpus == "numa")
+      {
+	if(m_numa_node < 0)
+	  THROW_HW_ERROR(Error) << "Numa node of the camera is unknown, set it with setNumaNode";
+	Affinity::getNumaNodeCpus(m_numa_node,cpu_list);
+      }
+    else
+      Affinity::parseCpuList(cpus,cpu_list);
+
+    if(role == ProcessingThread && !cpu_list.empty())
+      {
+	Affinity::CpuList caller_cpus;
+	if(m_caller_thread_cpus.empty())
+	  Affinity::getThreadCpus(caller_cpus);
+	Affinity::setThreadCpus(cpu_list);
+	if(!caller_cpus.empty())
+	  m_caller_thread_cpus = caller_cpus;
+      }
+    m_thread_cpus[role] = cpu_list;
+}
+
+//-----------------------------------------------------
+// restoreThreadCpus
+//-----------------------------------------------------
+void Camera::restoreThreadCpus()
+{
+    DEB_MEMBER_FUNCT();
+    if(m_caller_thread_cpus.empty())
+      return;
+    Affinity::setThreadCpus(m_caller_thread_cpus);
+    m_caller_thread_cpus.clear();
+}
+
+//-----------------------------------------------------
+// getThreadCpus
+//-----------------------------------------------------
+void Camera::getThreadCpus(ThreadRole role,std::string& cpus) const
+{
+    DEB_MEMBER_FUNCT();
+    if(role < ReceiveThread || role > ProcessingThread)
+      THROW_HW_ERROR(InvalidValue) << "Invalid thread role: " << role;
+    cpus = Affinity::formatCpuList(m_thread_cpus[role]);
+    DEB_RETURN() << DEB_VAR1(cpus);
+}
+
+//-----------------------------------------------------
+// setNumaNode
+//-----------------------------------------------------
+void Camera::setNumaNode(int node)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(node);
+    if(node < -1)
+      THROW_HW_ERROR(InvalidValue) << "Numa node must be >= -1";
+    m_numa_node = node;
+    _updateBufferFactory();
+}
+
+//-----------------------------------------------------
+// getNumaNode
+//-----------------------------------------------------
+void Camera::getNumaNode(int& node) const
+{
+    DEB_MEMBER_FUNCT();
+    node = m_numa_node;
+    DEB_RETURN() << DEB_VAR1(node);
+}
+
+//-----------------------------------------------------
+// setNumaLocalBuffers
+//-----------------------------------------------------
+void Camera::setNumaLocalBuffers(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    m_numa_local_buffers = active;
+    _updateBufferFactory();
+}
+
+//-----------------------------------------------------
+// getNumaLocalBuffers
+//-----------------------------------------------------
+void Camera::getNumaLocalBuffers(bool& active) const
+{
+    DEB_MEMBER_FUNCT();
+    active = m_numa_local_buffers;
+    DEB_RETURN() << DEB_VAR1(active);
+}
+
+//-----------------------------------------------------
+// getAffinityReport
+//-----------------------------------------------------
+void Camera::getAffinityReport(std::string& report) const
+{
+    DEB_MEMBER_FUNCT();
+    static const char* role_names[] = {"receive thread","grab thread","processing thread"};
+    std::ostringstream os;
+    os << "numa node: " << m_numa_node
+       << (m_numa_local_buffers && m_numa_node >= 0 ? " (local buffers)" : "") << std::endl;
+    for(int role = ReceiveThread;role <= ProcessingThread;++role)
+      {
+	os << role_names[role] << ": ";
+	if(m_thread_cpus[role].empty())
+	  os << "any cpu";
+	else
+	  os << "cpus " << Affinity::formatCpuList(m_thread_cpus[role]);
+	if(role == GrabThread && m_grab_thread_id)
+	  os << " (tid " << m_grab_thread_id << ")";
+	os << std::endl;
+      }
+    report = os.str();
+}
+
+//-----------------------------------------------------
+// called by the grab thread at the first frame
+//-----------------------------------------------------
+void Camera::_applyGrabThreadCpus()
+{
+    DEB_MEMBER_FUNCT();
+    m_grab_thread_cpus_pending = false;
+    m_grab_thread_id = Affinity::getThreadId();
+    try
+      {
+	Affinity::setThreadCpus(m_grab_thread_cpus);
+      }
+    catch(Exception& e)
+      {
+	DEB_WARNING() << e.getErrMsg();
+	return;
+      }
+    DEB_ALWAYS() << "Grab thread " << m_grab_thread_id << " on cpus "
+		 << Affinity::formatCpuList(m_grab_thread_cpus);
+}
+
+//-----------------------------------------------------
+// stream buffers on the numa node, must not be grabbing
+//-----------------------------------------------------
+void Camera::_updateBufferFactory()
+{
+    DEB_MEMBER_FUNCT();
+    try
+      {
+	if(m_numa_local_buffers && m_numa_node >= 0)
+	  {
+	    m_numa_buffer_factory.setNumaNode(m_numa_node);
+	    Camera_->SetBufferFactory(&m_numa_buffer_factory,Cleanup_None);
+	  }
+	else
+	  Camera_->SetBufferFactory(NULL,Cleanup_None);
+      }
+    catch (Pylon::GenericException &e)
+      {
+	THROW_HW_ERROR(Error) << e.GetDescription();
+      }
+}
+
+//-----------------------------------------------------
+// setUserGrabLoop
+//-----------------------------------------------------
+void Camera::setUserGrabLoop(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change grab loop while acquisition is running";
+    if(active && m_camera_array)
+      THROW_HW_ERROR(NotSupported) << "Array cameras are grabbed by their CameraArray";
+    if(active && !m_grab_loop)
+      {
+	m_grab_loop = new _GrabLoop(*this);
+	m_grab_loop->start();
+      }
+    m_user_grab_loop = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getUserGrabLoop(bool& active) const
+{
+    active = m_user_grab_loop;
+}
+
+//-----------------------------------------------------
+// setGrabLoopPriority, used at the next acquisition start
+//-----------------------------------------------------
+void Camera::setGrabLoopPriority(int priority)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(priority);
+    if(priority < 0 || priority > 99)
+      THROW_HW_ERROR(InvalidValue) << "Grab loop priority must be in range [0,99]";
+    m_grab_loop_priority = priority;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getGrabLoopPriority(int& priority) const
+{
+    priority = m_grab_loop_priority;
+}
+
+//-----------------------------------------------------
+// getGrabLoopStatistics
+//-----------------------------------------------------
+void Camera::getGrabLoopStatistics(double& wakeups_per_frame,
+				   double& mean_latency,double& max_latency) const
+{
+    DEB_MEMBER_FUNCT();
+    if(m_grab_loop)
+      m_grab_loop->getStatistics(wakeups_per_frame,mean_latency,max_latency);
+    else
+      wakeups_per_frame = mean_latency = max_latency = 0.;
+    DEB_RETURN() << DEB_VAR3(wakeups_per_frame,mean_latency,max_latency);
+}
+
+//-----------------------------------------------------
+// setVideoLiveStrategy
+//-----------------------------------------------------
+void Camera::setVideoLiveStrategy(VideoGrabStrategy strategy)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(strategy);
+    if(strategy != VideoOneByOne && strategy != VideoLatestImageOnly &&
+       strategy != VideoLatestImages)
+      THROW_HW_ERROR(InvalidValue) << "Invalid live strategy: " << strategy;
+    m_video_live_strategy = strategy;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getVideoLiveStrategy(VideoGrabStrategy& strategy) const
+{
+    strategy = m_video_live_strategy;
+}
+
+//-----------------------------------------------------
+// setVideoLatestImagesDepth
+//-----------------------------------------------------
+void Camera::setVideoLatestImagesDepth(int depth)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(depth);
+    if(depth < 1 || depth > m_stream_buffer_count)
+      THROW_HW_ERROR(InvalidValue) << "Latest images depth must be in range [1,"
+				   << m_stream_buffer_count << "] (stream buffer count)";
+    m_video_latest_images_depth = depth;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getVideoLatestImagesDepth(int& depth) const
+{
+    depth = m_video_latest_images_depth;
+}
+
+//-----------------------------------------------------
+// setVideoSnapshotStrategy
+//-----------------------------------------------------
+void Camera::setVideoSnapshotStrategy(VideoGrabStrategy strategy)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(strategy);
+    if(strategy != VideoOneByOne && strategy != VideoUpcomingImage)
+      THROW_HW_ERROR(InvalidValue) << "Invalid snapshot strategy: " << strategy;
+    if(strategy == VideoUpcomingImage && m_is_usb)
+      THROW_HW_ERROR(NotSupported) << "UpcomingImage strategy is not available on USB cameras";
+    m_video_snapshot_strategy = strategy;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getVideoSnapshotStrategy(VideoGrabStrategy& strategy) const
+{
+    strategy = m_video_snapshot_strategy;
+}
+
+//-----------------------------------------------------
+// getNbSkippedFrames
+//-----------------------------------------------------
+void Camera::getNbSkippedFrames(long long& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_frames = m_nb_skipped_frames;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+// only the video path may drop frames
+//-----------------------------------------------------
+EGrabStrategy Camera::_getGrabStrategy() const
+{
+    DEB_MEMBER_FUNCT();
+    VideoGrabStrategy strategy = VideoOneByOne;
+    if(m_video_flag_mode)
+      {
+	if(!m_nb_frames)
+	  strategy = m_video_live_strategy;
+	else if(m_nb_frames == 1)
+	  strategy = m_video_snapshot_strategy;
+      }
+    switch(strategy)
+      {
+      case VideoLatestImageOnly:	return GrabStrategy_LatestImageOnly;
+      case VideoLatestImages:		return GrabStrategy_LatestImages;
+      case VideoUpcomingImage:		return GrabStrategy_UpcomingImage;
+      default:				return GrabStrategy_OneByOne;
+      }
+}
+
+//-----------------------------------------------------
+// setVideoLendMode
+//-----------------------------------------------------
+void Camera::setVideoLendMode(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change video lending while acquisition is running";
+    if(active && !m_video_lender)
+      {
+	m_video_lender = new _VideoLender(*this,m_video_lend_pool_size);
+	m_video_lender->start();
+      }
+    m_video_lend_mode = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getVideoLendMode(bool& active) const
+{
+    active = m_video_lend_mode;
+}
+
+//-----------------------------------------------------
+// setVideoLendPoolSize, the lent results hold stream buffers
+//-----------------------------------------------------
+void Camera::setVideoLendPoolSize(int nb_handles)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_handles);
+    if(nb_handles < 1 || nb_handles >= m_stream_buffer_count)
+      THROW_HW_ERROR(InvalidValue) << "Video lend pool size must be in range [1,"
+				   << m_stream_buffer_count - 1 << "]";
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change video lend pool while acquisition is running";
+    m_video_lend_pool_size = nb_handles;
+    if(m_video_lender)
+      {
+	delete m_video_lender;
+	m_video_lender = new _VideoLender(*this,m_video_lend_pool_size);
+	m_video_lender->start();
+      }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getVideoLendPoolSize(int& nb_handles) const
+{
+    nb_handles = m_video_lend_pool_size;
+}
+
+//-----------------------------------------------------
+// getNbVideoLendDrops
+//-----------------------------------------------------
+void Camera::getNbVideoLendDrops(long long& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_frames = m_nb_video_lend_drops;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+// setMissedFrameMode
+//-----------------------------------------------------
+void Camera::setMissedFrameMode(MissedFrameMode mode)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(mode);
+    if(mode < MissedIgnore || mode > MissedMark)
+      THROW_HW_ERROR(InvalidValue) << "Invalid missed frame mode";
+    if(mode == MissedMark && !m_blank_filler)
+      {
+	m_blank_filler = new _BlankFiller(*this);
+	m_blank_filler->start();
+      }
+    m_missed_frame_mode = mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getMissedFrameMode(MissedFrameMode& mode) const
+{
+    mode = m_missed_frame_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::isFrameMissed(int frame_nb,bool& missed) const
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(frame_nb);
+    AutoMutex aLock(m_accounting_mutex);
+    if(frame_nb < 0 || !m_missed_frame_bitmap_size)
+      THROW_HW_ERROR(InvalidValue) << "Invalid frame number";
+    int bit = frame_nb % m_missed_frame_bitmap_size;
+    missed = (m_missed_frame_bitmap[bit / 64] >> (bit % 64)) & 1;
+    DEB_RETURN() << DEB_VAR1(missed);
+}
+
+//-----------------------------------------------------
+// bitmap indexes of the missed frames
+//-----------------------------------------------------
+void Camera::getMissedFrames(std::vector<int>& frame_nbs) const
+{
+    DEB_MEMBER_FUNCT();
+    frame_nbs.clear();
+    AutoMutex aLock(m_accounting_mutex);
+    for(size_t i = 0;i < m_missed_frame_bitmap.size();++i)
+      {
+	unsigned long long word = m_missed_frame_bitmap[i];
+	for(int bit = 0;word;++bit,word >>= 1)
+	  if(word & 1)
+	    frame_nbs.push_back(int(i * 64 + bit));
+      }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbMissedFrames(long long& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_frames = m_nb_missed_frames;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getMissedFrameGaps(std::vector<long long>& histogram) const
+{
+    AutoMutex aLock(m_accounting_mutex);
+    histogram = m_missed_frame_gaps;
+}
+
+//-----------------------------------------------------
+// called from the grab thread for each gap
+//-----------------------------------------------------
+void Camera::_accountMissedFrames(long long nb_frames)
+{
+    int bin = 0;
+    while(bin < MISSED_FRAME_GAP_BINS - 1 && (nb_frames >> (bin + 1)))
+      ++bin;
+    AutoMutex aLock(m_accounting_mutex);
+    m_nb_missed_frames += nb_frames;
+    ++m_missed_frame_gaps[bin];
+}
+
+//-----------------------------------------------------
+// lost frames arrived late are not lost
+//-----------------------------------------------------
+void Camera::getNbLostFrames(long long& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_frames = m_nb_missed_frames - m_nb_late_frames;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbDuplicatedFrames(long long& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_frames = m_nb_duplicated_frames;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbLateFrames(long long& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_frames = m_nb_late_frames;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBlockIdBits(int& nb_bits) const
+{
+    nb_bits = m_block_id_bits;
+}
+
+//-----------------------------------------------------
+// called from the grab thread
+//-----------------------------------------------------
+void Camera::_accountMisorderedFrame(bool late)
+{
+    AutoMutex aLock(m_accounting_mutex);
+    if(late)
+      ++m_nb_late_frames;
+    else
+      ++m_nb_duplicated_frames;
+}
+
+//-----------------------------------------------------
+// called from the grab thread, the lock is only taken
+// when the bit changes
+//-----------------------------------------------------
+void Camera::_markMissedFrame(int frame_nb,bool missed)
+{
+    if(!m_missed_frame_bitmap_size)
+      return;
+    int bit = frame_nb % m_missed_frame_bitmap_size;
+    unsigned long long& word = m_missed_frame_bitmap[bit / 64];
+    unsigned long long mask = 1ULL << (bit % 64);
+    if(bool(word & mask) == missed)
+      return;
+    AutoMutex aLock(m_accounting_mutex);
+    word ^= mask;
+}
+
+//-----------------------------------------------------
+// setOverrunPolicy
+//-----------------------------------------------------
+void Camera::setOverrunPolicy(OverrunPolicy policy)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(policy);
+    if(policy < OverrunStop || policy > OverrunThrottle)
+      THROW_HW_ERROR(InvalidValue) << "Invalid overrun policy";
+    if(Camera_->IsGrabbing())
+      THROW_HW_ERROR(Error) << "Can't change overrun policy while acquisition is running";
+    m_overrun_policy = policy;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getOverrunPolicy(OverrunPolicy& policy) const
+{
+    policy = m_overrun_policy;
+}
+
+//-----------------------------------------------------
+// setOverrunDecimation
+//-----------------------------------------------------
+void Camera::setOverrunDecimation(int nth)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nth);
+    if(nth < 2)
+      THROW_HW_ERROR(InvalidValue) << "Overrun decimation must be >= 2";
+    AutoMutex aLock(m_accounting_mutex);
+    m_overrun_decimation = nth;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getOverrunDecimation(int& nth) const
+{
+    nth = m_overrun_decimation;
+}
+
+//-----------------------------------------------------
+// setOverrunRecoveryFrames
+//-----------------------------------------------------
+void Camera::setOverrunRecoveryFrames(int nb_frames)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_frames);
+    if(nb_frames < 1)
+      THROW_HW_ERROR(InvalidValue) << "Overrun recovery frames must be >= 1";
+    AutoMutex aLock(m_accounting_mutex);
+    m_overrun_recovery_frames = nb_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getOverrunRecoveryFrames(int& nb_frames) const
+{
+    nb_frames = m_overrun_recovery_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getOverrunActive(bool& active) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    active = m_overrun_active;
+    DEB_RETURN() << DEB_VAR1(active);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbOverruns(long long& nb_overruns) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_overruns = m_nb_overruns;
+    DEB_RETURN() << DEB_VAR1(nb_overruns);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbOverrunDrops(long long& nb_frames) const
+{
+    DEB_MEMBER_FUNCT();
+    AutoMutex aLock(m_accounting_mutex);
+    nb_frames = m_nb_overrun_drops;
+    DEB_RETURN() << DEB_VAR1(nb_frames);
+}
+
+//-----------------------------------------------------
+// lower the frame rate from the grab thread, false if it can't be
+// lowered. The frame rate nodes are shared with the client and
+// telemetry accesses: the grab thread goes through the control
+// channel first in line.
+//-----------------------------------------------------
+bool Camera::_throttleFrameRate()
+{
+    DEB_MEMBER_FUNCT();
+    bool throttled = false;
+    try
+      {
+	m_control.command(ControlChannel::Critical,[&]() {
+	    bool abs_rate = !(IsAvailable(Camera_->AcquisitionFrameRate) || m_is_usb);
+	    if(abs_rate ? !IsWritable(Camera_->AcquisitionFrameRateAbs) :
+	       !IsWritable(Camera_->AcquisitionFrameRate))
+	      {
+		DEB_WARNING() << "Frame rate is not writable, can't throttle";
+		return;
+	      }
+	    if(m_throttle_saved_rate < 0.)
+	      {
+		m_throttle_saved_enable = Camera_->AcquisitionFrameRateEnable.GetValue();
+		m_throttle_saved_rate = abs_rate ?
+		  Camera_->AcquisitionFrameRateAbs.GetValue() :
+		  Camera_->AcquisitionFrameRate.GetValue();
+	      }
+	    double frame_rate;
+	    _readFrameRate(frame_rate);
+	    double rate = frame_rate * OVERRUN_THROTTLE_FACTOR;
+	    double minrate = abs_rate ?
+	      Camera_->AcquisitionFrameRateAbs.GetMin() :
+	      Camera_->AcquisitionFrameRate.GetMin();
+	    if(rate < minrate)
+	      {
+		DEB_WARNING() << "Frame rate already at its min: " << DEB_VAR1(frame_rate);
+		return;
+	      }
+	    Camera_->AcquisitionFrameRateEnable.SetValue(true);
+	    if(abs_rate)
+	      Camera_->AcquisitionFrameRateAbs.SetValue(rate);
+	    else
+	      Camera_->AcquisitionFrameRate.SetValue(rate);
+	    DEB_WARNING() << "Frame rate throttled: " << DEB_VAR2(frame_rate,rate);
+	    throttled = true;
+	  });
+      }
+    catch (Pylon::GenericException &e)
+      {
+	DEB_WARNING() << "Can't throttle frame rate: " << e.GetDescription();
+      }
+    catch (Exception &e)
+      {
+	DEB_WARNING() << "Can't throttle frame rate: " << e.getErrMsg();
+      }
+    return throttled;
+}
+
+//-----------------------------------------------------
+// frame rate before the throttle overrun policy
+//-----------------------------------------------------
+void Camera::_restoreFrameRate()
+{
+    DEB_MEMBER_FUNCT();
+    try
+      {
+	m_control.command(ControlChannel::Normal,[&]() {
+	    if(IsAvailable(Camera_->AcquisitionFrameRate) || m_is_usb)
+	      Camera_->AcquisitionFrameRate.SetValue(m_throttle_saved_rate);
+	    else
+	      Camera_->AcquisitionFrameRateAbs.SetValue(m_throttle_saved_rate);
+	    Camera_->AcquisitionFrameRateEnable.SetValue(m_throttle_saved_enable);
+	  });
+      }
+    catch (Pylon::GenericException &e)
+      {
+	DEB_WARNING() << "Can't restore frame rate: " << e.GetDescription();
+      }
+    m_throttle_saved_rate = -1.;
+}
+
+//---------------------------
+//
+//---------------------------
+Camera::Telemetry::Telemetry() :
+  age(0.),
+  temperature(0.),
+  frame_rate(0.),
+  current_throughput(0),
+  max_throughput(0),
+  bandwidth_assigned(0)
+{
+}
+
+//-----------------------------------------------------
+// setTelemetryPeriod
+//-----------------------------------------------------
+void Camera::setTelemetryPeriod(double period)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(period);
+    if(period < 0.)
+      THROW_HW_ERROR(InvalidValue) << "Telemetry period must be >= 0";
+    // read by the sampler thread when it wakes up
+    m_telemetry_period = period;
+    if(period > 0.)
+      {
+	if(!m_telemetry_sampler)
+	  {
+	    m_telemetry_sampler = new _TelemetrySampler(*this);
+	    m_telemetry_sampler->start();
+	  }
+	else
+	  m_telemetry_sampler->wakeup();
+      }
+    else if(m_telemetry_sampler)
+      {
+	delete m_telemetry_sampler;
+	m_telemetry_sampler = NULL;
+	std::atomic_store(&m_telemetry,std::shared_ptr<const Telemetry>());
+      }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getTelemetryPeriod(double& period) const
+{
+    period = m_telemetry_period;
+}
+
+//-----------------------------------------------------
+// setTelemetryGrabRateLimit
+//-----------------------------------------------------
+void Camera::setTelemetryGrabRateLimit(double frame_rate)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(frame_rate);
+    if(frame_rate < 0.)
+      THROW_HW_ERROR(InvalidValue) << "Telemetry grab rate limit must be >= 0";
+    m_telemetry_grab_rate_limit = frame_rate;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getTelemetryGrabRateLimit(double& frame_rate) const
+{
+    frame_rate = m_telemetry_grab_rate_limit;
+}
+
+//-----------------------------------------------------
+// getTelemetry, the latest sample with its age
+//-----------------------------------------------------
+void Camera::getTelemetry(Telemetry& telemetry) const
+{
+    DEB_MEMBER_FUNCT();
+    std::shared_ptr<const Telemetry> cached = _getCachedTelemetry();
+    if(!cached)
+      THROW_HW_ERROR(Error) << "No telemetry sampled";
+    telemetry = *cached;
+    telemetry.age = Timestamp::now() - telemetry.timestamp;
+    DEB_RETURN() << DEB_VAR2(telemetry.age,telemetry.temperature);
+}
+
+//-----------------------------------------------------
+// getControlChannelStatistics
+//-----------------------------------------------------
+void Camera::getControlChannelStatistics(ControlChannel::Statistics& stats) const
+{
+    m_control.getStatistics(stats);
+}
+
+//-----------------------------------------------------
+// resetControlChannelStatistics
+//-----------------------------------------------------
+void Camera::resetControlChannelStatistics()
+{
+    m_control.resetStatistics();
+}
+
+//-----------------------------------------------------
+// NULL if the telemetry is read live
+//-----------------------------------------------------
+std::shared_ptr<const Camera::Telemetry> Camera::_getCachedTelemetry() const
+{
+    return std::atomic_load(&m_telemetry);
+}
+
+//-----------------------------------------------------
+// called from the sampler thread, all the values in one batch
+//-----------------------------------------------------
+void Camera::_sampleTelemetry(Telemetry& telemetry) const
+{
+    DEB_MEMBER_FUNCT();
+    try
+      {
+	// one background request, the inner frame rate read runs inline
+	m_control.command(ControlChannel::Background,[&]() {
+	    _readFrameRate(telemetry.frame_rate);
+	    if(IsAvailable(Camera_->TemperatureAbs))
+	      telemetry.temperature = Camera_->TemperatureAbs.GetValue();
+	    else if(IsAvailable(Camera_->DeviceTemperature))
+	      telemetry.temperature = Camera_->DeviceTemperature.GetValue();
+	    if(!m_is_usb)
+	      {
+		telemetry.current_throughput = Camera_->GevSCDCT.GetValue();
+		telemetry.max_throughput = Camera_->GevSCDMT.GetValue();
+		telemetry.bandwidth_assigned = Camera_->GevSCBWA.GetValue();
+	      }
+	  });
+      }
+    catch (Pylon::GenericException &e)
+      {
+	THROW_HW_ERROR(Error) << e.GetDescription();
+      }
+    telemetry.timestamp = Timestamp::now();
+}
+
+//-----------------------------------------------------
+// setPreviewMode, used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setPreviewMode(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    m_preview_mode = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPreviewMode(bool& active) const
+{
+    active = m_preview_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setPreviewDecimation(int nth)
+{
+    m_preview.setDecimation(nth);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPreviewDecimation(int& nth) const
+{
+    nth = m_preview.getDecimation();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setPreviewMaxRate(double max_rate)
+{
+    m_preview.setMaxRate(max_rate);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPreviewMaxRate(double& max_rate) const
+{
+    max_rate = m_preview.getMaxRate();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setPreviewBinning(int factor)
+{
+    m_preview.setBinning(factor);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getPreviewBinning(int& factor) const
+{
+    factor = m_preview.getBinning();
+}
+
+//-----------------------------------------------------
+// getPreviewImage, frame_nb is -1 if no preview yet
+//-----------------------------------------------------
+void Camera::getPreviewImage(std::vector<char>& data,int& frame_nb,
+			     int& width,int& height,ImageType& type) const
+{
+    m_preview.getImage(data,frame_nb,width,height,type);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbPreviewFrames(int& nb_frames) const
+{
+    m_preview.getNbPreviewFrames(nb_frames);
+}
+
+//-----------------------------------------------------
+// setFrameStatsMode, used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setFrameStatsMode(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    m_frame_stats_mode = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameStatsMode(bool& active) const
+{
+    active = m_frame_stats_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setFrameStatsNbBins(int nb_bins)
+{
+    m_frame_stats.setNbBins(nb_bins);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameStatsNbBins(int& nb_bins) const
+{
+    nb_bins = m_frame_stats.getNbBins();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setFrameStatsSaturationLevel(int level)
+{
+    m_frame_stats.setSaturationLevel(level);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameStatsSaturationLevel(int& level) const
+{
+    level = m_frame_stats.getSaturationLevel();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setFrameStatsRoi(const Roi& roi)
+{
+    m_frame_stats.setRoi(roi);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameStatsRoi(Roi& roi) const
+{
+    m_frame_stats.getRoi(roi);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setFrameStatsRingSize(int nb_results)
+{
+    m_frame_stats.setRingSize(nb_results);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getFrameStatsRingSize(int& nb_results) const
+{
+    nb_results = m_frame_stats.getRingSize();
+}
+
+//-----------------------------------------------------
+// getFrameStats, bulk read of the ring
+//-----------------------------------------------------
+void Camera::getFrameStats(long long since,std::vector<FrameStats::Result>& results,
+			   long long& next) const
+{
+    m_frame_stats.getResults(since,results,next);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getLastFrameStats(FrameStats::Result& result) const
+{
+    DEB_MEMBER_FUNCT();
+    if(!m_frame_stats.getLastResult(result))
+      THROW_HW_ERROR(Error) << "No frame stats";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbFrameStats(long long& nb_results) const
+{
+    nb_results = m_frame_stats.getNbResults();
+}
+
+//-----------------------------------------------------
+// setBeamAnalysisMode, used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setBeamAnalysisMode(bool active)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(active);
+    m_beam_analysis_mode = active;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBeamAnalysisMode(bool& active) const
+{
+    active = m_beam_analysis_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBeamBackground(double level)
+{
+    m_beam_analysis.setBackground(level);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBeamBackground(double& level) const
+{
+    level = m_beam_analysis.getBackground();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBeamThreshold(double threshold)
+{
+    m_beam_analysis.setThreshold(threshold);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBeamThreshold(double& threshold) const
+{
+    threshold = m_beam_analysis.getThreshold();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBeamRoi(const Roi& roi)
+{
+    m_beam_analysis.setRoi(roi);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBeamRoi(Roi& roi) const
+{
+    m_beam_analysis.getRoi(roi);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBeamNbThreads(int nb_threads)
+{
+    m_beam_analysis.setNbThreads(nb_threads);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBeamNbThreads(int& nb_threads) const
+{
+    nb_threads = m_beam_analysis.getNbThreads();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setBeamRingSize(int nb_results)
+{
+    m_beam_analysis.setRingSize(nb_results);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getBeamRingSize(int& nb_results) const
+{
+    nb_results = m_beam_analysis.getRingSize();
+}
+
+//-----------------------------------------------------
+// getBeamResults, bulk read of the ring
+//-----------------------------------------------------
+void Camera::getBeamResults(long long since,std::vector<BeamAnalysis::Result>& results,
+			    long long& next) const
+{
+    m_beam_analysis.getResults(since,results,next);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getLastBeamResult(BeamAnalysis::Result& result) const
+{
+    DEB_MEMBER_FUNCT();
+    if(!m_beam_analysis.getLastResult(result))
+      THROW_HW_ERROR(Error) << "No beam analysis result";
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getNbBeamResults(long long& nb_results) const
+{
+    nb_results = m_beam_analysis.getNbResults();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Camera::AutoExposureLoopState::AutoExposureLoopState() :
+  running(false),
+  converged(false),
+  level(-1.),
+  exp_time(0.),
+  gain(0.),
+  frame_index(-1),
+  nb_adjustments(0)
+{
+}
+
+//-----------------------------------------------------
+// setAutoExposureLoopMode, used at the next prepareAcq
+//-----------------------------------------------------
+void Camera::setAutoExposureLoopMode(AutoExposureLoopMode mode)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(mode);
+    m_auto_exposure_loop_mode = mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopMode(AutoExposureLoopMode& mode) const
+{
+    mode = m_auto_exposure_loop_mode;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setAutoExposureLoopTarget(double level)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(level);
+    if(level <= 0. || level > 1.)
+      THROW_HW_ERROR(InvalidValue) << "Auto exposure target must be in range ]0.0,1.0]";
+    m_auto_exposure_loop_target = level;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopTarget(double& level) const
+{
+    level = m_auto_exposure_loop_target;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setAutoExposureLoopPercentile(double percentile)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(percentile);
+    if(percentile <= 0. || percentile > 1.)
+      THROW_HW_ERROR(InvalidValue) << "Auto exposure percentile must be in range ]0.0,1.0]";
+    m_auto_exposure_loop_percentile = percentile;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopPercentile(double& percentile) const
+{
+    percentile = m_auto_exposure_loop_percentile;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setAutoExposureLoopTolerance(double tolerance)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(tolerance);
+    if(tolerance < 0. || tolerance >= 1.)
+      THROW_HW_ERROR(InvalidValue) << "Auto exposure tolerance must be in range [0.0,1.0[";
+    m_auto_exposure_loop_tolerance = tolerance;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopTolerance(double& tolerance) const
+{
+    tolerance = m_auto_exposure_loop_tolerance;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setAutoExposureLoopMaxStep(double factor)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(factor);
+    if(factor <= 1.)
+      THROW_HW_ERROR(InvalidValue) << "Auto exposure max step must be > 1";
+    m_auto_exposure_loop_max_step = factor;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopMaxStep(double& factor) const
+{
+    factor = m_auto_exposure_loop_max_step;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setAutoExposureLoopMaxExpTime(double exp_time)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(exp_time);
+    if(exp_time < 0.)
+      THROW_HW_ERROR(InvalidValue) << "Auto exposure max exposure time must be >= 0";
+    m_auto_exposure_loop_max_exp_time = exp_time;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopMaxExpTime(double& exp_time) const
+{
+    exp_time = m_auto_exposure_loop_max_exp_time;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::setAutoExposureLoopSettleFrames(int nb_frames)
+{
+    DEB_MEMBER_FUNCT();
+    DEB_PARAM() << DEB_VAR1(nb_frames);
+    if(nb_frames < 0)
+      THROW_HW_ERROR(InvalidValue) << "Auto exposure settle frames must be >= 0";
+    m_auto_exposure_loop_settle_frames = nb_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopSettleFrames(int& nb_frames) const
+{
+    nb_frames = m_auto_exposure_loop_settle_frames;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void Camera::getAutoExposureLoopState(AutoExposureLoopState& state) const
+{
+    if(m_auto_exposure_loop)
+      m_auto_exposure_loop->getState(state);
+    else
+      state = AutoExposureLoopState();
+}
+
+//-----------------------------------------------------
+// gain range in dB, the normalized gain of setGain spans it
+//-----------------------------------------------------
+double Camera::_getGainSpan() const
+{
+    DEB_MEMBER_FUNCT();
+    try
+    {
+      return m_control.read<double>(ControlChannel::Normal,"GainSpan",[&]() {
+        if (Camera_->GetSfncVersion() >= Sfnc_2_0_0)
+	  return double(Camera_->Gain.GetMax() - Camera_->Gain.GetMin());
+	else
+	  return double(Camera_->GainRaw.GetMax() - Camera_->GainRaw.GetMin()) * GAIN_RAW_DB;
+      });
+    }
+    catch (Pylon::GenericException &e)
+    {
+        THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+}
+
+//-----------------------------------------------------
+// starting point and limits of the loop for the new acquisition
+//-----------------------------------------------------
+void Camera::_prepareAutoExposureLoop()
+{
+    DEB_MEMBER_FUNCT();
+    bool running = (m_auto_exposure_loop_mode != AutoExposureLoopOff &&
+		    m_frame_stats.isActive());
+    double gain = 0.,min_exp_time = 0.,max_exp_time = 0.,gain_span = 0.;
+    bool exp_time_adjustable = false;
+    if(running)
+      {
+	// the exposure time is not set with ExtGate
+	TrigMode mode;
+	getTrigMode(mode);
+	exp_time_adjustable = mode != ExtGate;
+	getExposureTimeRange(min_exp_time,max_exp_time);
+	if(m_auto_exposure_loop_max_exp_time > 0.)
+	  max_exp_time = min(max_exp_time,m_auto_exposure_loop_max_exp_time);
+	getGain(gain);
+	if(m_auto_exposure_loop_mode == AutoExposureLoopExpTimeGain)
+	  gain_span = _getGainSpan();
+      }
+    m_auto_exposure_loop->reset(running,m_exp_time,gain,min_exp_time,max_exp_time,
+				gain_span,exp_time_adjustable);
+}
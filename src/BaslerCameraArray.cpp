@@ -0,0 +1,388 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <algorithm>
+#include "BaslerCameraArray.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+//---------------------------
+//- CameraArray::_GrabThread
+//---------------------------
+class CameraArray::_GrabThread : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera, "CameraArray", "_GrabThread");
+public:
+  _GrabThread(CameraArray& anArray) : m_array(anArray) {}
+  virtual ~_GrabThread() {join();}
+protected:
+  virtual void threadFunction() {m_array._grabLoop();}
+private:
+  CameraArray&	m_array;
+};
+
+//---------------------------
+//- Ctor
+//---------------------------
+CameraArray::CameraArray(const std::vector<std::string>& camera_ids,
+			 int packet_size,int receive_priority) :
+  m_grab_thread(NULL)
+{
+  DEB_CONSTRUCTOR();
+  if(camera_ids.empty())
+    THROW_HW_ERROR(InvalidValue) << "Camera array needs at least one camera";
+
+  try
+    {
+      m_array.Initialize(camera_ids.size());
+      for(size_t i = 0;i < camera_ids.size();++i)
+	{
+	  std::string camera_id = camera_ids[i];
+	  DEB_TRACE() << "Attach " << DEB_VAR2(i,camera_id);
+	  m_array[i].Attach(Camera::_createDevice(camera_id));
+	  m_array[i].SetCameraContext(i);
+	  Camera *aCam = new Camera(&m_array[i],camera_id,packet_size,receive_priority);
+	  aCam->m_camera_array = this;
+	  aCam->m_array_index = i;
+	  m_cameras.push_back(aCam);
+	}
+    }
+  catch (Pylon::GenericException &e)
+    {
+      for(std::vector<Camera*>::iterator i = m_cameras.begin();i != m_cameras.end();++i)
+	delete *i;
+      THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+
+  m_started.resize(m_cameras.size(),false);
+  m_nb_grabbed.resize(m_cameras.size(),0);
+  m_aligner.reset(getNbCameras());
+}
+
+//---------------------------
+//- Dtor
+//---------------------------
+CameraArray::~CameraArray()
+{
+  DEB_DESTRUCTOR();
+  try
+    {
+      m_array.StopGrabbing();
+    }
+  catch (Pylon::GenericException &e)
+    {
+      DEB_ERROR() << e.GetDescription();
+    }
+  delete m_grab_thread;
+  for(std::vector<Camera*>::iterator i = m_cameras.begin();i != m_cameras.end();++i)
+    delete *i;
+  m_array.DestroyDevice();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+int CameraArray::getNbCameras() const
+{
+  return int(m_cameras.size());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+Camera& CameraArray::getCamera(int camera_index)
+{
+  DEB_MEMBER_FUNCT();
+  if(camera_index < 0 || camera_index >= getNbCameras())
+    THROW_HW_ERROR(InvalidValue) << "Invalid camera index " << camera_index;
+  return *m_cameras[camera_index];
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::setTrigMode(TrigMode mode)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(mode);
+  if(mode == IntTrigMult)
+    THROW_HW_ERROR(NotSupported) << "IntTrigMult is not available with a camera array";
+  for(std::vector<Camera*>::iterator i = m_cameras.begin();i != m_cameras.end();++i)
+    (*i)->setTrigMode(mode);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::setExpTime(double exp_time)
+{
+  for(std::vector<Camera*>::iterator i = m_cameras.begin();i != m_cameras.end();++i)
+    (*i)->setExpTime(exp_time);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::setLatTime(double lat_time)
+{
+  for(std::vector<Camera*>::iterator i = m_cameras.begin();i != m_cameras.end();++i)
+    (*i)->setLatTime(lat_time);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::setNbFrames(int nb_frames)
+{
+  for(std::vector<Camera*>::iterator i = m_cameras.begin();i != m_cameras.end();++i)
+    (*i)->setNbFrames(nb_frames);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::setAlignMode(AlignMode mode)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(mode);
+  AutoMutex aLock(m_mutex);
+  m_aligner.setAlignMode(mode == AlignByTimestamp ?
+			 FrameSetAligner::AlignByTimestamp :
+			 FrameSetAligner::AlignByFrameCounter);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getAlignMode(AlignMode& mode) const
+{
+  AutoMutex aLock(m_mutex);
+  mode = m_aligner.getAlignMode() == FrameSetAligner::AlignByTimestamp ?
+    AlignByTimestamp : AlignByFrameCounter;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::setAlignTolerance(double tolerance)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(tolerance);
+  if(tolerance < 0.)
+    THROW_HW_ERROR(InvalidValue) << "Align tolerance must be >= 0";
+  AutoMutex aLock(m_mutex);
+  m_aligner.setAlignTolerance(tolerance);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getAlignTolerance(double& tolerance) const
+{
+  AutoMutex aLock(m_mutex);
+  tolerance = m_aligner.getAlignTolerance();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::setFrameSetHistory(int nb_sets)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nb_sets);
+  if(nb_sets < 1)
+    THROW_HW_ERROR(InvalidValue) << "Frame set history must be >= 1";
+  AutoMutex aLock(m_mutex);
+  m_aligner.setFrameSetHistory(nb_sets);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getFrameSetHistory(int& nb_sets) const
+{
+  AutoMutex aLock(m_mutex);
+  nb_sets = m_aligner.getFrameSetHistory();
+}
+
+//-----------------------------------------------------
+// sets are numbered in the order they are opened,
+// a set not closed yet has no frame
+//-----------------------------------------------------
+void CameraArray::getNbFrameSets(int& nb_sets) const
+{
+  AutoMutex aLock(m_mutex);
+  nb_sets = m_aligner.getNbFrameSets();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getFrameSet(int set_nb,std::vector<int>& frame_nbs,double& skew) const
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(set_nb);
+  AutoMutex aLock(m_mutex);
+  FrameSetAligner::FrameSet frame_set;
+  if(!m_aligner.getFrameSet(set_nb,frame_set))
+    THROW_HW_ERROR(InvalidValue) << "Frame set " << set_nb << " not available";
+  frame_nbs = frame_set.frame_nbs;
+  skew = frame_set.skew;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getNbIncompleteFrameSets(int& nb_sets) const
+{
+  AutoMutex aLock(m_mutex);
+  nb_sets = m_aligner.getNbIncompleteFrameSets();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getNbSkewedFrameSets(int& nb_sets) const
+{
+  AutoMutex aLock(m_mutex);
+  nb_sets = m_aligner.getNbSkewedFrameSets();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getMaxSkew(double& skew) const
+{
+  AutoMutex aLock(m_mutex);
+  skew = m_aligner.getMaxSkew();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::getDroppedFrames(std::vector<int>& nb_dropped) const
+{
+  AutoMutex aLock(m_mutex);
+  nb_dropped = m_aligner.getDroppedFrames();
+}
+
+//-----------------------------------------------------
+// called by Camera::_startAcq, grabbing of all the
+// cameras starts with the last one
+//-----------------------------------------------------
+void CameraArray::_startCamera(int camera_index)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(camera_index);
+
+  AutoMutex aLock(m_mutex);
+  if(std::find(m_started.begin(),m_started.end(),true) == m_started.end())
+    {
+      // first camera of a new acquisition
+      std::fill(m_nb_grabbed.begin(),m_nb_grabbed.end(),0);
+      m_aligner.reset(getNbCameras());
+    }
+  m_started[camera_index] = true;
+  if(std::find(m_started.begin(),m_started.end(),false) != m_started.end())
+    return;
+
+  std::fill(m_started.begin(),m_started.end(),false);
+  aLock.unlock();
+
+  delete m_grab_thread;
+  m_grab_thread = NULL;
+  try
+    {
+      DEB_TRACE() << "Start grabbing of all the cameras";
+      m_array.StartGrabbing(GrabStrategy_OneByOne,GrabLoop_ProvidedByUser);
+    }
+  catch (Pylon::GenericException &e)
+    {
+      THROW_HW_ERROR(Error) << e.GetDescription();
+    }
+  m_grab_thread = new _GrabThread(*this);
+  m_grab_thread->start();
+}
+
+//-----------------------------------------------------
+// camera stopped before all the cameras were started
+//-----------------------------------------------------
+void CameraArray::_stopCamera(int camera_index)
+{
+  AutoMutex aLock(m_mutex);
+  m_started[camera_index] = false;
+}
+
+//-----------------------------------------------------
+// image event handlers of the cameras are called
+// by RetrieveResult
+//-----------------------------------------------------
+void CameraArray::_grabLoop()
+{
+  DEB_MEMBER_FUNCT();
+  try
+    {
+      while(m_array.IsGrabbing())
+	{
+	  CBaslerUniversalGrabResultPtr ptrGrabResult;
+	  if(!m_array.RetrieveResult(1000,ptrGrabResult,TimeoutHandling_Return))
+	    continue;
+
+	  int camera_index = int(ptrGrabResult->GetCameraContext());
+	  Camera& aCam = *m_cameras[camera_index];
+	  // the frame given to lima by the image event handler, none for
+	  // a dropped or late frame or a non last exposure of an HDR group
+	  int frame_nb = aCam._getLastFrameNb();
+	  if(ptrGrabResult->GrabSucceeded() && frame_nb >= 0)
+	    {
+	      double timestamp = double(ptrGrabResult->GetTimeStamp() - aCam.m_tick_start) /
+		aCam.m_tick_frequency;
+	      _alignFrame(camera_index,frame_nb,timestamp,aCam._getLastBlockNb());
+	    }
+
+	  int nb_frames = aCam.m_nb_frames;
+	  if(nb_frames && ++m_nb_grabbed[camera_index] >= nb_frames)
+	    m_array[camera_index].StopGrabbing();
+	}
+    }
+  catch (Pylon::GenericException &e)
+    {
+      DEB_ERROR() << "GeniCam Error! " << e.GetDescription();
+    }
+  AutoMutex aLock(m_mutex);
+  m_aligner.flush();
+  DEB_TRACE() << "Grab loop finished: " << DEB_VAR2(m_aligner.getNbFrameSets(),
+						  m_aligner.getNbIncompleteFrameSets());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void CameraArray::_alignFrame(int camera_index,int frame_nb,double timestamp,
+			      long long block_nb)
+{
+  AutoMutex aLock(m_mutex);
+  m_aligner.addFrame(camera_index,frame_nb,timestamp,block_nb);
+}
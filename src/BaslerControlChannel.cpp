@@ -0,0 +1,281 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include "lima/Exceptions.h"
+#include "BaslerAffinity.h"
+#include "BaslerControlChannel.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+//---------------------------
+//- ControlChannel::_Thread
+//---------------------------
+class ControlChannel::_Thread : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera,"ControlChannel","_Thread");
+public:
+  _Thread(ControlChannel& aChannel) : m_channel(aChannel) {}
+  virtual ~_Thread()
+  {
+    {
+      AutoMutex aLock(m_channel.m_cond.mutex());
+      m_channel.m_quit = true;
+      m_channel.m_cond.broadcast();
+    }
+    join();
+  }
+protected:
+  virtual void threadFunction() {m_channel._run();}
+private:
+  ControlChannel&	m_channel;
+};
+
+//---------------------------
+//- ControlChannel::Statistics::Statistics()
+//---------------------------
+ControlChannel::Statistics::Statistics() :
+  queue_depth(0),
+  max_queue_depth(0),
+  nb_requests(0),
+  nb_merged(0),
+  mean_wait(0.),
+  max_wait(0.),
+  critical_max_wait(0.)
+{
+}
+
+//---------------------------
+//- ControlChannel::ControlChannel()
+//---------------------------
+ControlChannel::ControlChannel() :
+  m_quit(false),
+  m_thread_id(0),
+  m_wait_sum(0.),
+  m_nb_waits(0)
+{
+  DEB_CONSTRUCTOR();
+  m_thread = new _Thread(*this);
+  m_thread->start();
+}
+
+//---------------------------
+//- ControlChannel::~ControlChannel()
+//---------------------------
+ControlChannel::~ControlChannel()
+{
+  DEB_DESTRUCTOR();
+  delete m_thread;
+}
+
+//---------------------------
+//- ControlChannel::write()
+//---------------------------
+void ControlChannel::write(Priority priority,const std::string& key,
+			   std::function<void()> function)
+{
+  _RequestPtr request = _newRequest(_Write,priority,key,function);
+  _execute(request);
+}
+
+//---------------------------
+//- ControlChannel::command()
+//---------------------------
+void ControlChannel::command(Priority priority,std::function<void()> function)
+{
+  _RequestPtr request = _newRequest(_Command,priority,"",function);
+  _execute(request);
+}
+
+//---------------------------
+//- ControlChannel::getStatistics()
+//---------------------------
+void ControlChannel::getStatistics(Statistics& stats) const
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  stats = m_stats;
+  stats.queue_depth = int(m_queues[Critical].size() + m_queues[Normal].size() +
+			  m_queues[Background].size());
+  stats.mean_wait = m_nb_waits ? m_wait_sum / m_nb_waits : 0.;
+  DEB_RETURN() << DEB_VAR3(stats.queue_depth,stats.mean_wait,stats.max_wait);
+}
+
+//---------------------------
+//- ControlChannel::resetStatistics()
+//---------------------------
+void ControlChannel::resetStatistics()
+{
+  AutoMutex aLock(m_cond.mutex());
+  m_stats = Statistics();
+  m_wait_sum = 0.;
+  m_nb_waits = 0;
+}
+
+//---------------------------
+//- ControlChannel::_newRequest()
+//---------------------------
+ControlChannel::_RequestPtr
+ControlChannel::_newRequest(_Kind kind,Priority priority,const std::string& key,
+			    const std::function<void()>& function)
+{
+  _RequestPtr request = std::make_shared<_Request>();
+  request->kind = kind;
+  request->priority = priority;
+  request->key = (kind == _Read ? "r:" : "w:") + key;
+  request->function = function;
+  request->done = false;
+  return request;
+}
+
+//---------------------------
+//- ControlChannel::_execute()
+//---------------------------
+void ControlChannel::_execute(_RequestPtr& request)
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  if(m_thread_id == Affinity::getThreadId())
+    {
+      aLock.unlock();
+      request->function();
+      return;
+    }
+
+  ++m_stats.nb_requests;
+  std::map<std::string,_RequestPtr>::iterator i = m_pending.end();
+  if(request->kind != _Command)
+    i = m_pending.find(request->key);
+  if(i != m_pending.end())
+    {
+      // the newest value of a node write wins, the merged callers
+      // wait for it and get its result
+      if(request->kind == _Write)
+	i->second->function = request->function;
+      // a trigger can't wait behind a background read
+      if(request->priority < i->second->priority)
+	{
+	  std::deque<_RequestPtr>& queue = m_queues[i->second->priority];
+	  for(std::deque<_RequestPtr>::iterator q = queue.begin();q != queue.end();++q)
+	    if(*q == i->second)
+	      {
+		queue.erase(q);
+		break;
+	      }
+	  i->second->priority = request->priority;
+	  m_queues[request->priority].push_back(i->second);
+	}
+      request = i->second;
+      ++m_stats.nb_merged;
+    }
+  else
+    {
+      request->queued = Timestamp::now();
+      if(request->kind != _Command)
+	m_pending[request->key] = request;
+      m_queues[request->priority].push_back(request);
+      int depth = int(m_queues[Critical].size() + m_queues[Normal].size() +
+		      m_queues[Background].size());
+      if(depth > m_stats.max_queue_depth)
+	m_stats.max_queue_depth = depth;
+      m_cond.broadcast();
+    }
+
+  _RequestPtr keep = request;
+  while(!keep->done)
+    m_cond.wait();
+  if(keep->error)
+    std::rethrow_exception(keep->error);
+}
+
+//---------------------------
+//- ControlChannel::_run()
+//---------------------------
+void ControlChannel::_run()
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  m_thread_id = Affinity::getThreadId();
+  while(!m_quit)
+    {
+      std::deque<_RequestPtr>* queue = NULL;
+      for(int priority = Critical;!queue && priority <= Background;++priority)
+	if(!m_queues[priority].empty())
+	  queue = &m_queues[priority];
+      if(!queue)
+	{
+	  m_cond.wait();
+	  continue;
+	}
+
+      _RequestPtr request = queue->front();
+      queue->pop_front();
+      if(request->kind != _Command)
+	m_pending.erase(request->key);
+
+      double wait = Timestamp::now() - request->queued;
+      m_wait_sum += wait;
+      ++m_nb_waits;
+      if(wait > m_stats.max_wait)
+	m_stats.max_wait = wait;
+      if(request->priority == Critical && wait > m_stats.critical_max_wait)
+	m_stats.critical_max_wait = wait;
+
+      std::function<void()> function = request->function;
+      {
+	AutoMutexUnlock aUnlock(aLock);
+	try
+	  {
+	    function();
+	  }
+	catch(...)
+	  {
+	    request->error = std::current_exception();
+	  }
+      }
+      request->done = true;
+      m_cond.broadcast();
+    }
+
+  // no request is left waiting
+  for(int priority = Critical;priority <= Background;++priority)
+    {
+      for(std::deque<_RequestPtr>::iterator i = m_queues[priority].begin();
+	  i != m_queues[priority].end();++i)
+	{
+	  try
+	    {
+	      THROW_HW_ERROR(Error) << "Control channel closed";
+	    }
+	  catch(...)
+	    {
+	      (*i)->error = std::current_exception();
+	    }
+	  (*i)->done = true;
+	}
+      m_queues[priority].clear();
+    }
+  m_pending.clear();
+  m_cond.broadcast();
+}
@@ -0,0 +1,206 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <algorithm>
+#include <cmath>
+#include "BaslerFrameSetAligner.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+//---------------------------
+//- Ctor
+//---------------------------
+FrameSetAligner::FrameSetAligner() :
+  m_align_mode(AlignByFrameCounter),
+  m_align_tolerance(1e-3),
+  m_history(DEFAULT_FRAME_SET_HISTORY),
+  m_nb_cameras(0),
+  m_nb_frame_sets(0),
+  m_next_set_nb(0),
+  m_nb_incomplete_sets(0),
+  m_nb_skewed_sets(0),
+  m_max_skew(0.)
+{
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameSetAligner::reset(int nb_cameras)
+{
+  m_nb_cameras = nb_cameras;
+  m_pending_sets.clear();
+  m_frame_sets.assign(std::max(m_history,1),FrameSet());
+  m_nb_frame_sets = 0;
+  m_last_set_nbs.assign(nb_cameras,-1);
+  m_nb_dropped.assign(nb_cameras,0);
+  m_next_set_nb = 0;
+  m_nb_incomplete_sets = 0;
+  m_nb_skewed_sets = 0;
+  m_max_skew = 0.;
+}
+
+//-----------------------------------------------------
+// frame counter: set is the block number, the lima frame numbers
+// of the cameras differ after a drop
+// timestamp: first open set within tolerance without
+// a frame of this camera, else a new set
+//-----------------------------------------------------
+void FrameSetAligner::addFrame(int camera_index,int frame_nb,double timestamp,
+			       long long block_nb)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR4(camera_index,frame_nb,timestamp,block_nb);
+
+  int set_nb = -1;
+  if(m_align_mode == AlignByFrameCounter)
+    set_nb = block_nb >= 0 ? int(block_nb) : frame_nb;
+  else
+    {
+      for(std::map<int,FrameSet>::iterator i = m_pending_sets.begin();
+	  i != m_pending_sets.end();++i)
+	{
+	  FrameSet& aSet = i->second;
+	  if(aSet.frame_nbs[camera_index] >= 0)
+	    continue;
+	  double ref_timestamp = *std::max_element(aSet.timestamps.begin(),aSet.timestamps.end());
+	  if(std::abs(ref_timestamp - timestamp) <= m_align_tolerance)
+	    {
+	      set_nb = i->first;
+	      break;
+	    }
+	}
+      if(set_nb < 0)
+	set_nb = m_next_set_nb;
+    }
+  m_next_set_nb = std::max(m_next_set_nb,set_nb + 1);
+
+  std::map<int,FrameSet>::iterator i = m_pending_sets.find(set_nb);
+  if(i == m_pending_sets.end())
+    {
+      FrameSet aSet;
+      aSet.set_nb = set_nb;
+      aSet.frame_nbs.assign(m_nb_cameras,-1);
+      aSet.timestamps.assign(m_nb_cameras,-1.);
+      aSet.nb_frames = 0;
+      aSet.skew = 0.;
+      aSet.complete = false;
+      i = m_pending_sets.insert(std::make_pair(set_nb,aSet)).first;
+    }
+  FrameSet& aSet = i->second;
+  aSet.frame_nbs[camera_index] = frame_nb;
+  aSet.timestamps[camera_index] = timestamp;
+  m_last_set_nbs[camera_index] = std::max(m_last_set_nbs[camera_index],set_nb);
+
+  if(++aSet.nb_frames == m_nb_cameras)
+    {
+      aSet.complete = true;
+      _closeFrameSet(set_nb,aSet);
+      m_pending_sets.erase(i);
+    }
+  _flushFrameSets(false);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameSetAligner::flush()
+{
+  _flushFrameSets(true);
+}
+
+//-----------------------------------------------------
+// a set not closed yet has no frame
+//-----------------------------------------------------
+bool FrameSetAligner::getFrameSet(int set_nb,FrameSet& frame_set) const
+{
+  if(set_nb < 0 || m_frame_sets.empty())
+    return false;
+  const FrameSet& aSet = m_frame_sets[set_nb % m_frame_sets.size()];
+  if(aSet.frame_nbs.empty() || aSet.set_nb != set_nb)
+    return false;
+  frame_set = aSet;
+  return true;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void FrameSetAligner::_closeFrameSet(int set_nb,FrameSet& frame_set)
+{
+  DEB_MEMBER_FUNCT();
+
+  double min_ts = -1.,max_ts = -1.;
+  for(size_t i = 0;i < frame_set.frame_nbs.size();++i)
+    {
+      if(frame_set.frame_nbs[i] < 0)
+	{
+	  ++m_nb_dropped[i];
+	  DEB_WARNING() << "Frame set " << set_nb << ": camera " << i << " dropped a frame";
+	  continue;
+	}
+      double ts = frame_set.timestamps[i];
+      if(min_ts < 0. || ts < min_ts) min_ts = ts;
+      if(ts > max_ts) max_ts = ts;
+    }
+  frame_set.skew = max_ts - min_ts;
+  m_max_skew = std::max(m_max_skew,frame_set.skew);
+  if(frame_set.skew > m_align_tolerance)
+    {
+      ++m_nb_skewed_sets;
+      DEB_WARNING() << "Frame set " << set_nb << ": skew " << frame_set.skew << " s";
+    }
+  if(!frame_set.complete)
+    ++m_nb_incomplete_sets;
+
+  m_nb_frame_sets = std::max(m_nb_frame_sets,set_nb + 1);
+  if(!m_frame_sets.empty())
+    m_frame_sets[set_nb % m_frame_sets.size()] = frame_set;
+}
+
+//-----------------------------------------------------
+// a pending set is incomplete once every camera missing
+// in it has delivered a frame of a later set, the oldest
+// ones are closed if a camera has stopped delivering
+//-----------------------------------------------------
+void FrameSetAligner::_flushFrameSets(bool all)
+{
+  std::map<int,FrameSet>::iterator i = m_pending_sets.begin();
+  while(i != m_pending_sets.end())
+    {
+      bool dropped = true;
+      bool overflow = m_pending_sets.size() > size_t(std::max(m_history,1));
+      for(int cam = 0;!all && !overflow && dropped && cam < m_nb_cameras;++cam)
+	if(i->second.frame_nbs[cam] < 0 && m_last_set_nbs[cam] <= i->first)
+	  dropped = false;
+      if(!dropped)
+	{
+	  ++i;
+	  continue;
+	}
+      _closeFrameSet(i->first,i->second);
+      m_pending_sets.erase(i++);
+    }
+}
@@ -0,0 +1,458 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "lima/Exceptions.h"
+#include "BaslerFrameStats.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static const int RING_SIZE_DEFAULT = 1000;
+static const int NB_BINS_DEFAULT = 256;
+static const int NB_PARTIAL_HISTOGRAMS = 4;
+// pixels per SSE2 chunk, the 32 bit lanes can't overflow
+static const int REDUCE_CHUNK = 32768;
+
+// sums of a row, exact
+struct _Reduction
+{
+  _Reduction() : sum(0),sum2(0),min(~0u),max(0) {}
+  unsigned long long	sum;
+  unsigned long long	sum2;
+  unsigned int		min;
+  unsigned int		max;
+};
+
+//---------------------------
+// scalar reduction, also the tail of the SSE2 ones
+//---------------------------
+template<class T>
+static void _reduce_scalar(const T* p,int n,_Reduction& red)
+{
+  for(int i = 0;i < n;++i)
+    {
+      unsigned int v = p[i];
+      red.min = std::min(red.min,v);
+      red.max = std::max(red.max,v);
+      red.sum += v;
+      red.sum2 += (unsigned long long)v * v;
+    }
+}
+
+template<class T>
+static void _reduce_row(const T* p,int n,_Reduction& red)
+{
+  _reduce_scalar(p,n,red);
+}
+
+#ifdef __SSE2__
+//---------------------------
+// 8 bit: sad for the sum, madd of the 16 bit values for the squares
+//---------------------------
+template<>
+void _reduce_row(const uint8_t* p,int n,_Reduction& red)
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i vmin = _mm_set1_epi8(char(0xff));
+  __m128i vmax = zero;
+  __m128i vsum = zero;		// 2 x 64 bit
+  int i = 0;
+  while(i + 16 <= n)
+    {
+      int end = std::min(n,i + REDUCE_CHUNK) - 15;
+      __m128i vsum2 = zero;	// 4 x 32 bit, one chunk
+      for(;i < end;i += 16)
+	{
+	  __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+	  vmin = _mm_min_epu8(vmin,v);
+	  vmax = _mm_max_epu8(vmax,v);
+	  vsum = _mm_add_epi64(vsum,_mm_sad_epu8(v,zero));
+	  __m128i lo = _mm_unpacklo_epi8(v,zero);
+	  __m128i hi = _mm_unpackhi_epi8(v,zero);
+	  vsum2 = _mm_add_epi32(vsum2,_mm_add_epi32(_mm_madd_epi16(lo,lo),
+						    _mm_madd_epi16(hi,hi)));
+	}
+      uint32_t sum2[4];
+      _mm_storeu_si128((__m128i*)sum2,vsum2);
+      red.sum2 += (unsigned long long)sum2[0] + sum2[1] + sum2[2] + sum2[3];
+    }
+  uint8_t mins[16],maxs[16];
+  uint64_t sums[2];
+  _mm_storeu_si128((__m128i*)mins,vmin);
+  _mm_storeu_si128((__m128i*)maxs,vmax);
+  _mm_storeu_si128((__m128i*)sums,vsum);
+  if(i)
+    {
+      red.min = std::min<unsigned int>(red.min,*std::min_element(mins,mins + 16));
+      red.max = std::max<unsigned int>(red.max,*std::max_element(maxs,maxs + 16));
+      red.sum += sums[0] + sums[1];
+    }
+  _reduce_scalar(p + i,n - i,red);
+}
+
+//---------------------------
+// 16 bit: biased signed min/max, 32 bit sums, 64 bit squares
+//---------------------------
+template<>
+void _reduce_row(const uint16_t* p,int n,_Reduction& red)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(short(0x8000));
+  __m128i vmin = _mm_set1_epi16(0x7fff);
+  __m128i vmax = bias;
+  __m128i vsum2 = zero;		// 2 x 64 bit
+  int i = 0;
+  while(i + 8 <= n)
+    {
+      int end = std::min(n,i + REDUCE_CHUNK) - 7;
+      __m128i vsum = zero;	// 4 x 32 bit, one chunk
+      for(;i < end;i += 8)
+	{
+	  __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+	  __m128i b = _mm_xor_si128(v,bias);
+	  vmin = _mm_min_epi16(vmin,b);
+	  vmax = _mm_max_epi16(vmax,b);
+	  __m128i lo = _mm_unpacklo_epi16(v,zero);
+	  __m128i hi = _mm_unpackhi_epi16(v,zero);
+	  vsum = _mm_add_epi32(vsum,_mm_add_epi32(lo,hi));
+	  __m128i lo_odd = _mm_srli_epi64(lo,32);
+	  __m128i hi_odd = _mm_srli_epi64(hi,32);
+	  vsum2 = _mm_add_epi64(vsum2,_mm_add_epi64(_mm_mul_epu32(lo,lo),
+						    _mm_mul_epu32(lo_odd,lo_odd)));
+	  vsum2 = _mm_add_epi64(vsum2,_mm_add_epi64(_mm_mul_epu32(hi,hi),
+						    _mm_mul_epu32(hi_odd,hi_odd)));
+	}
+      uint32_t sum[4];
+      _mm_storeu_si128((__m128i*)sum,vsum);
+      red.sum += (unsigned long long)sum[0] + sum[1] + sum[2] + sum[3];
+    }
+  int16_t mins[8],maxs[8];
+  uint64_t sum2[2];
+  _mm_storeu_si128((__m128i*)mins,vmin);
+  _mm_storeu_si128((__m128i*)maxs,vmax);
+  _mm_storeu_si128((__m128i*)sum2,vsum2);
+  if(i)
+    {
+      red.min = std::min<unsigned int>(red.min,uint16_t(*std::min_element(mins,mins + 8) ^ 0x8000));
+      red.max = std::max<unsigned int>(red.max,uint16_t(*std::max_element(maxs,maxs + 8) ^ 0x8000));
+      red.sum2 += sum2[0] + sum2[1];
+    }
+  _reduce_scalar(p + i,n - i,red);
+}
+#endif
+
+//---------------------------
+// histogram and saturated pixels, one partial histogram
+// per pixel of 4 so repeated values don't wait for each other
+//---------------------------
+template<class T>
+static void _histogram_row(const T* p,int n,int shift,unsigned int last_bin,
+			   unsigned int level,unsigned int* work,int nb_bins,
+			   long long& nb_saturated)
+{
+  unsigned int* h0 = work;
+  unsigned int* h1 = h0 + nb_bins;
+  unsigned int* h2 = h1 + nb_bins;
+  unsigned int* h3 = h2 + nb_bins;
+  long long saturated = 0;
+  int i = 0;
+  for(;i + 4 <= n;i += 4)
+    {
+      unsigned int v0 = p[i],v1 = p[i + 1],v2 = p[i + 2],v3 = p[i + 3];
+      ++h0[std::min(v0 >> shift,last_bin)];
+      ++h1[std::min(v1 >> shift,last_bin)];
+      ++h2[std::min(v2 >> shift,last_bin)];
+      ++h3[std::min(v3 >> shift,last_bin)];
+      saturated += (v0 >= level) + (v1 >= level) + (v2 >= level) + (v3 >= level);
+    }
+  for(;i < n;++i)
+    {
+      unsigned int v = p[i];
+      ++h0[std::min(v >> shift,last_bin)];
+      saturated += v >= level;
+    }
+  nb_saturated += saturated;
+}
+
+template<class T>
+static void _compute_frame(const T* data,int width,int x0,int y0,int w,int h,
+			   int shift,unsigned int level,unsigned int* work,
+			   int nb_bins,_Reduction& red,long long& nb_saturated)
+{
+  for(int y = y0;y < y0 + h;++y)
+    {
+      const T* row = data + size_t(y) * width + x0;
+      _reduce_row(row,w,red);
+      _histogram_row(row,w,shift,unsigned(nb_bins - 1),level,work,nb_bins,
+		     nb_saturated);
+    }
+}
+
+static int _image_type_bits(ImageType type)
+{
+  switch(type)
+    {
+    case Bpp8:	return 8;
+    case Bpp10:	return 10;
+    case Bpp12:	return 12;
+    case Bpp16:	return 16;
+    default:	return 0;
+    }
+}
+
+//---------------------------
+//- FrameStats::Result
+//---------------------------
+FrameStats::Result::Result() :
+  index(-1),
+  frame_nb(-1),
+  timestamp(0.),
+  nb_pixels(0),
+  min(0.),
+  max(0.),
+  sum(0.),
+  mean(0.),
+  std(0.),
+  nb_saturated(0)
+{
+}
+
+//---------------------------
+//- FrameStats::FrameStats()
+//---------------------------
+FrameStats::FrameStats() :
+  m_nb_bins(NB_BINS_DEFAULT),
+  m_saturation_level(0),
+  m_ring_size(RING_SIZE_DEFAULT),
+  m_active(false),
+  m_type(Bpp8),
+  m_active_saturation_level(0)
+{
+  DEB_CONSTRUCTOR();
+}
+
+//---------------------------
+//- FrameStats::setNbBins()
+//---------------------------
+void FrameStats::setNbBins(int nb_bins)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nb_bins);
+  if(nb_bins < 1 || nb_bins > 65536 || (nb_bins & (nb_bins - 1)))
+    THROW_HW_ERROR(InvalidValue) << "Frame stats bins must be a power of 2 in range [1,65536]";
+  AutoMutex aLock(m_lock);
+  m_nb_bins = nb_bins;
+}
+
+//---------------------------
+//- FrameStats::setSaturationLevel()
+//---------------------------
+void FrameStats::setSaturationLevel(int level)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(level);
+  AutoMutex aLock(m_lock);
+  m_saturation_level = level;
+}
+
+//---------------------------
+//- FrameStats::setRoi()
+//---------------------------
+void FrameStats::setRoi(const Roi& roi)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(roi);
+  AutoMutex aLock(m_lock);
+  m_roi = roi;
+}
+
+//---------------------------
+//- FrameStats::getRoi()
+//---------------------------
+void FrameStats::getRoi(Roi& roi) const
+{
+  AutoMutex aLock(m_lock);
+  roi = m_roi;
+}
+
+//---------------------------
+//- FrameStats::setRingSize()
+//---------------------------
+void FrameStats::setRingSize(int nb_results)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nb_results);
+  if(nb_results < 1)
+    THROW_HW_ERROR(InvalidValue) << "Frame stats ring size must be >= 1";
+  AutoMutex aLock(m_lock);
+  m_ring_size = nb_results;
+}
+
+//---------------------------
+//- FrameStats::isImageTypeSupported()
+//---------------------------
+bool FrameStats::isImageTypeSupported(ImageType type)
+{
+  return _image_type_bits(type) != 0;
+}
+
+//---------------------------
+//- FrameStats::prepare()
+//---------------------------
+void FrameStats::prepare(ImageType type)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(type);
+  AutoMutex aLock(m_lock);
+  m_active = isImageTypeSupported(type);
+  if(!m_active)
+    {
+      DEB_WARNING() << "No frame stats for image type " << type;
+      return;
+    }
+  int nb_values = 1 << _image_type_bits(type);
+  int nb_bins = std::min(m_nb_bins,nb_values);
+  m_type = type;
+  m_active_saturation_level = m_saturation_level > 0 ?
+    m_saturation_level : nb_values - 1;
+  m_active_roi = m_roi;
+  m_ring.reset(m_ring_size,[nb_bins](Result& result) {
+      result.histogram.assign(nb_bins,0);
+    });
+  m_work.assign(size_t(nb_bins) * NB_PARTIAL_HISTOGRAMS,0);
+}
+
+//---------------------------
+//- FrameStats::process()
+//---------------------------
+void FrameStats::process(const void* data,int width,int height,size_t image_size,
+			 int frame_nb,double timestamp)
+{
+  DEB_MEMBER_FUNCT();
+  if(!m_active)
+    return;
+  if(size_t(width) * height * FrameDim::getImageTypeDepth(m_type) > image_size)
+    {
+      DEB_TRACE() << "Frame " << frame_nb << " too small for stats";
+      return;
+    }
+
+  Result& result = m_ring.beginWrite();
+  result.index = m_ring.getNbResults();
+  result.frame_nb = frame_nb;
+  result.timestamp = timestamp;
+  _compute(data,width,height,result);
+  m_ring.endWrite();
+}
+
+//---------------------------
+//- FrameStats::_compute()
+//---------------------------
+void FrameStats::_compute(const void* data,int width,int height,Result& result)
+{
+  int x0 = 0,y0 = 0,w = width,h = height;
+  if(m_active_roi.isActive() && !m_active_roi.isEmpty())
+    {
+      Point top_left = m_active_roi.getTopLeft();
+      Size size = m_active_roi.getSize();
+      x0 = std::min(std::max(top_left.x,0),width);
+      y0 = std::min(std::max(top_left.y,0),height);
+      w = std::min(top_left.x + size.getWidth(),width) - x0;
+      h = std::min(top_left.y + size.getHeight(),height) - y0;
+      w = std::max(w,0);
+      h = std::max(h,0);
+    }
+
+  int nb_bins = int(result.histogram.size());
+  int nb_bits = _image_type_bits(m_type);
+  int shift = 0;
+  while((nb_bins << shift) < (1 << nb_bits))
+    ++shift;
+  std::fill(m_work.begin(),m_work.end(),0);
+
+  _Reduction red;
+  long long nb_saturated = 0;
+  unsigned int level = unsigned(m_active_saturation_level);
+  if(w && h)
+    {
+      if(nb_bits == 8)
+	_compute_frame((const uint8_t*)data,width,x0,y0,w,h,shift,level,
+		       m_work.data(),nb_bins,red,nb_saturated);
+      else
+	_compute_frame((const uint16_t*)data,width,x0,y0,w,h,shift,level,
+		       m_work.data(),nb_bins,red,nb_saturated);
+    }
+
+  for(int bin = 0;bin < nb_bins;++bin)
+    {
+      unsigned int count = 0;
+      for(int k = 0;k < NB_PARTIAL_HISTOGRAMS;++k)
+	count += m_work[size_t(k) * nb_bins + bin];
+      result.histogram[bin] = count;
+    }
+
+  long long nb_pixels = (long long)w * h;
+  result.nb_pixels = int(nb_pixels);
+  result.nb_saturated = nb_saturated;
+  result.sum = double(red.sum);
+  if(nb_pixels)
+    {
+      result.min = red.min;
+      result.max = red.max;
+      result.mean = result.sum / nb_pixels;
+      double variance = double(red.sum2) / nb_pixels - result.mean * result.mean;
+      result.std = variance > 0. ? sqrt(variance) : 0.;
+    }
+  else
+    result.min = result.max = result.mean = result.std = 0.;
+}
+
+//---------------------------
+//- FrameStats::getResults()
+//---------------------------
+void FrameStats::getResults(long long since,std::vector<Result>& results,
+			    long long& next) const
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(since);
+  AutoMutex aLock(m_lock);
+  m_ring.read(since,results,next);
+  DEB_RETURN() << DEB_VAR2(results.size(),next);
+}
+
+//---------------------------
+//- FrameStats::getLastResult()
+//---------------------------
+bool FrameStats::getLastResult(Result& result) const
+{
+  AutoMutex aLock(m_lock);
+  return m_ring.readLast(result);
+}
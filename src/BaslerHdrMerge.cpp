@@ -0,0 +1,163 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+#include "lima/Exceptions.h"
+#include "BaslerHdrMerge.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+//---------------------------
+//- HdrMerge::HdrMerge()
+//---------------------------
+HdrMerge::HdrMerge() :
+  m_src_type(Bpp8),
+  m_dst_type(Bpp32F),
+  m_nb_pixels(0),
+  m_saturation_level(0.),
+  m_ref_exp_time(1.),
+  m_saturated_value(0.)
+{
+  DEB_CONSTRUCTOR();
+}
+
+//---------------------------
+//- HdrMerge::prepare()
+//---------------------------
+void HdrMerge::prepare(ImageType src_type,ImageType dst_type,int nb_pixels,
+		       const std::vector<double>& exp_times,
+		       double saturation_level)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR4(src_type,dst_type,nb_pixels,saturation_level);
+
+  int bits;
+  switch(src_type)
+    {
+    case Bpp8:	bits = 8;	break;
+    case Bpp10:	bits = 10;	break;
+    case Bpp12:	bits = 12;	break;
+    case Bpp16:	bits = 16;	break;
+    default:
+      THROW_HW_ERROR(NotSupported) << "HDR merge: unsupported camera image type " << src_type;
+    }
+  if(!isOutputType(dst_type))
+    THROW_HW_ERROR(NotSupported) << "HDR merge: output image type must be Bpp32 or Bpp32F";
+  if(exp_times.size() < 2)
+    THROW_HW_ERROR(InvalidValue) << "HDR merge: needs at least 2 exposures";
+
+  m_exp_times.clear();
+  for(std::vector<double>::const_iterator i = exp_times.begin();
+      i != exp_times.end();++i)
+    {
+      if(*i <= 0.)
+	THROW_HW_ERROR(InvalidValue) << "HDR merge: exposure times must be > 0";
+      m_exp_times.push_back(float(*i));
+    }
+
+  m_src_type = src_type;
+  m_dst_type = dst_type;
+  m_nb_pixels = nb_pixels;
+  m_saturation_level = saturation_level > 0. ?
+    float(saturation_level) : float((1 << bits) - 1);
+  m_ref_exp_time = *std::max_element(m_exp_times.begin(),m_exp_times.end());
+  float min_exp_time = *std::min_element(m_exp_times.begin(),m_exp_times.end());
+  m_saturated_value = m_saturation_level * m_ref_exp_time / min_exp_time;
+
+  m_sum_values.resize(nb_pixels);
+  m_sum_exp_times.resize(nb_pixels);
+  reset();
+}
+
+//---------------------------
+//- HdrMerge::reset()
+//---------------------------
+void HdrMerge::reset()
+{
+  std::fill(m_sum_values.begin(),m_sum_values.end(),0.f);
+  std::fill(m_sum_exp_times.begin(),m_sum_exp_times.end(),0.f);
+}
+
+//---------------------------
+//- HdrMerge::accumulate()
+//---------------------------
+void HdrMerge::accumulate(int exposure_index,const void* src)
+{
+  DEB_MEMBER_FUNCT();
+  if(exposure_index < 0 || exposure_index >= getNbExposures())
+    THROW_HW_ERROR(InvalidValue) << "HDR merge: invalid exposure index " << exposure_index;
+
+  float exp_time = m_exp_times[exposure_index];
+  if(m_src_type == Bpp8)
+    _accumulate((const uint8_t*)src,exp_time);
+  else
+    _accumulate((const uint16_t*)src,exp_time);
+}
+
+//---------------------------
+//- HdrMerge::merge()
+//---------------------------
+void HdrMerge::merge(void* dst) const
+{
+  if(m_dst_type == Bpp32F)
+    _merge((float*)dst,std::numeric_limits<float>::max(),0.f);
+  else
+    _merge((uint32_t*)dst,4294967040.f,.5f); // biggest float below 2^32
+}
+
+// The loops below have no branch and no aliasing between the
+// buffers so the compiler vectorizes them (-O2 -ftree-vectorize / -O3)
+template<class T>
+void HdrMerge::_accumulate(const T* __restrict src,float exp_time)
+{
+  float* __restrict sum_values = m_sum_values.data();
+  float* __restrict sum_exp_times = m_sum_exp_times.data();
+  const float saturation_level = m_saturation_level;
+  for(int i = 0;i < m_nb_pixels;++i)
+    {
+      float value = float(src[i]);
+      bool valid = value < saturation_level;
+      sum_values[i] += valid ? value : 0.f;
+      sum_exp_times[i] += valid ? exp_time : 0.f;
+    }
+}
+
+template<class T>
+void HdrMerge::_merge(T* __restrict dst,float max_value,float round_offset) const
+{
+  const float* __restrict sum_values = m_sum_values.data();
+  const float* __restrict sum_exp_times = m_sum_exp_times.data();
+  const float ref_exp_time = m_ref_exp_time;
+  const float saturated_value = m_saturated_value;
+  for(int i = 0;i < m_nb_pixels;++i)
+    {
+      float exp_time = sum_exp_times[i];
+      float value = exp_time > 0.f ?
+	sum_values[i] * ref_exp_time / std::max(exp_time,1e-30f) : saturated_value;
+      dst[i] = T(std::min(value,max_value) + round_offset);
+    }
+}
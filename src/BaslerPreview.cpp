@@ -0,0 +1,295 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <stdint.h>
+#include "lima/Exceptions.h"
+#include "BaslerPreview.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+//---------------------------
+//- PreviewTap::_Thread
+//---------------------------
+class PreviewTap::_Thread : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera,"PreviewTap","_Thread");
+public:
+  _Thread(PreviewTap& aTap) : m_tap(aTap) {}
+  virtual ~_Thread()
+  {
+    {
+      AutoMutex aLock(m_tap.m_cond.mutex());
+      m_tap.m_quit = true;
+      m_tap.m_cond.broadcast();
+    }
+    join();
+  }
+protected:
+  virtual void threadFunction() {m_tap._process();}
+private:
+  PreviewTap&	m_tap;
+};
+
+//---------------------------
+//- PreviewTap::PreviewTap()
+//---------------------------
+PreviewTap::PreviewTap() :
+  m_decimation(1),
+  m_max_rate(10.),
+  m_binning(1),
+  m_result_frame_nb(-1),
+  m_result_type(Bpp8),
+  m_busy(false),
+  m_quit(false),
+  m_frame_nb(-1),
+  m_width(0),
+  m_height(0),
+  m_type(Bpp8),
+  m_nb_frames(0),
+  m_thread(NULL)
+{
+  DEB_CONSTRUCTOR();
+}
+
+//---------------------------
+//- PreviewTap::~PreviewTap()
+//---------------------------
+PreviewTap::~PreviewTap()
+{
+  DEB_DESTRUCTOR();
+  delete m_thread;
+}
+
+//---------------------------
+//- PreviewTap::setDecimation()
+//---------------------------
+void PreviewTap::setDecimation(int nth)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nth);
+  if(nth < 1)
+    THROW_HW_ERROR(InvalidValue) << "Preview decimation must be >= 1";
+  AutoMutex aLock(m_cond.mutex());
+  m_decimation = nth;
+}
+
+//---------------------------
+//- PreviewTap::setMaxRate()
+//---------------------------
+void PreviewTap::setMaxRate(double max_rate)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(max_rate);
+  if(max_rate < 0.)
+    THROW_HW_ERROR(InvalidValue) << "Preview max rate must be >= 0";
+  AutoMutex aLock(m_cond.mutex());
+  m_max_rate = max_rate;
+}
+
+//---------------------------
+//- PreviewTap::setBinning()
+//---------------------------
+void PreviewTap::setBinning(int factor)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(factor);
+  if(factor < 1 || factor > 16)
+    THROW_HW_ERROR(InvalidValue) << "Preview binning must be in range [1,16]";
+  AutoMutex aLock(m_cond.mutex());
+  m_binning = factor;
+}
+
+//---------------------------
+//- PreviewTap::reset()
+//- the thread is started by the first acquisition using the preview
+//---------------------------
+void PreviewTap::reset()
+{
+  DEB_MEMBER_FUNCT();
+  if(!m_thread)
+    {
+      m_thread = new _Thread(*this);
+      m_thread->start();
+    }
+  AutoMutex aLock(m_cond.mutex());
+  m_last_tap = Timestamp();
+  m_nb_frames = 0;
+  m_frame_nb = -1;
+}
+
+//---------------------------
+//- PreviewTap::tap()
+//---------------------------
+void PreviewTap::tap(const Pylon::CBaslerUniversalGrabResultPtr& result,
+		     int frame_nb,ImageType type)
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  if(m_busy || frame_nb % m_decimation)
+    return;
+  Timestamp now = Timestamp::now();
+  if(m_max_rate > 0. && m_last_tap.isSet() && now - m_last_tap < 1. / m_max_rate)
+    return;
+
+  m_last_tap = now;
+  m_result = result;		// the grab buffer is held until binned
+  m_result_frame_nb = frame_nb;
+  m_result_type = type;
+  m_busy = true;
+  m_cond.broadcast();
+}
+
+//---------------------------
+//- PreviewTap::getImage()
+//---------------------------
+void PreviewTap::getImage(std::vector<char>& data,int& frame_nb,
+			  int& width,int& height,ImageType& type) const
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  data = m_image;
+  frame_nb = m_frame_nb;
+  width = m_width;
+  height = m_height;
+  type = m_type;
+  DEB_RETURN() << DEB_VAR4(frame_nb,width,height,type);
+}
+
+//---------------------------
+//- PreviewTap::getNbPreviewFrames()
+//---------------------------
+void PreviewTap::getNbPreviewFrames(int& nb_frames) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  nb_frames = m_nb_frames;
+}
+
+//---------------------------
+//- PreviewTap::_process()
+//---------------------------
+void PreviewTap::_process()
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  while(!m_quit)
+    {
+      if(!m_busy)
+	{
+	  m_cond.wait();
+	  continue;
+	}
+
+      Pylon::CBaslerUniversalGrabResultPtr result = m_result;
+      m_result.Release();
+      int frame_nb = m_result_frame_nb;
+      ImageType type = m_result_type;
+      int factor = m_binning;
+      int width = int(result->GetWidth()) / factor;
+      int height = int(result->GetHeight()) / factor;
+      int depth = FrameDim::getImageTypeDepth(type);
+      m_work.resize(size_t(width) * height * depth);
+      {
+	AutoMutexUnlock aUnlock(aLock);
+	try
+	  {
+	    binImage(result->GetBuffer(),m_work.data(),
+		     int(result->GetWidth()),int(result->GetHeight()),type,factor);
+	  }
+	catch(Exception& e)
+	  {
+	    DEB_WARNING() << e.getErrMsg();
+	    width = height = 0;
+	  }
+	result.Release();
+      }
+      if(width && height)
+	{
+	  m_image.swap(m_work);
+	  m_frame_nb = frame_nb;
+	  m_width = width;
+	  m_height = height;
+	  m_type = type;
+	  ++m_nb_frames;
+	}
+      m_busy = false;
+    }
+}
+
+// Separable box filter: the rows of a block are summed into a line
+// accumulator, then the columns. The loops have no branch and no
+// aliasing so the compiler vectorizes them (-O2 -ftree-vectorize / -O3)
+template<class T>
+static void _bin_image(const T* __restrict src,T* __restrict dst,
+		       int width,int height,int factor)
+{
+  int out_width = width / factor;
+  int out_height = height / factor;
+  int used_width = out_width * factor;
+  std::vector<uint32_t> line(used_width);
+  uint32_t* __restrict acc = line.data();
+  const float norm = 1.f / (factor * factor);
+  for(int oy = 0;oy < out_height;++oy)
+    {
+      const T* __restrict row = src + size_t(oy) * factor * width;
+      for(int x = 0;x < used_width;++x)
+	acc[x] = row[x];
+      for(int dy = 1;dy < factor;++dy)
+	{
+	  row += width;
+	  for(int x = 0;x < used_width;++x)
+	    acc[x] += row[x];
+	}
+      T* __restrict out = dst + size_t(oy) * out_width;
+      for(int ox = 0;ox < out_width;++ox)
+	{
+	  uint32_t sum = 0;
+	  for(int dx = 0;dx < factor;++dx)
+	    sum += acc[ox * factor + dx];
+	  out[ox] = T(sum * norm + .5f);
+	}
+    }
+}
+
+//---------------------------
+//- PreviewTap::binImage()
+//---------------------------
+void PreviewTap::binImage(const void* src,void* dst,int width,int height,
+			  ImageType type,int factor)
+{
+  DEB_STATIC_FUNCT();
+  switch(type)
+    {
+    case Bpp8:
+      _bin_image((const uint8_t*)src,(uint8_t*)dst,width,height,factor);
+      break;
+    case Bpp10:
+    case Bpp12:
+    case Bpp16:
+      _bin_image((const uint16_t*)src,(uint16_t*)dst,width,height,factor);
+      break;
+    default:
+      THROW_HW_ERROR(NotSupported) << "Preview: unsupported image type " << type;
+    }
+}
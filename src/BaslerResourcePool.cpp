@@ -0,0 +1,362 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+#include <algorithm>
+#if !defined(WIN32)
+#include <unistd.h>
+#endif
+#include "BaslerResourcePool.h"
+#include "BaslerCamera.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+//---------------------------
+//- ResourcePool::_GrabWorker
+//- waits on the grab result of its cameras and
+//- retrieves them, image event handlers run here
+//---------------------------
+class ResourcePool::_GrabWorker : public Thread
+{
+  DEB_CLASS_NAMESPC(DebModCamera, "ResourcePool", "_GrabWorker");
+public:
+  _GrabWorker(ResourcePool& aPool) :
+    m_wakeup(WaitObjectEx::Create()),
+    m_current(NULL),
+    m_quit(false),
+    m_pool(aPool)
+  {}
+  virtual ~_GrabWorker()
+  {
+    {
+      AutoMutex aLock(m_pool.m_cond.mutex());
+      m_quit = true;
+      m_wakeup.Signal();
+    }
+    join();
+  }
+
+  std::vector<Camera*>	m_cameras;
+  WaitObjectEx		m_wakeup;
+  Camera*		m_current;
+  bool			m_quit;
+protected:
+  virtual void threadFunction();
+private:
+  ResourcePool&		m_pool;
+};
+
+void ResourcePool::_GrabWorker::threadFunction()
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_pool.m_cond.mutex());
+  while(!m_quit)
+    {
+      WaitObjects waitObjects;
+      waitObjects.Add(m_wakeup);
+      for(std::vector<Camera*>::iterator i = m_cameras.begin();i != m_cameras.end();++i)
+	waitObjects.Add((*i)->Camera_->GetGrabResultWaitObject());
+      std::vector<Camera*> cameras = m_cameras;
+      m_wakeup.Reset();
+
+      unsigned int index;
+      bool ready;
+      {
+	AutoMutexUnlock aUnlock(aLock);
+	ready = waitObjects.WaitForAny(1000,&index);
+      }
+      // index 0 is the wake up on cameras list change
+      if(!ready || !index || m_quit)
+	continue;
+
+      // one result of the camera woken up, then of the others ready
+      // meanwhile in turn from it: the first cameras can't starve the next
+      size_t nb_cameras = cameras.size();
+      for(size_t n = 0;n < nb_cameras && !m_quit;++n)
+	{
+	  Camera* aCam = cameras[(index - 1 + n) % nb_cameras];
+	  if(std::find(m_cameras.begin(),m_cameras.end(),aCam) == m_cameras.end())
+	    continue;
+	  if(n && !aCam->Camera_->GetGrabResultWaitObject().Wait(0))
+	    continue;
+	  m_current = aCam;
+	  bool grabbing;
+	  {
+	    AutoMutexUnlock aUnlock(aLock);
+	    grabbing = aCam->_retrieveResult();
+	  }
+	  m_current = NULL;
+	  std::vector<Camera*>::iterator c = std::find(m_cameras.begin(),m_cameras.end(),aCam);
+	  if(!grabbing && c != m_cameras.end())
+	    m_cameras.erase(c);
+	  m_pool.m_cond.broadcast();
+	}
+    }
+}
+
+//---------------------------
+//- ResourcePool::getInstance()
+//---------------------------
+ResourcePool& ResourcePool::getInstance()
+{
+  static ResourcePool instance;
+  return instance;
+}
+
+//---------------------------
+//- Ctor
+//---------------------------
+ResourcePool::ResourcePool() :
+  m_nb_grab_threads(1),
+  m_buffer_memory_limit(0),
+  m_buffer_memory_peak(0)
+{
+  DEB_CONSTRUCTOR();
+#if !defined(WIN32)
+  long nb_cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if(nb_cores > 0)
+    m_nb_grab_threads = int(nb_cores);
+#endif
+  DEB_TRACE() << DEB_VAR1(m_nb_grab_threads);
+}
+
+//---------------------------
+//- Dtor
+//---------------------------
+ResourcePool::~ResourcePool()
+{
+  DEB_DESTRUCTOR();
+  for(std::vector<_GrabWorker*>::iterator i = m_workers.begin();i != m_workers.end();++i)
+    delete *i;
+}
+
+//-----------------------------------------------------
+// new size is used by the next started cameras
+//-----------------------------------------------------
+void ResourcePool::setNbGrabThreads(int nb_threads)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nb_threads);
+  if(nb_threads < 1)
+    THROW_HW_ERROR(InvalidValue) << "Number of grab threads must be >= 1";
+  AutoMutex aLock(m_cond.mutex());
+  m_nb_grab_threads = nb_threads;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::getNbGrabThreads(int& nb_threads) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  nb_threads = m_nb_grab_threads;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::getNbGrabCameras(int& nb_cameras) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  nb_cameras = 0;
+  for(std::vector<_GrabWorker*>::const_iterator i = m_workers.begin();i != m_workers.end();++i)
+    nb_cameras += int((*i)->m_cameras.size());
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::setBufferMemoryLimit(long long nb_bytes)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR1(nb_bytes);
+  if(nb_bytes < 0)
+    THROW_HW_ERROR(InvalidValue) << "Buffer memory limit must be >= 0";
+  AutoMutex aLock(m_cond.mutex());
+  m_buffer_memory_limit = nb_bytes;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::getBufferMemoryLimit(long long& nb_bytes) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  nb_bytes = m_buffer_memory_limit;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::getBufferMemoryUsed(long long& nb_bytes) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  nb_bytes = _getUsed();
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::getBufferMemoryPeak(long long& nb_bytes) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  nb_bytes = m_buffer_memory_peak;
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::resetBufferMemoryPeak()
+{
+  AutoMutex aLock(m_cond.mutex());
+  m_buffer_memory_peak = _getUsed();
+  for(std::map<Camera*,_MemoryUsage>::iterator i = m_buffer_memory.begin();
+      i != m_buffer_memory.end();++i)
+    i->second.peak = i->second.used();
+}
+
+//-----------------------------------------------------
+// camera goes to the worker with the fewest cameras,
+// a new worker is started if the pool is not full
+//-----------------------------------------------------
+void ResourcePool::_addGrabCamera(Camera* cam)
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+
+  _GrabWorker* aWorker = NULL;
+  for(std::vector<_GrabWorker*>::iterator i = m_workers.begin();i != m_workers.end();++i)
+    {
+      std::vector<Camera*>& cameras = (*i)->m_cameras;
+      if(std::find(cameras.begin(),cameras.end(),cam) != cameras.end())
+	return;
+      if(!aWorker || cameras.size() < aWorker->m_cameras.size())
+	aWorker = *i;
+    }
+  if(!aWorker || (!aWorker->m_cameras.empty() && int(m_workers.size()) < m_nb_grab_threads))
+    {
+      aWorker = new _GrabWorker(*this);
+      m_workers.push_back(aWorker);
+      aWorker->start();
+      DEB_TRACE() << "New grab worker: " << DEB_VAR1(m_workers.size());
+    }
+  aWorker->m_cameras.push_back(cam);
+  aWorker->m_wakeup.Signal();
+}
+
+//-----------------------------------------------------
+// returns when no worker uses the camera anymore
+//-----------------------------------------------------
+void ResourcePool::_removeGrabCamera(Camera* cam)
+{
+  DEB_MEMBER_FUNCT();
+  AutoMutex aLock(m_cond.mutex());
+  for(std::vector<_GrabWorker*>::iterator i = m_workers.begin();i != m_workers.end();++i)
+    {
+      std::vector<Camera*>& cameras = (*i)->m_cameras;
+      std::vector<Camera*>::iterator c = std::find(cameras.begin(),cameras.end(),cam);
+      if(c != cameras.end())
+	{
+	  cameras.erase(c);
+	  (*i)->m_wakeup.Signal();
+	}
+      while((*i)->m_current == cam)
+	m_cond.wait();
+    }
+}
+
+//-----------------------------------------------------
+// called with the lock
+//-----------------------------------------------------
+long long ResourcePool::_getUsed() const
+{
+  long long used = 0;
+  for(std::map<Camera*,_MemoryUsage>::const_iterator i = m_buffer_memory.begin();
+      i != m_buffer_memory.end();++i)
+    used += i->second.used();
+  return used;
+}
+
+//-----------------------------------------------------
+// memory left for the frame or stream buffers of a
+// camera, the ones it already has included, -1: no limit
+//-----------------------------------------------------
+long long ResourcePool::_getBufferMemoryAvailable(Camera* cam,bool stream_buffers) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  if(!m_buffer_memory_limit)
+    return -1;
+  long long used = _getUsed();
+  std::map<Camera*,_MemoryUsage>::const_iterator i = m_buffer_memory.find(cam);
+  if(i != m_buffer_memory.end())
+    used -= stream_buffers ? i->second.stream_buffers : i->second.frame_buffers;
+  return std::max(m_buffer_memory_limit - used,0LL);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::_setBufferMemory(Camera* cam,long long nb_bytes,bool stream_buffers)
+{
+  DEB_MEMBER_FUNCT();
+  DEB_PARAM() << DEB_VAR2(nb_bytes,stream_buffers);
+
+  AutoMutex aLock(m_cond.mutex());
+  _MemoryUsage& usage = m_buffer_memory[cam];
+  if(stream_buffers)
+    usage.stream_buffers = nb_bytes;
+  else
+    usage.frame_buffers = nb_bytes;
+  usage.peak = std::max(usage.peak,usage.used());
+
+  long long used = _getUsed();
+  m_buffer_memory_peak = std::max(m_buffer_memory_peak,used);
+  if(m_buffer_memory_limit && used > m_buffer_memory_limit)
+    DEB_WARNING() << "Buffer memory budget exceeded: " << DEB_VAR2(used,m_buffer_memory_limit);
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::_getCameraMemory(Camera* cam,long long& used,long long& peak) const
+{
+  AutoMutex aLock(m_cond.mutex());
+  std::map<Camera*,_MemoryUsage>::const_iterator i = m_buffer_memory.find(cam);
+  used = peak = 0;
+  if(i != m_buffer_memory.end())
+    {
+      used = i->second.used();
+      peak = i->second.peak;
+    }
+}
+
+//-----------------------------------------------------
+//
+//-----------------------------------------------------
+void ResourcePool::_releaseCamera(Camera* cam)
+{
+  _removeGrabCamera(cam);
+  AutoMutex aLock(m_cond.mutex());
+  m_buffer_memory.erase(cam);
+}
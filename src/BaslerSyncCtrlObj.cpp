@@ -50,6 +50,10 @@ bool SyncCtrlObj::checkTrigMode(TrigMode trig_mode)
       valid_mode = true;
       break;
 
+    case ExtTrigSingle:
+      valid_mode = m_cam.isExtTrigSingleAvailable();
+      break;
+
     default:
       valid_mode = false;
       break;
@@ -119,8 +123,8 @@ bool SyncCtrlObj::checkAutoExposureMode(HwSyncCtrlObj::AutoExposureMode mode) co
 {
   DEB_MEMBER_FUNCT();
   DEB_PARAM() << DEB_VAR1(mode);
-  bool checkFlag = mode == HwSyncCtrlObj::ON ?
-    GenApi::IsAvailable(m_cam.Camera_->ExposureAuto) : true;
+  // without ExposureAuto the software loop of the camera is used
+  bool checkFlag = true;
   DEB_RETURN() << DEB_VAR1(checkFlag);
   return checkFlag;
 }
@@ -136,6 +140,10 @@ void SyncCtrlObj::setHwAutoExposureMode(AutoExposureMode mode)
             m_cam.Camera_->ExposureAuto.SetValue(mode == HwSyncCtrlObj::ON ?
 					   ExposureAuto_Continuous : ExposureAuto_Off);
        }
+       else
+	 m_cam.setAutoExposureLoopMode(mode == HwSyncCtrlObj::ON ?
+				       Camera::AutoExposureLoopExpTime :
+				       Camera::AutoExposureLoopOff);
     }
   catch(Pylon::GenericException& e)
     {
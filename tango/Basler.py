@@ -41,6 +41,8 @@
 #         (c) - Bliss - ESRF
 #=============================================================================
 #
+import json
+import struct
 import PyTango
 from lima import core
 from lima import basler as BaslerAcq
@@ -76,6 +78,35 @@ class Basler(PyTango.LatestDeviceImpl):
             'LINESOURCE_USER_OUTPUT': BaslerAcq.Camera.LineSource.UserOutput,
             'LINESOURCE_ACQUISITION_TRIGGER_WAIT': BaslerAcq.Camera.LineSource.AcquisitionTriggerWait,
         }
+        self.__SequencerAdvance = {
+            'FRAME_COUNT': BaslerAcq.Camera.SequencerAdvance.AdvanceByFrameCount,
+            'LINE1': BaslerAcq.Camera.SequencerAdvance.AdvanceByLine1,
+        }
+        self.__VideoLiveStrategy = {
+            'ONE_BY_ONE': BaslerAcq.Camera.VideoGrabStrategy.VideoOneByOne,
+            'LATEST_IMAGE_ONLY': BaslerAcq.Camera.VideoGrabStrategy.VideoLatestImageOnly,
+            'LATEST_IMAGES': BaslerAcq.Camera.VideoGrabStrategy.VideoLatestImages,
+        }
+        self.__VideoSnapshotStrategy = {
+            'ONE_BY_ONE': BaslerAcq.Camera.VideoGrabStrategy.VideoOneByOne,
+            'UPCOMING_IMAGE': BaslerAcq.Camera.VideoGrabStrategy.VideoUpcomingImage,
+        }
+        self.__MissedFrameMode = {
+            'IGNORE': BaslerAcq.Camera.MissedFrameMode.MissedIgnore,
+            'BLANK': BaslerAcq.Camera.MissedFrameMode.MissedBlank,
+            'MARK': BaslerAcq.Camera.MissedFrameMode.MissedMark,
+        }
+        self.__OverrunPolicy = {
+            'STOP': BaslerAcq.Camera.OverrunPolicy.OverrunStop,
+            'DROP_NEWEST': BaslerAcq.Camera.OverrunPolicy.OverrunDropNewest,
+            'DECIMATE': BaslerAcq.Camera.OverrunPolicy.OverrunDecimate,
+            'THROTTLE': BaslerAcq.Camera.OverrunPolicy.OverrunThrottle,
+        }
+        self.__AutoExposureLoopMode = {
+            'OFF': BaslerAcq.Camera.AutoExposureLoopMode.AutoExposureLoopOff,
+            'EXP_TIME': BaslerAcq.Camera.AutoExposureLoopMode.AutoExposureLoopExpTime,
+            'EXP_TIME_GAIN': BaslerAcq.Camera.AutoExposureLoopMode.AutoExposureLoopExpTimeGain,
+        }
         self.__Attribute2FunctionBase = {
         }
         
@@ -114,6 +145,232 @@ class Basler(PyTango.LatestDeviceImpl):
         #use AttrHelper
         return AttrHelper.get_attr_4u(self,name,_BaslerCam)
 
+    def read_grab_frame_rate(self, attr):
+        frame_rate, data_rate = _BaslerCam.getThroughput()
+        attr.set_value(frame_rate)
+
+    def read_grab_data_rate(self, attr):
+        frame_rate, data_rate = _BaslerCam.getThroughput()
+        attr.set_value(data_rate)
+
+    def read_grab_cpu_load(self, attr):
+        cpu_time, cpu_load = _BaslerCam.getGrabCpuUsage()
+        attr.set_value(cpu_load)
+
+    def read_memory_used(self, attr):
+        used, peak = _BaslerCam.getMemoryUsage()
+        attr.set_value(used)
+
+    def read_memory_peak(self, attr):
+        used, peak = _BaslerCam.getMemoryUsage()
+        attr.set_value(peak)
+
+    def read_grab_loop_wakeups_per_frame(self, attr):
+        wakeups_per_frame, mean_latency, max_latency = _BaslerCam.getGrabLoopStatistics()
+        attr.set_value(wakeups_per_frame)
+
+    def read_grab_loop_latency(self, attr):
+        wakeups_per_frame, mean_latency, max_latency = _BaslerCam.getGrabLoopStatistics()
+        attr.set_value(mean_latency)
+
+    def read_grab_loop_max_latency(self, attr):
+        wakeups_per_frame, mean_latency, max_latency = _BaslerCam.getGrabLoopStatistics()
+        attr.set_value(max_latency)
+
+    def read_preview_image(self, attr):
+        frame_nb, width, height, image_type, data = _BaslerCam.getPreviewImage()
+        depth = {core.Bpp8: 'GRAY8'}.get(image_type, 'GRAY16')
+        attr.set_value(depth, struct.pack('<iii', frame_nb, width, height) + data)
+
+    def read_stream_statistics(self, attr):
+        stats = _BaslerCam.getStreamStatistics()
+        fields = ('total_buffers', 'failed_buffers', 'buffer_underruns',
+                  'total_packets', 'lost_packets', 'resend_requests',
+                  'resent_packets', 'missed_frames', 'usb_resyncs',
+                  'last_failed_buffer_status', 'elapsed', 'buffer_rate',
+                  'failed_buffer_rate', 'lost_packet_rate',
+                  'resend_request_rate', 'resent_packet_rate')
+        attr.set_value(json.dumps(dict((f, getattr(stats, f)) for f in fields)))
+
+    def read_acq_state(self, attr):
+        state = _BaslerCam.getAcqState()
+        fields = ('acq_started', 'image_number', 'nb_frames', 'last_frame_time',
+                  'last_frame_age', 'error_code')
+        values = dict((f, getattr(state, f)) for f in fields)
+        values['status'] = int(state.status)
+        attr.set_value(json.dumps(values))
+
+    def read_last_frame_age(self, attr):
+        attr.set_value(_BaslerCam.getAcqState().last_frame_age)
+
+    def read_control_channel_statistics(self, attr):
+        stats = _BaslerCam.getControlChannelStatistics()
+        fields = ('queue_depth', 'max_queue_depth', 'nb_requests', 'nb_merged',
+                  'mean_wait', 'max_wait', 'critical_max_wait')
+        attr.set_value(json.dumps(dict((f, getattr(stats, f)) for f in fields)))
+
+    def read_frame_stats_roi(self, attr):
+        roi = _BaslerCam.getFrameStatsRoi()
+        top_left, size = roi.getTopLeft(), roi.getSize()
+        attr.set_value([top_left.x, top_left.y, size.getWidth(), size.getHeight()])
+
+    def write_frame_stats_roi(self, attr):
+        x, y, width, height = attr.get_write_value()
+        _BaslerCam.setFrameStatsRoi(core.Roi(x, y, width, height))
+
+    def read_last_frame_histogram(self, attr):
+        attr.set_value(_BaslerCam.getLastFrameStats().getHistogram())
+
+    def read_beam_roi(self, attr):
+        roi = _BaslerCam.getBeamRoi()
+        top_left, size = roi.getTopLeft(), roi.getSize()
+        attr.set_value([top_left.x, top_left.y, size.getWidth(), size.getHeight()])
+
+    def write_beam_roi(self, attr):
+        x, y, width, height = attr.get_write_value()
+        _BaslerCam.setBeamRoi(core.Roi(x, y, width, height))
+
+    def read_beam_centroid_x(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().centroid_x)
+
+    def read_beam_centroid_y(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().centroid_y)
+
+    def read_beam_sigma_x(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().sigma_x)
+
+    def read_beam_sigma_y(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().sigma_y)
+
+    def read_beam_fwhm_x(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().fwhm_x)
+
+    def read_beam_fwhm_y(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().fwhm_y)
+
+    def read_beam_intensity(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().intensity)
+
+    def read_beam_projection_x(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().getProjectionX())
+
+    def read_beam_projection_y(self, attr):
+        attr.set_value(_BaslerCam.getLastBeamResult().getProjectionY())
+
+    def read_auto_exposure_loop_state(self, attr):
+        state = _BaslerCam.getAutoExposureLoopState()
+        fields = ('running', 'converged', 'level', 'exp_time', 'gain',
+                  'frame_index', 'nb_adjustments')
+        attr.set_value(json.dumps(dict((f, getattr(state, f)) for f in fields)))
+
+    # shorter names than the camera settings
+    def read_auto_exposure_loop_max_exp(self, attr):
+        attr.set_value(_BaslerCam.getAutoExposureLoopMaxExpTime())
+
+    def write_auto_exposure_loop_max_exp(self, attr):
+        _BaslerCam.setAutoExposureLoopMaxExpTime(attr.get_write_value())
+
+    def read_auto_exposure_loop_settle(self, attr):
+        attr.set_value(_BaslerCam.getAutoExposureLoopSettleFrames())
+
+    def write_auto_exposure_loop_settle(self, attr):
+        _BaslerCam.setAutoExposureLoopSettleFrames(attr.get_write_value())
+
+    def read_telemetry_age(self, attr):
+        attr.set_value(_BaslerCam.getTelemetry().age)
+
+    def read_thread_affinity(self, attr):
+        attr.set_value(_BaslerCam.getAffinityReport())
+
+    def read_memory_budget(self, attr):
+        attr.set_value(BaslerAcq.ResourcePool.getInstance().getBufferMemoryLimit())
+
+    def write_memory_budget(self, attr):
+        BaslerAcq.ResourcePool.getInstance().setBufferMemoryLimit(attr.get_write_value())
+
+#==================================================================
+#
+#    Basler command methods
+#
+#==================================================================
+#------------------------------------------------------------------
+#    addSequenceSet command:
+#
+#    Description: add a sequencer set with the current image type
+#    argin: DevVarDoubleArray [exp_time, gain, offset_x, offset_y]
+#------------------------------------------------------------------
+    @core.DEB_MEMBER_FUNCT
+    def addSequenceSet(self, argin):
+        if len(argin) != 4:
+            raise ValueError('expected [exp_time, gain, offset_x, offset_y]')
+        exp_time, gain, offset_x, offset_y = argin
+        image_type = _BaslerCam.getImageType()
+        _BaslerCam.addSequenceSet(exp_time, gain, int(offset_x), int(offset_y),
+                                  image_type)
+
+#------------------------------------------------------------------
+#    clearSequenceSets command:
+#
+#    Description: remove all the sequencer sets
+#------------------------------------------------------------------
+    @core.DEB_MEMBER_FUNCT
+    def clearSequenceSets(self):
+        _BaslerCam.clearSequenceSets()
+
+#------------------------------------------------------------------
+#    resetStreamStatistics command:
+#
+#    Description: restart the stream grabber statistics from now
+#------------------------------------------------------------------
+    @core.DEB_MEMBER_FUNCT
+    def resetStreamStatistics(self):
+        _BaslerCam.resetStreamStatistics()
+
+#------------------------------------------------------------------
+#    resetControlChannelStatistics command:
+#
+#    Description: restart the control channel wait statistics from now
+#------------------------------------------------------------------
+    @core.DEB_MEMBER_FUNCT
+    def resetControlChannelStatistics(self):
+        _BaslerCam.resetControlChannelStatistics()
+
+#------------------------------------------------------------------
+#    getFrameStats command:
+#
+#    Description: frame statistics from index since still in the ring
+#    argin: DevLong64 since
+#    argout: DevVarDoubleArray [next, then for each frame index, frame_nb,
+#            timestamp, min, max, sum, mean, std, nb_saturated]
+#------------------------------------------------------------------
+    @core.DEB_MEMBER_FUNCT
+    def getFrameStats(self, argin):
+        results, next = _BaslerCam.getFrameStats(argin)
+        values = [next]
+        for r in results:
+            values += [r.index, r.frame_nb, r.timestamp, r.min, r.max, r.sum,
+                       r.mean, r.std, r.nb_saturated]
+        return values
+
+#------------------------------------------------------------------
+#    getBeamResults command:
+#
+#    Description: beam analysis results from index since still in the ring
+#    argin: DevLong64 since
+#    argout: DevVarDoubleArray [next, then for each frame index, frame_nb,
+#            timestamp, valid, intensity, centroid_x, centroid_y, sigma_x,
+#            sigma_y, sigma_xy, fwhm_x, fwhm_y]
+#------------------------------------------------------------------
+    @core.DEB_MEMBER_FUNCT
+    def getBeamResults(self, argin):
+        results, next = _BaslerCam.getBeamResults(argin)
+        values = [next]
+        for r in results:
+            values += [r.index, r.frame_nb, r.timestamp, r.valid, r.intensity,
+                       r.centroid_x, r.centroid_y, r.sigma_x, r.sigma_y,
+                       r.sigma_xy, r.fwhm_x, r.fwhm_y]
+        return values
+
 
 #==================================================================
 #
@@ -146,19 +403,64 @@ class BaslerClass(PyTango.DeviceClass):
          "Frame Transmission Delay",0],
         'packet_size':
         [PyTango.DevLong,
-         "Network packet size (MTU)",8000],
+         "Network packet size (MTU), -1 to negotiate it, 0 to keep it",8000],
         'force_video_mode':
         [PyTango.DevBoolean,
          "For B/W camera force to color-video mode",False],
         'blank_image_for_missed':
         [PyTango.DevBoolean,
          "blank image when frame missed",False],
+        'shared_grab_loop':
+        [PyTango.DevBoolean,
+         "grab with the process grab thread pool",False],
+        'memory_budget':
+        [PyTango.DevLong64,
+         "buffer memory limit of the process in bytes, 0 for no limit",0],
+        'receive_thread_cpus':
+        [PyTango.DevString,
+         "cpus of the Pylon receive thread (0-3,8 or numa)",""],
+        'grab_thread_cpus':
+        [PyTango.DevString,
+         "cpus of the grab thread (0-3,8 or numa)",""],
+        'processing_thread_cpus':
+        [PyTango.DevString,
+         "cpus of the lima processing threads (0-3,8 or numa)",""],
+        'numa_local_buffers':
+        [PyTango.DevBoolean,
+         "frame and stream buffers on the camera numa node",False],
+        'user_grab_loop':
+        [PyTango.DevBoolean,
+         "grab with a camera thread around RetrieveResult",False],
+        'grab_loop_priority':
+        [PyTango.DevLong,
+         "SCHED_FIFO priority of the user grab loop, 0 for normal scheduling",0],
+        'telemetry_period':
+        [PyTango.DevDouble,
+         "period of the background telemetry sampling in s, 0 for live reads",0.],
         }
 
     cmd_list = {
         'getAttrStringValueList':
         [[PyTango.DevString, "Attribute name"],
          [PyTango.DevVarStringArray, "Authorized String value list"]],
+        'addSequenceSet':
+        [[PyTango.DevVarDoubleArray, "[exp_time, gain, offset_x, offset_y]"],
+         [PyTango.DevVoid, ""]],
+        'clearSequenceSets':
+        [[PyTango.DevVoid, ""],
+         [PyTango.DevVoid, ""]],
+        'resetStreamStatistics':
+        [[PyTango.DevVoid, ""],
+         [PyTango.DevVoid, ""]],
+        'resetControlChannelStatistics':
+        [[PyTango.DevVoid, ""],
+         [PyTango.DevVoid, ""]],
+        'getFrameStats':
+        [[PyTango.DevLong64, "first result index"],
+         [PyTango.DevVarDoubleArray, "[next, index, frame_nb, timestamp, min, max, sum, mean, std, nb_saturated, ...]"]],
+        'getBeamResults':
+        [[PyTango.DevLong64, "first result index"],
+         [PyTango.DevVarDoubleArray, "[next, index, frame_nb, timestamp, valid, intensity, centroid_x, centroid_y, sigma_x, sigma_y, sigma_xy, fwhm_x, fwhm_y, ...]"]],
         }
 
     attr_list = {
@@ -180,100 +482,952 @@ class BaslerClass(PyTango.DeviceClass):
              'format': '',
              'description': 'total number of failed frame',
          }],        
-        'test_image_selector':
+        'telemetry_period':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'period of the background telemetry sampling, 0 for live reads',
+         }],
+        'telemetry_grab_rate_limit':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'Hz',
+             'format': '',
+             'description': 'grab frame rate above which the telemetry sampling slows down, 0 for no limit',
+         }],
+        'telemetry_age':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'age of the telemetry returned by temperature, frame_rate and the throughputs',
+         }],
+        'stream_statistics':
         [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'json snapshot of the stream grabber statistics and rates since the acquisition start or the reset',
+         }],
+        'frame_stats_mode':
+        [[PyTango.DevBoolean,
           PyTango.SCALAR,
           PyTango.READ_WRITE],
          {
              'unit': 'N/A',
              'format': '',
-             'description': 'select a test image image_off/image_1/.../image_7',
+             'description': 'compute the statistics of each frame on the grab thread, from the next acquisition',
          }],
-        'output1_line_source':
-        [[PyTango.DevString,
+        'frame_stats_nb_bins':
+        [[PyTango.DevLong,
           PyTango.SCALAR,
           PyTango.READ_WRITE],
          {
              'unit': 'N/A',
              'format': '',
-             'description': 'select a source for I/O output1 line',
+             'description': 'histogram bins, a power of 2',
          }],
-        'temperature':
-        [[PyTango.DevFloat,
+        'frame_stats_saturation_level':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'pixels at or above the level are saturated, 0 for full scale',
+         }],
+        'frame_stats_roi':
+        [[PyTango.DevLong,
+          PyTango.SPECTRUM,
+          PyTango.READ_WRITE, 4],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'x, y, width, height of the frame statistics roi, empty for the full frame',
+         }],
+        'frame_stats_ring_size':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frame statistics kept for getFrameStats',
+         }],
+        'nb_frame_stats':
+        [[PyTango.DevLong64,
           PyTango.SCALAR,
           PyTango.READ],
          {
-             'unit': 'Celsuis',
+             'unit': 'N/A',
              'format': '',
-             'description': 'camera core temperature',
-         }],        
-        'frame_rate':
+             'description': 'frame statistics computed in the acquisition',
+         }],
+        'last_frame_histogram':
+        [[PyTango.DevULong,
+          PyTango.SPECTRUM,
+          PyTango.READ, 65536],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'histogram of the last frame with statistics',
+         }],
+        'beam_analysis_mode':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'compute the beam centroid, widths and projections of each frame, from the next acquisition',
+         }],
+        'beam_background':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'level subtracted from each pixel',
+         }],
+        'beam_threshold':
         [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'pixels at or below background + threshold are ignored',
+         }],
+        'beam_roi':
+        [[PyTango.DevLong,
+          PyTango.SPECTRUM,
+          PyTango.READ_WRITE, 4],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'x, y, width, height of the beam analysis roi, empty for the full frame',
+         }],
+        'beam_nb_threads':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'threads sharing the analysis of frames of 1M pixels or more',
+         }],
+        'beam_ring_size':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'beam analysis results kept for getBeamResults',
+         }],
+        'nb_beam_results':
+        [[PyTango.DevLong64,
           PyTango.SCALAR,
           PyTango.READ],
          {
-             'unit': 'fps',
+             'unit': 'N/A',
              'format': '',
-             'description': 'Maximum frame acquisition rate with in frames per second, givent the current the Roi/Bin, exposure and bandwidth settings.',
-         }],        
-    }
-
-    def __init__(self,name) :
-        PyTango.DeviceClass.__init__(self,name)
-        self.set_type(name)
-
-#----------------------------------------------------------------------------
-# Plugins
-#----------------------------------------------------------------------------
-_BaslerCam = None
-_BaslerInterface = None
-
-# packet_size = 8000 suppose the eth MTU is set at least to 8192 (Jumbo mode !)
-# otherwise frame transfer can failed, the package size must but
-# correspond to the MTU, see README file under Pylon-3.2.2 installation
-# directory for for details about network optimization.
-
-def get_control(frame_transmission_delay = 0, inter_packet_delay = 0,
-                packet_size = 8000,force_video_mode= 'false',blank_image_for_missed = 'false',
-                **keys) :
-    global _BaslerCam
-    global _BaslerInterface
-
-    if 'camera_id' in keys:
-        camera_id = keys['camera_id']
-    elif 'serial_number' in keys:
-        camera_id = 'sn://' + keys['serial_number']
-    elif 'cam_ip_address' in keys:
-        camera_id = 'ip://' + keys['cam_ip_address']
-    elif 'user_name' in keys:
-        camera_id = 'uname://' + keys['user_name']
-    else:
-        # if no property is present it uses the server personal name
-        # as Basler user name to identify the camera
-        util = PyTango.Util.instance()
-        camera_id = 'uname://' + util.get_ds_inst_name()
-
-    print ("basler camera_id:", camera_id)
-    
-    # all properties are passed as string from LimaCCDs device get_control helper
-    # so need to be converted to correct type
-    if force_video_mode == 'true':
-        force = True
-    elif force_video_mode == 'false':
-        force = False
-    else:
-        raise ValueError("Invalid force_video_mode value, expecting 'true' or ' false'")
-
-    if _BaslerCam is None:
-        _BaslerCam = BaslerAcq.Camera(camera_id, int(packet_size))
-        _BaslerCam.setInterPacketDelay(int(inter_packet_delay))
-        _BaslerCam.setFrameTransmissionDelay(int(frame_transmission_delay))
-        _BaslerInterface = BaslerAcq.Interface(_BaslerCam, force)
-
-    if blank_image_for_missed == 'true':
-        _BaslerInterface.setBlankImageForMissed(True)
-        
-    return core.CtControl(_BaslerInterface)
+             'description': 'beam analysis results computed in the acquisition',
+         }],
+        'beam_intensity':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'sum above background of the last analysed frame',
+         }],
+        'beam_centroid_x':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'beam centroid of the last analysed frame',
+         }],
+        'beam_centroid_y':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'beam centroid of the last analysed frame',
+         }],
+        'beam_sigma_x':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'beam rms width of the last analysed frame',
+         }],
+        'beam_sigma_y':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'beam rms height of the last analysed frame',
+         }],
+        'beam_fwhm_x':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'fwhm of the x projection of the last analysed frame',
+         }],
+        'beam_fwhm_y':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'pixel',
+             'format': '',
+             'description': 'fwhm of the y projection of the last analysed frame',
+         }],
+        'beam_projection_x':
+        [[PyTango.DevDouble,
+          PyTango.SPECTRUM,
+          PyTango.READ, 16384],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'column sums over the roi of the last analysed frame',
+         }],
+        'beam_projection_y':
+        [[PyTango.DevDouble,
+          PyTango.SPECTRUM,
+          PyTango.READ, 16384],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'row sums over the roi of the last analysed frame',
+         }],
+        'auto_exposure_loop_mode':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'software auto exposure from the frame stats histograms, from the next acquisition: OFF, EXP_TIME or EXP_TIME_GAIN',
+         }],
+        'auto_exposure_loop_target':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'level of the percentile to reach, fraction of full scale',
+         }],
+        'auto_exposure_loop_percentile':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'fraction of the pixels below the level, 0.5 for the median',
+         }],
+        'auto_exposure_loop_tolerance':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'relative level error left uncorrected',
+         }],
+        'auto_exposure_loop_max_step':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'largest exposure factor of one adjustment',
+         }],
+        'auto_exposure_loop_max_exp':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'longest exposure time set by the loop, 0 for the camera maximum',
+         }],
+        'auto_exposure_loop_settle':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames ignored after an adjustment',
+         }],
+        'auto_exposure_loop_state':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'json snapshot of the software auto exposure loop',
+         }],
+        'acq_state':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'json snapshot of the acquisition state published by the grab thread',
+         }],
+        'last_frame_age':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'time since the last frame was received, -1 if none',
+         }],
+        'control_channel_statistics':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'json snapshot of the GenApi control channel queue and waits (s) since the reset',
+         }],
+        'test_image_selector':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'select a test image image_off/image_1/.../image_7',
+         }],
+        'output1_line_source':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'select a source for I/O output1 line',
+         }],
+        'temperature':
+        [[PyTango.DevFloat,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'Celsuis',
+             'format': '',
+             'description': 'camera core temperature',
+         }],        
+        'frame_rate':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'fps',
+             'format': '',
+             'description': 'Maximum frame acquisition rate with in frames per second, givent the current the Roi/Bin, exposure and bandwidth settings.',
+         }],        
+        'soft_trigger_event_mode':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'IntTrigMult: use camera events instead of polling before each software trigger',
+         }],
+        'soft_trigger_queue_size':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'IntTrigMult: number of software triggers queued while camera is busy',
+         }],
+        'timer_trigger_mode':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'IntTrig: frames triggered by the camera periodic signal generator',
+         }],
+        'timer_trigger_period':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'IntTrig timer trigger: period of the trigger train',
+         }],
+        'timer_trigger_burst_count':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'IntTrig timer trigger: number of frames per period',
+         }],
+        'soft_trigger_latencies':
+        [[PyTango.DevDouble,
+          PyTango.SPECTRUM,
+          PyTango.READ, 100000],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'IntTrigMult: per frame software trigger to exposure start latency',
+         }],
+        'sequencer_mode':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'upload the sequence sets and switch the camera sequencer on/off',
+         }],
+        'sequencer_advance':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'sequencer advances on frame count or on input line1',
+         }],
+        'sequence_set_executions':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'number of frames taken with each sequence set',
+         }],
+        'nb_sequence_sets':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'number of sequence sets defined',
+         }],
+        'frame_sequence_set_indexes':
+        [[PyTango.DevLong,
+          PyTango.SPECTRUM,
+          PyTango.READ, 100000],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'sequence set used for each frame, -1 if unknown',
+         }],
+        'hdr_mode':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'merge each group of bracketed exposures in one Bpp32/Bpp32F frame',
+         }],
+        'hdr_exposure_times':
+        [[PyTango.DevDouble,
+          PyTango.SPECTRUM,
+          PyTango.READ_WRITE, 64],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'HDR: exposure time of each frame of a group, empty to use the sequence sets',
+         }],
+        'hdr_saturation_level':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'HDR: pixel value considered as saturated, 0 for full scale',
+         }],
+        'buffer_quota':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'B',
+             'format': '',
+             'description': 'max frame buffer memory of this camera, 0 for no quota',
+         }],
+        'grab_frame_rate':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'Hz',
+             'format': '',
+             'description': 'frames grabbed per second since the acquisition start',
+         }],
+        'grab_data_rate':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'B/s',
+             'format': '',
+             'description': 'bytes grabbed per second since the acquisition start',
+         }],
+        'grab_cpu_load':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'fraction of a core used by the grab thread for this camera',
+         }],
+        'stream_buffer_count':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'requested Pylon stream buffers, reduced to fit the memory budget',
+         }],
+        'memory_used':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'B',
+             'format': '',
+             'description': 'frame and stream buffers memory of this camera',
+         }],
+        'memory_peak':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'B',
+             'format': '',
+             'description': 'peak frame and stream buffers memory of this camera',
+         }],
+        'memory_budget':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'B',
+             'format': '',
+             'description': 'buffer memory limit of all the cameras of the process, 0 for no limit',
+         }],
+        'numa_node':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'numa node of the camera network interface, -1 if unknown',
+         }],
+        'thread_affinity':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'numa node and cpus of the grab, receive and processing threads',
+         }],
+        'video_live_strategy':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'video live grab strategy: ONE_BY_ONE, LATEST_IMAGE_ONLY or LATEST_IMAGES',
+         }],
+        'video_latest_images_depth':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'queue depth of the LATEST_IMAGES live strategy',
+         }],
+        'video_snapshot_strategy':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'video single frame grab strategy: ONE_BY_ONE or UPCOMING_IMAGE',
+         }],
+        'nb_skipped_frames':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames dropped by the video grab strategy since the acquisition start',
+         }],
+        'video_lend_mode':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'video frames delivered by a thread holding the grab results',
+         }],
+        'video_lend_pool_size':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'video frames lent at the same time',
+         }],
+        'nb_video_lend_drops':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'video frames dropped with all the handles lent since the acquisition start',
+         }],
+        'missed_frame_mode':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'missed frames: IGNORE, BLANK on the grab thread or MARK and blank on a filler thread',
+         }],
+        'missed_frames':
+        [[PyTango.DevLong,
+          PyTango.SPECTRUM,
+          PyTango.READ, 100000],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'blank frames, ring of the buffers for continuous acquisition',
+         }],
+        'nb_missed_frames':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames missed since the acquisition start',
+         }],
+        'missed_frame_gaps':
+        [[PyTango.DevLong64,
+          PyTango.SPECTRUM,
+          PyTango.READ, 16],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'missed frame gaps since the acquisition start, bin i counts the gaps of [2^i,2^(i+1)) frames',
+         }],
+        'nb_lost_frames':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'missed frames never received since the acquisition start',
+         }],
+        'nb_duplicated_frames':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames received twice since the acquisition start, dropped',
+         }],
+        'nb_late_frames':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'missed frames received after the next ones since the acquisition start, dropped',
+         }],
+        'overrun_policy':
+        [[PyTango.DevString,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'when lima buffers are full: STOP, DROP_NEWEST, DECIMATE or THROTTLE',
+         }],
+        'overrun_decimation':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames kept by the DECIMATE overrun policy: every nth',
+         }],
+        'overrun_recovery_frames':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames without overrun before the overrun policy stops applying',
+         }],
+        'overrun_active':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'overrun policy applying',
+         }],
+        'nb_overruns':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames refused by lima since the acquisition start',
+         }],
+        'nb_overrun_drops':
+        [[PyTango.DevLong64,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'frames dropped by the overrun policy since the acquisition start',
+         }],
+        'preview_mode':
+        [[PyTango.DevBoolean,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'decimated and binned preview of the acquired frames',
+         }],
+        'preview_decimation':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'preview every nth frame',
+         }],
+        'preview_max_rate':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'Hz',
+             'format': '',
+             'description': 'max preview frame rate, 0 for no limit',
+         }],
+        'preview_binning':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'preview box filter size',
+         }],
+        'preview_image':
+        [[PyTango.DevEncoded,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'latest preview: frame_nb, width, height (int32) then the pixels',
+         }],
+        'grab_loop_priority':
+        [[PyTango.DevLong,
+          PyTango.SCALAR,
+          PyTango.READ_WRITE],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'SCHED_FIFO priority of the user grab loop, 0 for normal scheduling',
+         }],
+        'grab_loop_wakeups_per_frame':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 'N/A',
+             'format': '',
+             'description': 'user grab loop wakeups per frame since the acquisition start',
+         }],
+        'grab_loop_latency':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'mean wakeup latency of the user grab loop after the frame timestamp',
+         }],
+        'grab_loop_max_latency':
+        [[PyTango.DevDouble,
+          PyTango.SCALAR,
+          PyTango.READ],
+         {
+             'unit': 's',
+             'format': '',
+             'description': 'max wakeup latency of the user grab loop after the frame timestamp',
+         }],
+    }
+
+    def __init__(self,name) :
+        PyTango.DeviceClass.__init__(self,name)
+        self.set_type(name)
+
+#----------------------------------------------------------------------------
+# Plugins
+#----------------------------------------------------------------------------
+_BaslerCam = None
+_BaslerInterface = None
+
+# packet_size = 8000 suppose the eth MTU is set at least to 8192 (Jumbo mode !)
+# otherwise frame transfer can failed, the package size must but
+# correspond to the MTU, see README file under Pylon-3.2.2 installation
+# directory for for details about network optimization.
+# packet_size = -1 (or auto) negotiates the largest packet size of the path,
+# 0 keeps the camera setting.
+
+def get_control(frame_transmission_delay = 0, inter_packet_delay = 0,
+                packet_size = 8000,force_video_mode= 'false',blank_image_for_missed = 'false',
+                shared_grab_loop = 'false', memory_budget = 0,
+                receive_thread_cpus = '', grab_thread_cpus = '',
+                processing_thread_cpus = '', numa_local_buffers = 'false',
+                user_grab_loop = 'false', grab_loop_priority = 0,
+                telemetry_period = 0., **keys) :
+    global _BaslerCam
+    global _BaslerInterface
+
+    if 'camera_id' in keys:
+        camera_id = keys['camera_id']
+    elif 'serial_number' in keys:
+        camera_id = 'sn://' + keys['serial_number']
+    elif 'cam_ip_address' in keys:
+        camera_id = 'ip://' + keys['cam_ip_address']
+    elif 'user_name' in keys:
+        camera_id = 'uname://' + keys['user_name']
+    else:
+        # if no property is present it uses the server personal name
+        # as Basler user name to identify the camera
+        util = PyTango.Util.instance()
+        camera_id = 'uname://' + util.get_ds_inst_name()
+
+    print ("basler camera_id:", camera_id)
+    
+    # all properties are passed as string from LimaCCDs device get_control helper
+    # so need to be converted to correct type
+    if force_video_mode == 'true':
+        force = True
+    elif force_video_mode == 'false':
+        force = False
+    else:
+        raise ValueError("Invalid force_video_mode value, expecting 'true' or ' false'")
+
+    if str(packet_size).lower() == 'auto':
+        packet_size = BaslerAcq.Camera.PacketSizeAuto
+
+    if _BaslerCam is None:
+        _BaslerCam = BaslerAcq.Camera(camera_id, int(packet_size))
+        _BaslerCam.setInterPacketDelay(int(inter_packet_delay))
+        _BaslerCam.setFrameTransmissionDelay(int(frame_transmission_delay))
+        _BaslerInterface = BaslerAcq.Interface(_BaslerCam, force)
+
+    if blank_image_for_missed == 'true':
+        _BaslerInterface.setBlankImageForMissed(True)
+
+    if shared_grab_loop == 'true':
+        _BaslerCam.setSharedGrabLoop(True)
+
+    if user_grab_loop == 'true':
+        _BaslerCam.setUserGrabLoop(True)
+        _BaslerCam.setGrabLoopPriority(int(grab_loop_priority))
+
+    if float(telemetry_period) > 0.:
+        _BaslerCam.setTelemetryPeriod(float(telemetry_period))
+
+    if int(memory_budget) > 0:
+        BaslerAcq.ResourcePool.getInstance().setBufferMemoryLimit(int(memory_budget))
+
+    # processing cpus are set on this thread until the lima threads
+    # created by CtControl have inherited them
+    _BaslerCam.setThreadCpus(BaslerAcq.Camera.ReceiveThread, receive_thread_cpus)
+    _BaslerCam.setThreadCpus(BaslerAcq.Camera.GrabThread, grab_thread_cpus)
+    _BaslerCam.setThreadCpus(BaslerAcq.Camera.ProcessingThread, processing_thread_cpus)
+    if numa_local_buffers == 'true':
+        _BaslerCam.setNumaLocalBuffers(True)
+    print ("basler thread affinity:\n" + _BaslerCam.getAffinityReport())
+
+    control = core.CtControl(_BaslerInterface)
+    _BaslerCam.restoreThreadCpus()
+    return control
 
 def get_tango_specific_class_n_device():
     return BaslerClass,Basler
@@ -0,0 +1,133 @@
+############################################################################
+# This file is part of LImA, a Library for Image Acquisition
+#
+# Copyright (C) : 2009-2026
+# European Synchrotron Radiation Facility
+# CS40220 38043 Grenoble Cedex 9 
+# FRANCE
+#
+# Contact: lima@esrf.fr
+#
+# This is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This software is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, see <http://www.gnu.org/licenses/>.
+############################################################################
+"""BandwidthPlanner.plan() on hand filled camera loads, no camera needed.
+
+Runs against the limabasler python module of the build tree, found
+through PYTHONPATH (LIMA_ENABLE_PYTHON), else the installed lima.basler.
+"""
+
+import unittest
+
+try:
+    from lima import core  # noqa: F401, limabasler depends on it
+    from limabasler import Basler as basler
+except ImportError:
+    from lima import basler
+
+LINK = 125e6        # 1 GbE, bytes/s
+RESERVE = 0.1
+TICK = 125e6        # GigE timestamp tick, Hz
+ETHERNET_OVERHEAD = 38
+
+
+def _load(payload_size, frame_rate, packet_size=8192):
+    load = basler.BandwidthPlanner.CameraLoad()
+    load.payload_size = payload_size
+    load.packet_size = packet_size
+    load.frame_rate = frame_rate
+    load.tick_frequency = TICK
+    return load
+
+
+def _demand(load):
+    return basler.BandwidthPlanner.getFrameWireSize(load) * load.frame_rate
+
+
+class TestBandwidthPlanner(unittest.TestCase):
+
+    def test_staggered(self):
+        # the two frames fit back to back in the frame period:
+        # bursts at the usable link rate, one after the other
+        loads = [_load(1000000, 10.), _load(1000000, 10.)]
+        plans, link_headroom = basler.BandwidthPlanner.plan(LINK, loads, RESERVE)
+        usable = LINK * (1. - RESERVE)
+        wire_size = basler.BandwidthPlanner.getFrameWireSize(loads[0])
+        packet = loads[0].packet_size + ETHERNET_OVERHEAD
+        burst_delay = int((packet / usable - packet / LINK) * TICK + .5)
+
+        self.assertEqual(plans[0].frame_transmission_delay, 0)
+        self.assertEqual(plans[1].frame_transmission_delay,
+                         int(wire_size / usable * TICK + .5))
+        for aPlan in plans:
+            self.assertEqual(aPlan.inter_packet_delay, burst_delay)
+            self.assertAlmostEqual(aPlan.frame_rate, 10.)
+            self.assertAlmostEqual(aPlan.bandwidth, usable / 2)
+        self.assertAlmostEqual(link_headroom,
+                               1. - sum(_demand(l) for l in loads) / LINK)
+
+    def test_paced(self):
+        # a fast small frame and a slow large one do not fit in the
+        # shortest period: each camera is paced to its share of the link
+        loads = [_load(100000, 100.), _load(5000000, 10.)]
+        plans, link_headroom = basler.BandwidthPlanner.plan(LINK, loads, RESERVE)
+        usable = LINK * (1. - RESERVE)
+        total = sum(_demand(l) for l in loads)
+        packet = loads[0].packet_size + ETHERNET_OVERHEAD
+
+        for i, (load, aPlan) in enumerate(zip(loads, plans)):
+            bandwidth = usable * _demand(load) / total
+            self.assertAlmostEqual(aPlan.bandwidth, bandwidth, delta=1.)
+            self.assertAlmostEqual(aPlan.frame_rate, load.frame_rate)
+            self.assertAlmostEqual(aPlan.headroom, 1. - total / usable)
+            self.assertEqual(aPlan.inter_packet_delay,
+                             int((packet / bandwidth - packet / LINK) * TICK + .5))
+            # first packets one packet slot apart
+            self.assertEqual(aPlan.frame_transmission_delay,
+                             int(i * packet / LINK * TICK + .5))
+        self.assertAlmostEqual(link_headroom, 1. - total / LINK)
+
+    def test_overloaded(self):
+        # the frame rates are scaled down to the usable link
+        loads = [_load(1000000, 100.) for i in range(3)]
+        plans, link_headroom = basler.BandwidthPlanner.plan(LINK, loads, RESERVE)
+        usable = LINK * (1. - RESERVE)
+        total = sum(_demand(l) for l in loads)
+
+        self.assertLess(link_headroom, 0.)
+        self.assertAlmostEqual(link_headroom, 1. - total / LINK)
+        for aPlan in plans:
+            self.assertLess(aPlan.headroom, 0.)
+            self.assertAlmostEqual(aPlan.bandwidth, usable / 3, delta=1.)
+            self.assertAlmostEqual(aPlan.frame_rate, 100. * usable / total)
+        self.assertLessEqual(sum(p.frame_rate * basler.BandwidthPlanner.getFrameWireSize(l)
+                                 for p, l in zip(plans, loads)), usable * (1. + 1e-9))
+
+    def test_max_throughput(self):
+        # the device throughput caps the frame rate of the demand
+        load = _load(1000000, 100.)
+        load.max_throughput = 20e6
+        plans, link_headroom = basler.BandwidthPlanner.plan(LINK, [load], RESERVE)
+        self.assertAlmostEqual(plans[0].frame_rate, 20.)
+
+    def test_invalid(self):
+        with self.assertRaises(Exception):
+            basler.BandwidthPlanner.plan(0., [_load(1000, 10.)], RESERVE)
+        with self.assertRaises(Exception):
+            basler.BandwidthPlanner.plan(LINK, [_load(1000, 10.)], 1.)
+        with self.assertRaises(Exception):
+            basler.BandwidthPlanner.plan(LINK, [_load(1000, 10., packet_size=36)], RESERVE)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,190 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+// Beam analysis without camera: spots of known shape are drawn
+// on a flat background.
+
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include "BaslerBeamAnalysis.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static int nb_errors = 0;
+
+#define CHECK(cond)							\
+  if(!(cond))								\
+    {									\
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #cond " failed" << std::endl; \
+      ++nb_errors;							\
+    }
+
+static bool near(double a,double b,double tolerance = 1e-6)
+{
+  return std::fabs(a - b) <= tolerance * (1. + std::fabs(b));
+}
+
+template<class T>
+static void fill_rect(std::vector<T>& frame,int width,int x0,int y0,int w,int h,T value)
+{
+  for(int y = y0;y < y0 + h;++y)
+    for(int x = x0;x < x0 + w;++x)
+      frame[size_t(y) * width + x] = value;
+}
+
+template<class T>
+static bool analyse(BeamAnalysis& analysis,ImageType type,const std::vector<T>& frame,
+		    int width,int height,BeamAnalysis::Result& result)
+{
+  analysis.prepare(type,Size(width,height));
+  analysis.process(frame.data(),width,height,frame.size() * sizeof(T),0,0.);
+  return analysis.getLastResult(result);
+}
+
+//- linear interpolation at half maximum
+static void test_fwhm()
+{
+  CHECK(near(BeamAnalysis::fwhm({0,1,2,3,4,3,2,1,0}),4.));
+  CHECK(near(BeamAnalysis::fwhm({0,0,8,8,8,0}),3.));
+  // the profile edge when it does not fall to half
+  CHECK(near(BeamAnalysis::fwhm({8,8,2,0}),1. + 4. / 6.));
+  CHECK(BeamAnalysis::fwhm({0,0,0}) == 0.);
+  CHECK(BeamAnalysis::fwhm({}) == 0.);
+}
+
+//- uniform square on an odd width, 16 bit
+static void test_square()
+{
+  const int width = 67,height = 48;
+  std::vector<uint16_t> frame(size_t(width) * height,100);
+  fill_rect<uint16_t>(frame,width,10,20,10,10,1000);
+
+  BeamAnalysis analysis;
+  analysis.setBackground(100.);
+  analysis.setThreshold(50.);
+  BeamAnalysis::Result result;
+  CHECK(analyse(analysis,Bpp16,frame,width,height,result));
+  CHECK(result.valid);
+  CHECK(result.nb_pixels == 100);
+  CHECK(near(result.intensity,100 * 900.));
+  CHECK(near(result.centroid_x,14.5));
+  CHECK(near(result.centroid_y,24.5));
+  // uniform over 10 pixels: sqrt((10^2 - 1) / 12)
+  CHECK(near(result.sigma_x,sqrt(99. / 12.)));
+  CHECK(near(result.sigma_y,sqrt(99. / 12.)));
+  CHECK(std::fabs(result.sigma_xy) < 1e-6);
+  CHECK(near(result.fwhm_x,10.));
+  CHECK(near(result.fwhm_y,10.));
+  CHECK(int(result.projection_x.size()) == width);
+  CHECK(int(result.projection_y.size()) == height);
+  CHECK(near(result.projection_x[10],9000.));
+  CHECK(result.projection_x[9] == 0.f);
+}
+
+//- centroid in frame coordinates, projections over the roi
+static void test_roi()
+{
+  const int width = 67,height = 48;
+  std::vector<uint8_t> frame(size_t(width) * height,10);
+  fill_rect<uint8_t>(frame,width,10,20,10,10,210);
+  // out of the roi
+  fill_rect<uint8_t>(frame,width,50,2,5,5,250);
+
+  BeamAnalysis analysis;
+  analysis.setBackground(10.);
+  analysis.setRoi(Roi(5,15,31,21));
+  BeamAnalysis::Result result;
+  CHECK(analyse(analysis,Bpp8,frame,width,height,result));
+  CHECK(result.nb_pixels == 100);
+  CHECK(near(result.centroid_x,14.5));
+  CHECK(near(result.centroid_y,24.5));
+  CHECK(result.projection_x.size() == 31);
+  CHECK(result.projection_y.size() == 21);
+  CHECK(near(result.projection_y[5],2000.));
+}
+
+//- pixels at threshold or below weigh nothing
+static void test_threshold()
+{
+  const int width = 33,height = 9;
+  std::vector<uint16_t> frame(size_t(width) * height,100);
+  fill_rect<uint16_t>(frame,width,4,4,3,1,150);
+
+  BeamAnalysis analysis;
+  analysis.setBackground(100.);
+  analysis.setThreshold(50.);
+  BeamAnalysis::Result result;
+  CHECK(analyse(analysis,Bpp12,frame,width,height,result));
+  CHECK(!result.valid);
+  CHECK(result.nb_pixels == 0);
+  CHECK(result.centroid_x == 0. && result.fwhm_x == 0.);
+
+  fill_rect<uint16_t>(frame,width,4,4,1,1,151);
+  analysis.process(frame.data(),width,height,frame.size() * sizeof(uint16_t),1,0.);
+  CHECK(analysis.getLastResult(result));
+  CHECK(result.valid);
+  CHECK(result.nb_pixels == 1);
+  CHECK(near(result.centroid_x,4.) && near(result.centroid_y,4.));
+}
+
+//- a large frame split in bands gives the single thread results
+static void test_bands()
+{
+  const int width = 1031,height = 1031;
+  std::vector<uint16_t> frame(size_t(width) * height,0);
+  // tilted spot
+  for(int i = 0;i < 400;++i)
+    fill_rect<uint16_t>(frame,width,300 + i,200 + i,7,3,uint16_t(1000 + i));
+
+  BeamAnalysis single,bands;
+  bands.setNbThreads(4);
+  BeamAnalysis::Result r1,r4;
+  CHECK(analyse(single,Bpp16,frame,width,height,r1));
+  CHECK(analyse(bands,Bpp16,frame,width,height,r4));
+  CHECK(r1.nb_pixels == r4.nb_pixels);
+  CHECK(near(r1.intensity,r4.intensity,1e-9));
+  CHECK(near(r1.centroid_x,r4.centroid_x,1e-9));
+  CHECK(near(r1.centroid_y,r4.centroid_y,1e-9));
+  CHECK(near(r1.sigma_x,r4.sigma_x,1e-9));
+  CHECK(near(r1.sigma_y,r4.sigma_y,1e-9));
+  CHECK(near(r1.sigma_xy,r4.sigma_xy,1e-9));
+  CHECK(r1.sigma_xy > 0.);
+  CHECK(near(r1.fwhm_x,r4.fwhm_x,1e-6));
+  CHECK(near(r1.fwhm_y,r4.fwhm_y,1e-6));
+  CHECK(r1.projection_y == r4.projection_y);
+}
+
+int main()
+{
+  test_fwhm();
+  test_square();
+  test_roi();
+  test_threshold();
+  test_bands();
+  if(nb_errors)
+    std::cerr << nb_errors << " check(s) failed" << std::endl;
+  return nb_errors ? 1 : 0;
+}
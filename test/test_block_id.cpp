@@ -0,0 +1,93 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+// Block id arithmetic around the wrap of 16 and 64 bit block ids.
+
+#include <iostream>
+#include <stdint.h>
+#include "BaslerBlockId.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static int nb_errors = 0;
+
+#define CHECK(cond)							\
+  if(!(cond))								\
+    {									\
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #cond " failed" << std::endl; \
+      ++nb_errors;							\
+    }
+
+//- GigE Vision 1: 1 to 65535, 0 is skipped at the wrap
+static void test_16_bits()
+{
+  CHECK(BlockId::distance(1,2,16) == 1);
+  CHECK(BlockId::distance(2,1,16) == -1);
+  CHECK(BlockId::distance(5,5,16) == 0);
+  CHECK(BlockId::distance(65535,1,16) == 1);
+  CHECK(BlockId::distance(1,65535,16) == -1);
+  CHECK(BlockId::distance(65530,3,16) == 8);
+  CHECK(BlockId::distance(3,65530,16) == -8);
+  // half a turn is the largest distance either way
+  CHECK(BlockId::distance(1,32768,16) == 32767);
+  CHECK(BlockId::distance(32768,1,16) == -32767);
+  CHECK(BlockId::distance(1,32769,16) == -32767);
+
+  CHECK(BlockId::next(1,1,16) == 2);
+  CHECK(BlockId::next(65534,1,16) == 65535);
+  CHECK(BlockId::next(65535,1,16) == 1);
+  CHECK(BlockId::next(65530,8,16) == 3);
+  CHECK(BlockId::next(7,65535,16) == 7);
+  for(uint64_t id = 65000;id <= 65535;++id)
+    for(long long nb = 0;nb < 1000;nb += 37)
+      CHECK(BlockId::distance(id,BlockId::next(id,nb,16),16) == nb);
+}
+
+//- GigE Vision 2 and USB: unsigned 64 bit wrap
+static void test_64_bits()
+{
+  const uint64_t last = ~uint64_t(0);
+  CHECK(BlockId::distance(0,1,64) == 1);
+  CHECK(BlockId::distance(1,0,64) == -1);
+  CHECK(BlockId::distance(last,0,64) == 1);
+  CHECK(BlockId::distance(0,last,64) == -1);
+  CHECK(BlockId::distance(last - 2,5,64) == 8);
+  // beyond 65535, no 16 bit wrap
+  CHECK(BlockId::distance(65535,65536,64) == 1);
+  CHECK(BlockId::distance(65535,1,64) == -65534);
+
+  CHECK(BlockId::next(last,1,64) == 0);
+  CHECK(BlockId::next(65535,1,64) == 65536);
+  CHECK(BlockId::next(last - 2,8,64) == 5);
+}
+
+int main()
+{
+  test_16_bits();
+  test_64_bits();
+  if(nb_errors)
+    std::cerr << nb_errors << " check(s) failed" << std::endl;
+  return nb_errors ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+// Camera array grabbed with the Pylon camera emulator, run with
+// PYLON_CAMEMU=2: the frames of the two cameras are aligned by frame
+// counter into one complete set per frame.
+
+#include <iostream>
+#include <memory>
+#include <unistd.h>
+
+#include "lima/CtControl.h"
+#include "lima/CtAcquisition.h"
+#include "BaslerCameraArray.h"
+#include "BaslerInterface.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static const int NB_FRAMES = 50;
+static const int TIMEOUT = 10;	// s
+
+int main()
+{
+  std::vector<std::string> camera_ids;
+  camera_ids.push_back("sn://0815-0000");
+  camera_ids.push_back("sn://0815-0001");
+
+  try
+    {
+      CameraArray array(camera_ids);
+      array.setAlignMode(CameraArray::AlignByFrameCounter);
+      array.setTrigMode(IntTrig);
+      array.setExpTime(1e-3);
+      array.setLatTime(0.);
+
+      std::vector<std::unique_ptr<Interface> > interfaces;
+      std::vector<std::unique_ptr<CtControl> > controls;
+      for(int i = 0;i < array.getNbCameras();++i)
+	{
+	  interfaces.emplace_back(new Interface(array.getCamera(i)));
+	  controls.emplace_back(new CtControl(interfaces.back().get()));
+	  CtAcquisition *acq = controls.back()->acquisition();
+	  acq->setAcqNbFrames(NB_FRAMES);
+	  acq->setAcqExpoTime(1e-3);
+	  controls.back()->prepareAcq();
+	}
+      // grabbing starts with the last camera
+      for(size_t i = 0;i < controls.size();++i)
+	controls[i]->startAcq();
+
+      for(int wait = 0;wait < TIMEOUT * 10;++wait)
+	{
+	  bool running = false;
+	  for(size_t i = 0;i < controls.size();++i)
+	    {
+	      CtControl::Status status;
+	      controls[i]->getStatus(status);
+	      running |= status.AcquisitionStatus == AcqRunning;
+	    }
+	  if(!running)
+	    break;
+	  usleep(100000);
+	}
+
+      int nb_sets,nb_incomplete;
+      array.getNbFrameSets(nb_sets);
+      array.getNbIncompleteFrameSets(nb_incomplete);
+      int nb_errors = 0;
+      if(nb_sets != NB_FRAMES || nb_incomplete)
+	{
+	  std::cerr << "frame sets: " << nb_sets << ", incomplete: " << nb_incomplete
+		    << ", expected " << NB_FRAMES << " complete" << std::endl;
+	  ++nb_errors;
+	}
+      for(int set_nb = 0;set_nb < nb_sets;++set_nb)
+	{
+	  std::vector<int> frame_nbs;
+	  double skew;
+	  array.getFrameSet(set_nb,frame_nbs,skew);
+	  for(size_t i = 0;i < frame_nbs.size();++i)
+	    if(frame_nbs[i] != set_nb)
+	      {
+		std::cerr << "frame set " << set_nb << ": camera " << i
+			  << " frame " << frame_nbs[i] << std::endl;
+		++nb_errors;
+	      }
+	}
+      return nb_errors ? 1 : 0;
+    }
+  catch(Exception& e)
+    {
+      std::cerr << e.getErrMsg() << std::endl;
+      return 1;
+    }
+}
@@ -0,0 +1,196 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+// Frame set alignment without camera: frames are fed by hand
+// in the order the grab thread of an array could see them.
+
+#include <cmath>
+#include <iostream>
+#include "BaslerFrameSetAligner.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static int nb_errors = 0;
+
+#define CHECK(cond)							\
+  if(!(cond))								\
+    {									\
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #cond " failed" << std::endl; \
+      ++nb_errors;							\
+    }
+
+static std::vector<int> frame_nbs(const FrameSetAligner& aligner,int set_nb)
+{
+  FrameSetAligner::FrameSet frame_set;
+  if(!aligner.getFrameSet(set_nb,frame_set))
+    return std::vector<int>();
+  return frame_set.frame_nbs;
+}
+
+//- camera 1 misses frame 2, the set is closed at its next frame
+static void test_frame_counter()
+{
+  FrameSetAligner aligner;
+  aligner.reset(2);
+  for(int frame_nb = 0;frame_nb < 2;++frame_nb)
+    {
+      aligner.addFrame(0,frame_nb,frame_nb * 1e-2);
+      aligner.addFrame(1,frame_nb,frame_nb * 1e-2);
+    }
+  aligner.addFrame(0,2,2e-2);
+  aligner.addFrame(0,3,3e-2);
+  // set 2 waits for camera 1
+  CHECK(frame_nbs(aligner,2).empty());
+  aligner.addFrame(1,3,3e-2);
+
+  CHECK(aligner.getNbFrameSets() == 4);
+  CHECK(frame_nbs(aligner,1) == std::vector<int>({1,1}));
+  CHECK(frame_nbs(aligner,2) == std::vector<int>({2,-1}));
+  CHECK(frame_nbs(aligner,3) == std::vector<int>({3,3}));
+  CHECK(aligner.getNbIncompleteFrameSets() == 1);
+  CHECK(aligner.getDroppedFrames() == std::vector<int>({0,1}));
+  CHECK(aligner.getNbSkewedFrameSets() == 0);
+}
+
+//- camera 1 misses block 1 without blank frame, its lima frame
+//- numbers are behind those of camera 0
+static void test_block_counter()
+{
+  FrameSetAligner aligner;
+  aligner.reset(2);
+  aligner.addFrame(0,0,0.,0);
+  aligner.addFrame(1,0,0.,0);
+  aligner.addFrame(0,1,1e-2,1);
+  aligner.addFrame(0,2,2e-2,2);
+  aligner.addFrame(1,1,2e-2,2);
+
+  CHECK(aligner.getNbFrameSets() == 3);
+  CHECK(frame_nbs(aligner,1) == std::vector<int>({1,-1}));
+  CHECK(frame_nbs(aligner,2) == std::vector<int>({2,1}));
+  CHECK(aligner.getDroppedFrames() == std::vector<int>({0,1}));
+}
+
+//- only the last sets of the history are kept, a camera which
+//- stops delivering does not keep the sets open
+static void test_history()
+{
+  FrameSetAligner aligner;
+  aligner.setFrameSetHistory(4);
+  aligner.reset(2);
+  for(int frame_nb = 0;frame_nb < 10;++frame_nb)
+    aligner.addFrame(0,frame_nb,frame_nb * 1e-2);
+
+  // sets 0 to 5 closed incomplete, 6 to 9 still open
+  CHECK(aligner.getNbFrameSets() == 6);
+  CHECK(aligner.getNbIncompleteFrameSets() == 6);
+  CHECK(frame_nbs(aligner,1).empty());
+  CHECK(frame_nbs(aligner,5) == std::vector<int>({5,-1}));
+  CHECK(frame_nbs(aligner,6).empty());
+
+  aligner.flush();
+  CHECK(aligner.getNbFrameSets() == 10);
+  CHECK(frame_nbs(aligner,5).empty());
+  CHECK(frame_nbs(aligner,6) == std::vector<int>({6,-1}));
+  CHECK(frame_nbs(aligner,9) == std::vector<int>({9,-1}));
+}
+
+//- camera 1 is 0.2 ms late and misses the third frame
+static void test_timestamp()
+{
+  FrameSetAligner aligner;
+  aligner.setAlignMode(FrameSetAligner::AlignByTimestamp);
+  aligner.setAlignTolerance(1e-3);
+  aligner.reset(2);
+  aligner.addFrame(0,0,0.);
+  aligner.addFrame(1,0,2e-4);
+  aligner.addFrame(0,1,1e-2);
+  aligner.addFrame(1,1,1e-2 + 2e-4);
+  aligner.addFrame(0,2,2e-2);
+  aligner.addFrame(0,3,3e-2);
+  // frame numbers of the cameras no longer match
+  aligner.addFrame(1,2,3e-2 + 2e-4);
+
+  CHECK(aligner.getNbFrameSets() == 4);
+  CHECK(frame_nbs(aligner,2) == std::vector<int>({2,-1}));
+  CHECK(frame_nbs(aligner,3) == std::vector<int>({3,2}));
+  CHECK(aligner.getNbIncompleteFrameSets() == 1);
+  CHECK(aligner.getDroppedFrames() == std::vector<int>({0,1}));
+
+  FrameSetAligner::FrameSet frame_set;
+  CHECK(aligner.getFrameSet(0,frame_set) && frame_set.complete);
+  CHECK(std::fabs(frame_set.skew - 2e-4) < 1e-9);
+  CHECK(std::fabs(aligner.getMaxSkew() - 2e-4) < 1e-9);
+  CHECK(aligner.getNbSkewedFrameSets() == 0);
+}
+
+//- each frame is within tolerance of the latest one,
+//- the spread of the set is not
+static void test_skew()
+{
+  FrameSetAligner aligner;
+  aligner.setAlignMode(FrameSetAligner::AlignByTimestamp);
+  aligner.setAlignTolerance(1e-3);
+  aligner.reset(3);
+  aligner.addFrame(0,0,0.);
+  aligner.addFrame(1,0,9e-4);
+  aligner.addFrame(2,0,18e-4);
+
+  CHECK(frame_nbs(aligner,0) == std::vector<int>({0,0,0}));
+  CHECK(aligner.getNbSkewedFrameSets() == 1);
+  CHECK(std::fabs(aligner.getMaxSkew() - 18e-4) < 1e-9);
+}
+
+//- end of acquisition and restart
+static void test_flush()
+{
+  FrameSetAligner aligner;
+  aligner.reset(2);
+  aligner.addFrame(0,0,0.);
+  aligner.addFrame(1,0,0.);
+  aligner.addFrame(0,1,1e-2);
+  CHECK(aligner.getNbFrameSets() == 1);
+  aligner.flush();
+  CHECK(aligner.getNbFrameSets() == 2);
+  CHECK(frame_nbs(aligner,1) == std::vector<int>({1,-1}));
+  CHECK(aligner.getNbIncompleteFrameSets() == 1);
+
+  aligner.reset(2);
+  CHECK(aligner.getNbFrameSets() == 0);
+  CHECK(aligner.getNbIncompleteFrameSets() == 0);
+  CHECK(aligner.getDroppedFrames() == std::vector<int>({0,0}));
+}
+
+int main()
+{
+  test_frame_counter();
+  test_block_counter();
+  test_history();
+  test_timestamp();
+  test_skew();
+  test_flush();
+  if(nb_errors)
+    std::cerr << nb_errors << " check(s) failed" << std::endl;
+  return nb_errors ? 1 : 0;
+}
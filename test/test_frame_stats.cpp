@@ -0,0 +1,149 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+// Frame stats without camera: the results on frames of odd widths,
+// which end the SSE2 rows with scalar tails, are checked against a
+// plain scalar computation.
+
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include "BaslerFrameStats.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static int nb_errors = 0;
+
+#define CHECK(cond)							\
+  if(!(cond))								\
+    {									\
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #cond " failed" << std::endl; \
+      ++nb_errors;							\
+    }
+
+static unsigned int random_value(unsigned int& seed,unsigned int max_value)
+{
+  seed = seed * 1103515245u + 12345u;
+  return (seed >> 8) % (max_value + 1);
+}
+
+template<class T>
+static void check_frame(ImageType type,int nb_bits,int width,int height,
+			const Roi& roi,unsigned int seed)
+{
+  unsigned int max_value = (1u << nb_bits) - 1;
+  std::vector<T> frame(size_t(width) * height);
+  for(size_t i = 0;i < frame.size();++i)
+    frame[i] = T(random_value(seed,max_value));
+  // extreme values in the vector part and the tail
+  frame[0] = T(max_value);
+  frame.back() = 0;
+
+  const int nb_bins = 64;
+  const unsigned int level = max_value - max_value / 8;
+  FrameStats stats;
+  stats.setNbBins(nb_bins);
+  stats.setSaturationLevel(int(level));
+  stats.setRoi(roi);
+  stats.prepare(type);
+  stats.process(frame.data(),width,height,frame.size() * sizeof(T),0,0.);
+  FrameStats::Result result;
+  CHECK(stats.getLastResult(result));
+
+  int x0 = 0,y0 = 0,w = width,h = height;
+  if(roi.isActive())
+    {
+      x0 = roi.getTopLeft().x;
+      y0 = roi.getTopLeft().y;
+      w = roi.getSize().getWidth();
+      h = roi.getSize().getHeight();
+    }
+  unsigned int min = max_value,max = 0;
+  unsigned long long sum = 0,sum2 = 0;
+  long long nb_saturated = 0;
+  std::vector<unsigned int> histogram(nb_bins,0);
+  for(int y = y0;y < y0 + h;++y)
+    for(int x = x0;x < x0 + w;++x)
+      {
+	unsigned int v = frame[size_t(y) * width + x];
+	min = std::min(min,v);
+	max = std::max(max,v);
+	sum += v;
+	sum2 += (unsigned long long)v * v;
+	nb_saturated += v >= level;
+	++histogram[v * nb_bins >> nb_bits];
+      }
+  double nb_pixels = double(w) * h;
+  double mean = sum / nb_pixels;
+  double std = sqrt(std::max(sum2 / nb_pixels - mean * mean,0.));
+
+  bool ok = (result.nb_pixels == w * h && result.min == min && result.max == max &&
+	     result.sum == double(sum) && result.nb_saturated == nb_saturated &&
+	     result.histogram == histogram &&
+	     std::fabs(result.mean - mean) <= 1e-9 * (1. + mean) &&
+	     std::fabs(result.std - std) <= 1e-6 * (1. + std));
+  if(!ok)
+    {
+      std::cerr << nb_bits << " bit frame " << width << "x" << height
+		<< " roi " << x0 << "," << y0 << " " << w << "x" << h
+		<< ": stats differ from the scalar ones" << std::endl;
+      ++nb_errors;
+    }
+}
+
+//- every tail length of the 16 and 8 pixel SSE2 blocks
+static void test_odd_widths()
+{
+  for(int width = 1;width <= 49;width += 2)
+    {
+      check_frame<uint8_t>(Bpp8,8,width,3,Roi(),width);
+      check_frame<uint16_t>(Bpp12,12,width,3,Roi(),width);
+      check_frame<uint16_t>(Bpp16,16,width,3,Roi(),width);
+    }
+}
+
+//- rows longer than a reduction chunk
+static void test_long_rows()
+{
+  check_frame<uint8_t>(Bpp8,8,70001,2,Roi(),1);
+  check_frame<uint16_t>(Bpp16,16,70001,2,Roi(),2);
+}
+
+//- a roi starting on an odd pixel leaves the rows unaligned
+static void test_roi()
+{
+  check_frame<uint8_t>(Bpp8,8,101,9,Roi(3,1,37,5),3);
+  check_frame<uint16_t>(Bpp10,10,101,9,Roi(5,2,91,7),4);
+}
+
+int main()
+{
+  test_odd_widths();
+  test_long_rows();
+  test_roi();
+  if(nb_errors)
+    std::cerr << nb_errors << " check(s) failed" << std::endl;
+  return nb_errors ? 1 : 0;
+}
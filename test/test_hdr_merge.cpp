@@ -0,0 +1,128 @@
+//###########################################################################
+// This file is part of LImA, a Library for Image Acquisition
+//
+// Copyright (C) : 2009-2026
+// European Synchrotron Radiation Facility
+// CS40220 38043 Grenoble Cedex 9 
+// FRANCE
+//
+// Contact: lima@esrf.fr
+//
+// This is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This software is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//###########################################################################
+
+// HDR merge without camera: bracketed exposures are built by hand.
+
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include "lima/Exceptions.h"
+#include "BaslerHdrMerge.h"
+
+using namespace lima;
+using namespace lima::Basler;
+
+static int nb_errors = 0;
+
+#define CHECK(cond)							\
+  if(!(cond))								\
+    {									\
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #cond " failed" << std::endl; \
+      ++nb_errors;							\
+    }
+
+#define CHECK_THROW(expr)						\
+  {									\
+    bool thrown = false;						\
+    try { expr; } catch(Exception&) { thrown = true; }			\
+    CHECK(thrown);							\
+  }
+
+//- unsaturated, partly and fully saturated pixels in float
+static void test_saturation()
+{
+  HdrMerge merge;
+  merge.prepare(Bpp16,Bpp32F,4,{1e-3,4e-3},1000.);
+  CHECK(merge.getNbExposures() == 2);
+
+  uint16_t short_exp[] = {100,300,1000,0};
+  uint16_t long_exp[] = {400,1000,1000,0};
+  merge.accumulate(0,short_exp);
+  merge.accumulate(1,long_exp);
+  float dst[4];
+  merge.merge(dst);
+  CHECK(std::fabs(dst[0] - 400.f) < 1e-3);	// (100 + 400) * 4 / 5
+  CHECK(std::fabs(dst[1] - 1200.f) < 1e-3);	// short exposure only, scaled
+  CHECK(std::fabs(dst[2] - 4000.f) < 1e-3);	// saturation * 4 / 1
+  CHECK(dst[3] == 0.f);
+}
+
+//- integer output is rounded, the saturation defaults to full scale
+static void test_integer_output()
+{
+  HdrMerge merge;
+  merge.prepare(Bpp8,Bpp32,3,{1.,2.},0.);
+
+  uint8_t short_exp[] = {10,200,255};
+  uint8_t long_exp[] = {21,255,255};
+  merge.accumulate(0,short_exp);
+  merge.accumulate(1,long_exp);
+  uint32_t dst[3];
+  merge.merge(dst);
+  CHECK(dst[0] == 21);				// 31 * 2 / 3 = 20.67
+  CHECK(dst[1] == 400);
+  CHECK(dst[2] == 510);
+}
+
+//- a new group starts from zero
+static void test_reset()
+{
+  HdrMerge merge;
+  merge.prepare(Bpp12,Bpp32F,2,{1.,1.,2.},0.);
+
+  uint16_t group1[] = {4000,100};
+  for(int i = 0;i < 3;++i)
+    merge.accumulate(i,group1);
+  merge.reset();
+  uint16_t group2[][2] = {{10,20},{10,20},{20,40}};
+  for(int i = 0;i < 3;++i)
+    merge.accumulate(i,group2[i]);
+  float dst[2];
+  merge.merge(dst);
+  CHECK(std::fabs(dst[0] - 20.f) < 1e-4);
+  CHECK(std::fabs(dst[1] - 40.f) < 1e-4);
+}
+
+static void test_invalid()
+{
+  HdrMerge merge;
+  CHECK_THROW(merge.prepare(Bpp16,Bpp32F,1,{1.},0.));
+  CHECK_THROW(merge.prepare(Bpp16,Bpp16,1,{1.,2.},0.));
+  CHECK_THROW(merge.prepare(Bpp32,Bpp32F,1,{1.,2.},0.));
+  CHECK_THROW(merge.prepare(Bpp16,Bpp32F,1,{1.,0.},0.));
+  merge.prepare(Bpp16,Bpp32F,1,{1.,2.},0.);
+  uint16_t src[] = {0};
+  CHECK_THROW(merge.accumulate(2,src));
+}
+
+int main()
+{
+  test_saturation();
+  test_integer_output();
+  test_reset();
+  test_invalid();
+  if(nb_errors)
+    std::cerr << nb_errors << " check(s) failed" << std::endl;
+  return nb_errors ? 1 : 0;
+}